@@ -0,0 +1,409 @@
+// Headless canvas primitive benchmark: canvas_clear, canvas_fill_rect and
+// canvas_copy against the per-pixel loops they replaced, for every fill the
+// build and CPU have (canvas_ops.h), and prints JSON.
+//
+//   ./bench_canvas [--width N] [--height N] [--runs N] [--isa NAME]
+//                  [--check] [--out FILE]
+//
+// gb_s is pixel bytes written per second at the median time (ref_gb_s the
+// replaced loop's), e.g. a full-screen clear writes width * height * 4.
+// "cells" fills the canvas in 6x6 rectangles like the minimap does; the
+// copies are full-screen (row->row, col->col) and a 256x256 overlay at
+// (8,8) like the minimap's. --isa times one fill only (default: all).
+// --check compares every fill against the replaced loops on random sizes,
+// layouts, clips and alignments instead, and strided views (canvas_view)
+// against packed canvases, and canvas_composite of a few tracked draws
+// against a full canvas_copy_scaled; it exits 1 on a mismatch.
+#include "canvas.h"
+#include "canvas_ops.h"
+#include "bench_util.h"
+
+#ifndef BENCH_CANVAS_CHECKS
+#define BENCH_CANVAS_CHECKS 20000   // random cases per fill for --check
+#endif
+
+static const char* const ISAS[] = { "avx2", "sse2", "neon", "wasm-simd128", "scalar" };
+#define ISA_COUNT (sizeof(ISAS) / sizeof(ISAS[0]))
+
+typedef struct BenchOpts {
+    int         width, height;
+    int         runs;
+    int         check;
+    const char* isa;        // NULL = every available fill
+    const char* out_path;
+} BenchOpts;
+
+// ---------------- The loops canvas_ops replaced ----------------
+static void ref_clear(Canvas* c, Color col) {
+    uint32_t* px = c->px;
+    uint32_t v = color_to_u32(col);
+    for (int i = 0; i < c->w * c->h; ++i) px[i] = v;
+}
+
+static void ref_fill_rect(Canvas* c, int x, int y, int w, int h, Color col) {
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + w; if (x1 > c->w) x1 = c->w;
+    int y1 = y + h; if (y1 > c->h) y1 = c->h;
+    uint32_t v = color_to_u32(col);
+    uint32_t* px = c->px;
+    if (c->layout == CANVAS_COL_MAJOR) {
+        for (int xx = x0; xx < x1; ++xx) {
+            uint32_t* col_px = px + (size_t)xx * c->h;
+            for (int yy = y0; yy < y1; ++yy) col_px[yy] = v;
+        }
+        return;
+    }
+    for (int yy = y0; yy < y1; ++yy) {
+        uint32_t* row = px + yy * c->w;
+        for (int xx = x0; xx < x1; ++xx) row[xx] = v;
+    }
+}
+
+// (the column-major -> row-major transpose is unchanged: plain loop here)
+static void ref_copy(Canvas* dst, const Canvas* src, int dx, int dy) {
+    if (src->layout != CANVAS_ROW_MAJOR || dst->layout != CANVAS_ROW_MAJOR) {
+        int x0 = dx < 0 ? -dx : 0, y0 = dy < 0 ? -dy : 0;
+        int x1 = src->w, y1 = src->h;
+        if (x1 > dst->w - dx) x1 = dst->w - dx;
+        if (y1 > dst->h - dy) y1 = dst->h - dy;
+        for (int x = x0; x < x1; ++x)
+            for (int y = y0; y < y1; ++y)
+                dst->px[canvas_index(dst, x + dx, y + dy)] = src->px[canvas_index(src, x, y)];
+        return;
+    }
+    for (int y = 0; y < src->h; ++y) {
+        int ty = y + dy;
+        if ((unsigned)ty >= (unsigned)dst->h) continue;
+        for (int x = 0; x < src->w; ++x) {
+            int tx = x + dx;
+            if ((unsigned)tx >= (unsigned)dst->w) continue;
+            dst->px[ty * dst->w + tx] = src->px[y * src->w + x];
+        }
+    }
+}
+
+// ---------------- --check ----------------
+static uint32_t rnd(uint32_t* s) {
+    *s = *s * 1664525u + 1013904223u;
+    return *s >> 8;
+}
+
+static int rnd_in(uint32_t* s, int lo, int hi) {   // [lo, hi]
+    return lo + (int)(rnd(s) % (uint32_t)(hi - lo + 1));
+}
+
+static Color rnd_color(uint32_t* s) {
+    uint32_t r = rnd(s);
+    return rgba((uint8_t)r, (uint8_t)(r >> 8), (uint8_t)(r >> 16), 255);
+}
+
+static int make(Canvas* c, int w, int h, CanvasLayout layout) {
+    return layout == CANVAS_COL_MAJOR ? canvas_init_transposed(c, w, h) : canvas_init_heap(c, w, h);
+}
+
+static void scribble(Canvas* c, uint32_t* s) {
+    for (size_t i = 0; i < (size_t)c->w * (size_t)c->h; ++i) c->px[i] = rnd(s);
+}
+
+static int same(const Canvas* a, const Canvas* b) {
+    return memcmp(a->px, b->px, (size_t)a->w * (size_t)a->h * sizeof(uint32_t)) == 0;
+}
+
+// One random case: a canvas in both versions, one operation on each.
+static int check_case(uint32_t* s, int i) {
+    int w = rnd_in(s, 1, 97), h = rnd_in(s, 1, 97);
+    CanvasLayout layout = (CanvasLayout)(rnd(s) & 1);
+    Canvas a, b, src;
+    memset(&src, 0, sizeof(src));
+    if (make(&a, w, h, layout) != 0 || make(&b, w, h, layout) != 0) return -1;
+    scribble(&a, s);
+    memcpy(b.px, a.px, (size_t)w * (size_t)h * sizeof(uint32_t));
+    const char* op = "clear";
+    int x = rnd_in(s, -40, w + 8), y = rnd_in(s, -40, h + 8);
+    int rw = rnd_in(s, -2, 120), rh = rnd_in(s, -2, 120);
+    switch (i % 3) {
+    case 0: {
+        Color col = rnd_color(s);
+        canvas_clear(&a, col);
+        ref_clear(&b, col);
+        break;
+    }
+    case 1: {
+        Color col = rnd_color(s);
+        op = "fill_rect";
+        canvas_fill_rect(&a, x, y, rw, rh, col);
+        ref_fill_rect(&b, x, y, rw, rh, col);
+        break;
+    }
+    default:
+        op = "copy";
+        if (make(&src, rnd_in(s, 1, 120), rnd_in(s, 1, 120), (CanvasLayout)(rnd(s) & 1)) != 0) return -1;
+        scribble(&src, s);
+        canvas_copy(&a, &src, x, y);
+        ref_copy(&b, &src, x, y);
+        break;
+    }
+    int ok = same(&a, &b);
+    if (!ok)
+        fprintf(stderr, "check: %s: %s on %dx%d %s (x %d, y %d, w %d, h %d) differs\n",
+                canvas_ops_isa(), op, w, h, layout == CANVAS_COL_MAJOR ? "col" : "row", x, y, rw, rh);
+    canvas_destroy(&a);
+    canvas_destroy(&b);
+    canvas_destroy(&src);
+    return ok ? 0 : -1;
+}
+
+// A view behaves like a packed canvas of its own, and leaves the rest of
+// its parent alone: the same operation on a view and on a packed copy of it.
+static int check_view(uint32_t* s, int i) {
+    int w = rnd_in(s, 1, 97), h = rnd_in(s, 1, 97);
+    CanvasLayout layout = (CanvasLayout)(rnd(s) & 1);
+    int vx = rnd_in(s, -20, w), vy = rnd_in(s, -20, h);
+    int vw = rnd_in(s, 0, 80), vh = rnd_in(s, 0, 80);
+    Canvas parent, before, packed, src;
+    memset(&src, 0, sizeof(src));
+    if (make(&parent, w, h, layout) != 0 || make(&before, w, h, layout) != 0) return -1;
+    scribble(&parent, s);
+    memcpy(before.px, parent.px, (size_t)w * (size_t)h * sizeof(uint32_t));
+    Canvas view = canvas_view(&parent, vx, vy, vw, vh);
+    int x0 = vx < 0 ? 0 : vx, y0 = vy < 0 ? 0 : vy;
+    if (make(&packed, view.w > 0 ? view.w : 1, view.h > 0 ? view.h : 1, layout) != 0) return -1;
+    for (int y = 0; y < view.h; ++y)
+        for (int x = 0; x < view.w; ++x) packed.px[canvas_index(&packed, x, y)] = view.px[canvas_index(&view, x, y)];
+    packed.w = view.w;
+    packed.h = view.h;
+    int x = rnd_in(s, -40, 90), y = rnd_in(s, -40, 90);
+    int rw = rnd_in(s, -2, 120), rh = rnd_in(s, -2, 120);
+    Color col = rnd_color(s);
+    switch (i % 3) {
+    case 0: canvas_clear(&view, col); canvas_clear(&packed, col); break;
+    case 1: canvas_fill_rect(&view, x, y, rw, rh, col); canvas_fill_rect(&packed, x, y, rw, rh, col); break;
+    default:
+        if (make(&src, rnd_in(s, 1, 120), rnd_in(s, 1, 120), (CanvasLayout)(rnd(s) & 1)) != 0) return -1;
+        scribble(&src, s);
+        canvas_copy(&view, &src, x, y);
+        canvas_copy(&packed, &src, x, y);
+        break;
+    }
+    int ok = 1;
+    for (int py = 0; ok && py < h; ++py)
+        for (int px = 0; ok && px < w; ++px) {
+            int in = px >= x0 && px < x0 + view.w && py >= y0 && py < y0 + view.h;
+            uint32_t want = in ? packed.px[canvas_index(&packed, px - x0, py - y0)]
+                               : before.px[canvas_index(&before, px, py)];
+            ok = parent.px[canvas_index(&parent, px, py)] == want;
+        }
+    if (!ok)
+        fprintf(stderr, "check: %s: op %d on view (%d,%d %dx%d) of %dx%d %s differs\n",
+                canvas_ops_isa(), i % 3, vx, vy, vw, vh, w, h, layout == CANVAS_COL_MAJOR ? "col" : "row");
+    canvas_destroy(&parent);
+    canvas_destroy(&before);
+    canvas_destroy(&packed);
+    canvas_destroy(&src);
+    return ok ? 0 : -1;
+}
+
+// After a few tracked draws into src, compositing only what they marked
+// leaves dst exactly as a full rescale of src would.
+static int check_composite(uint32_t* s, int i) {
+    int sw = rnd_in(s, 1, 97), sh = rnd_in(s, 1, 97);
+    int dx = rnd_in(s, -10, 10), dy = rnd_in(s, -10, 10);
+    int dw = i % 2 ? sw : rnd_in(s, 1, 150), dh = i % 2 ? sh : rnd_in(s, 1, 150);
+    CanvasLayout layout = (CanvasLayout)(rnd(s) & 1);
+    Canvas src, dst, want;
+    CanvasDirty d;
+    if (make(&src, sw, sh, layout) != 0 || make(&dst, 160, 160, CANVAS_ROW_MAJOR) != 0
+        || make(&want, 160, 160, CANVAS_ROW_MAJOR) != 0) return -1;
+    scribble(&src, s);
+    scribble(&dst, s);
+    canvas_copy_scaled(&dst, &src, dx, dy, dw, dh);
+    canvas_dirty_reset(&d);
+    src.dirty = &d;
+    for (int k = rnd_in(s, 0, 40); k > 0; --k) {
+        int x = rnd_in(s, -10, sw), y = rnd_in(s, -10, sh);
+        int w = rnd_in(s, 0, 30), h = rnd_in(s, 0, 30);
+        Canvas view = canvas_view(&src, rnd_in(s, -5, sw), rnd_in(s, -5, sh), rnd_in(s, 0, 40), rnd_in(s, 0, 40));
+        switch (rnd(s) % 3) {
+        case 0:  canvas_put(&src, x, y, rnd_color(s)); break;
+        case 1:  canvas_fill_rect(&src, x, y, w, h, rnd_color(s)); break;
+        default: canvas_fill_rect(&view, x, y, w, h, rnd_color(s)); break;
+        }
+    }
+    memcpy(want.px, dst.px, (size_t)160 * 160 * sizeof(uint32_t));
+    canvas_copy_scaled(&want, &src, dx, dy, dw, dh);
+    canvas_composite(&dst, &src, &d, dx, dy, dw, dh);
+    int ok = same(&dst, &want) && d.n == 0;
+    if (!ok)
+        fprintf(stderr, "check: %s: composite of %dx%d %s onto (%d,%d %dx%d) differs\n",
+                canvas_ops_isa(), sw, sh, layout == CANVAS_COL_MAJOR ? "col" : "row", dx, dy, dw, dh);
+    canvas_destroy(&src);
+    canvas_destroy(&dst);
+    canvas_destroy(&want);
+    return ok ? 0 : -1;
+}
+
+// Spans at every alignment and length, with guard pixels around them.
+static int check_spans(void) {
+    enum { MAXN = 300, GUARD = 16 };
+    static uint32_t buf[GUARD + 16 + MAXN + GUARD];
+    for (int off = 0; off < 16; ++off)
+        for (int n = 0; n <= MAXN; ++n) {
+            for (size_t i = 0; i < sizeof(buf) / sizeof(buf[0]); ++i) buf[i] = 0xdeadbeefu;
+            canvas_ops_fill(buf + GUARD + off, (size_t)n, 0x01020304u);
+            for (int i = 0; i < (int)(sizeof(buf) / sizeof(buf[0])); ++i) {
+                int in = i >= GUARD + off && i < GUARD + off + n;
+                if (buf[i] != (in ? 0x01020304u : 0xdeadbeefu)) {
+                    fprintf(stderr, "check: %s: span of %d at +%d wrong at %d\n",
+                            canvas_ops_isa(), n, off, i - GUARD - off);
+                    return -1;
+                }
+            }
+        }
+    return 0;
+}
+
+static int run_checks(void) {
+    int failed = 0;
+    for (size_t k = 0; k < ISA_COUNT; ++k) {
+        if (canvas_ops_select(ISAS[k]) != 0) continue;
+        uint32_t s = 12345;
+        int bad = check_spans() != 0;
+        for (int i = 0; !bad && i < BENCH_CANVAS_CHECKS; ++i) bad = check_case(&s, i) != 0 || check_view(&s, i) != 0
+                                                              || check_composite(&s, i) != 0;
+        fprintf(stderr, "check: %s: %s\n", ISAS[k], bad ? "FAILED" : "ok");
+        failed |= bad;
+    }
+    canvas_ops_select(NULL);
+    return failed ? 1 : 0;
+}
+
+// ---------------- Timing ----------------
+typedef enum { OP_CLEAR, OP_FILL, OP_CELLS, OP_COPY, OP_OVERLAY } Op;
+
+typedef struct Case {
+    const char*  name;
+    Op           op;
+    CanvasLayout layout;    // of the canvas written (and of the full-screen copy's source)
+} Case;
+
+static const Case CASES[] = {
+    { "clear",          OP_CLEAR,   CANVAS_ROW_MAJOR },
+    { "fill_rect",      OP_FILL,    CANVAS_ROW_MAJOR },
+    { "fill_rect_col",  OP_FILL,    CANVAS_COL_MAJOR },
+    { "cells",          OP_CELLS,   CANVAS_ROW_MAJOR },
+    { "copy",           OP_COPY,    CANVAS_ROW_MAJOR },
+    { "copy_col",       OP_COPY,    CANVAS_COL_MAJOR },
+    { "copy_overlay",   OP_OVERLAY, CANVAS_ROW_MAJOR },
+};
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+// Runs the case once (the new code, or the replaced loop); returns the
+// pixel bytes written.
+static size_t run_case(const Case* c, Canvas* dst, const Canvas* src, const Canvas* overlay, int ref) {
+    Color col = rgba(30, 30, 30, 255);
+    switch (c->op) {
+    case OP_CLEAR:
+        if (ref) ref_clear(dst, col); else canvas_clear(dst, col);
+        return (size_t)dst->w * (size_t)dst->h * 4;
+    case OP_FILL:
+        if (ref) ref_fill_rect(dst, 1, 1, dst->w - 2, dst->h - 2, col);
+        else     canvas_fill_rect(dst, 1, 1, dst->w - 2, dst->h - 2, col);
+        return (size_t)(dst->w - 2) * (size_t)(dst->h - 2) * 4;
+    case OP_CELLS:
+        for (int y = 0; y < dst->h; y += 6)
+            for (int x = 0; x < dst->w; x += 6) {
+                Color cc = ((x ^ y) & 8) ? rgba(220, 220, 220, 255) : col;
+                if (ref) ref_fill_rect(dst, x, y, 6, 6, cc); else canvas_fill_rect(dst, x, y, 6, 6, cc);
+            }
+        return (size_t)dst->w * (size_t)dst->h * 4;
+    case OP_COPY:
+        if (ref) ref_copy(dst, src, 0, 0); else canvas_copy(dst, src, 0, 0);
+        return (size_t)dst->w * (size_t)dst->h * 4;
+    case OP_OVERLAY:
+        if (ref) ref_copy(dst, overlay, 8, 8); else canvas_copy(dst, overlay, 8, 8);
+        return (size_t)overlay->w * (size_t)overlay->h * 4;
+    }
+    return 0;
+}
+
+static double time_case(const BenchOpts* o, const Case* c, Canvas* dst, const Canvas* src,
+                        const Canvas* overlay, int ref, uint64_t* ns, size_t* bytes) {
+    for (int r = 0; r < 3; ++r) run_case(c, dst, src, overlay, ref);   // warm up
+    for (int r = 0; r < o->runs; ++r) {
+        uint64_t t0 = bench_now_ns();
+        *bytes = run_case(c, dst, src, overlay, ref);
+        ns[r] = bench_now_ns() - t0;
+    }
+    return bench_stats(ns, (size_t)o->runs).median;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--width N] [--height N] [--runs N] [--isa NAME] [--check] [--out FILE]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    BenchOpts o = { 1920, 1080, 200, 0, NULL, NULL };
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if      (!strcmp(a, "--width") && v)  { o.width = atoi(v); ++i; }
+        else if (!strcmp(a, "--height") && v) { o.height = atoi(v); ++i; }
+        else if (!strcmp(a, "--runs") && v)   { o.runs = atoi(v); ++i; }
+        else if (!strcmp(a, "--isa") && v)    { o.isa = v; ++i; }
+        else if (!strcmp(a, "--check"))       { o.check = 1; }
+        else if (!strcmp(a, "--out") && v)    { o.out_path = v; ++i; }
+        else { usage(argv[0]); return 2; }
+    }
+    if (o.check) return run_checks();
+    if (o.width < 16 || o.height < 16 || o.runs <= 0) { usage(argv[0]); return 2; }
+    if (o.isa && canvas_ops_select(o.isa) != 0) {
+        fprintf(stderr, "%s: no such fill in this build or CPU\n", o.isa);
+        return 2;
+    }
+
+    FILE* out = stdout;
+    if (o.out_path && !(out = fopen(o.out_path, "w"))) { perror(o.out_path); return 1; }
+    uint64_t* ns = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.runs);
+    Canvas rows, cols, rows_src, cols_src, overlay;
+    int ov = o.width - 8 < 256 ? o.width - 8 : 256;
+    if (o.height - 8 < ov) ov = o.height - 8;
+    if (!ns || canvas_init_heap(&rows, o.width, o.height) != 0
+            || canvas_init_transposed(&cols, o.width, o.height) != 0
+            || canvas_init_heap(&rows_src, o.width, o.height) != 0
+            || canvas_init_transposed(&cols_src, o.width, o.height) != 0
+            || canvas_init_heap(&overlay, ov, ov) != 0) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    fprintf(out, "{\n  \"bench\": \"canvas\", \"width\": %d, \"height\": %d, \"runs\": %d, \"startup_isa\": \"%s\",\n"
+                 "  \"results\": [\n", o.width, o.height, o.runs, canvas_ops_isa());
+    int first = 1;
+    for (size_t k = 0; k < ISA_COUNT; ++k) {
+        if (o.isa ? strcmp(o.isa, ISAS[k]) != 0 : canvas_ops_select(ISAS[k]) != 0) continue;
+        for (size_t i = 0; i < CASE_COUNT; ++i) {
+            const Case* c = &CASES[i];
+            Canvas* dst = c->layout == CANVAS_COL_MAJOR ? &cols : &rows;
+            const Canvas* src = c->layout == CANVAS_COL_MAJOR ? &cols_src : &rows_src;
+            size_t bytes = 0;
+            double t = time_case(&o, c, dst, src, &overlay, 0, ns, &bytes);
+            double t_ref = time_case(&o, c, dst, src, &overlay, 1, ns, &bytes);
+            fprintf(out, "%s    {\"op\": \"%s\", \"isa\": \"%s\", \"bytes\": %zu, \"median_ns\": %.0f, \"gb_s\": %.2f, "
+                         "\"ref_median_ns\": %.0f, \"ref_gb_s\": %.2f, \"speedup\": %.2f}",
+                    first ? "" : ",\n", c->name, ISAS[k], bytes, t, (double)bytes / t,
+                    t_ref, (double)bytes / t_ref, t_ref / t);
+            first = 0;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    canvas_destroy(&rows);
+    canvas_destroy(&cols);
+    canvas_destroy(&rows_src);
+    canvas_destroy(&cols_src);
+    canvas_destroy(&overlay);
+    free(ns);
+    if (out != stdout) fclose(out);
+    return 0;
+}
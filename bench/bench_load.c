@@ -0,0 +1,325 @@
+// Headless level-load benchmark: opening a .cub3d source the way the game
+// does without a compiled level (parse, chunk, build the traversal
+// structures) against mapping the compiled .cub3db, and prints JSON.
+//
+//   ./bench_load [--runs N] [--gen N] [--kind open|pillars|maze|corridors]
+//                [--stream MiB] [--tmp DIR] [--maps DIR] [--out FILE]
+//
+// Every level in --maps is compiled into --tmp first, like cub3dc does.
+// --gen N also writes an N x N source there (map_gen.h, --kind: open by
+// default, with ~1% scattered walls; rows of 2N bytes). parse_ns parses the file (map_parse_cub3d_file),
+// parse_text_ns the same text from memory (map_parse_cub3d); both are also
+// given as parse_mb_s / parse_text_mb_s. open_ns maps the file and checks the header; verify_ns also
+// hashes the payload; first_touch_ns reads every tile of the mapping once
+// (the page faults a frame pays instead of the loader). The page cache is
+// warm for both sides: this measures the loader, not the disk.
+// --stream MiB (0 = off) also streams every chunked level through a tile
+// cache that size (map_stream.h) along a scripted walk of
+// BENCH_STREAM_FRAMES frames, reporting the per-frame update time, cache
+// hits and misses, prefetch accuracy and peak resident tile bytes. Every
+// BENCH_STREAM_CHECK_EVERY frames it also casts BENCH_STREAM_CHECK_RAYS
+// columns both scalar and packet (raycast_dda.h) and counts the rays whose
+// hit differs in stream_cast_mismatches (should be 0).
+#include "map.h"
+#include "map_bin.h"
+#include "map_dist.h"
+#include "map_gen.h"
+#include "map_occ.h"
+#include "map_stream.h"
+#include "raycast_dda.h"
+#include "bench_util.h"
+#include <math.h>
+#include <sys/stat.h>
+
+#ifndef BENCH_DIST_MAX_CELLS
+#define BENCH_DIST_MAX_CELLS (2048 * 2048)      // as GAME_SCENE_DIST_MAX_CELLS
+#endif
+#ifndef BENCH_CHUNK_MIN_CELLS
+#define BENCH_CHUNK_MIN_CELLS (1024 * 1024)     // as GAME_SCENE_CHUNK_MIN_CELLS
+#endif
+#ifndef BENCH_STREAM_FRAMES
+#define BENCH_STREAM_FRAMES 2000
+#endif
+#ifndef BENCH_STREAM_CHECK_EVERY
+#define BENCH_STREAM_CHECK_EVERY 16
+#endif
+#ifndef BENCH_STREAM_CHECK_RAYS
+#define BENCH_STREAM_CHECK_RAYS 320
+#endif
+
+typedef struct BenchOpts {
+    int         runs;
+    int         gen_n;      // > 0: add a generated source this size
+    MapGenKind  kind;       // ... made by this generator
+    int         stream_mib; // > 0: stream chunked levels through this cache
+    const char* tmp_dir;
+    const char* maps_dir;
+    const char* out_path;
+} BenchOpts;
+
+static char* path_in(const char* dir, const char* name) {
+    size_t n = strlen(dir) + strlen(name) + 2;
+    char* p = (char*)malloc(n);
+    if (p) snprintf(p, n, "%s/%s", dir, name);
+    return p;
+}
+
+static size_t file_bytes(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+static int write_source(const char* path, int n, MapGenKind kind) {
+    // open: ~1% walls, ids 1-4
+    MapGenConfig gc = { kind, n, n, 0x5EEDu, kind == MAP_GEN_OPEN ? 655 : -1, 4 };
+    uint8_t* rows = map_gen(&gc);
+    int rc = rows ? map_gen_write_cub3d(path, rows, n, n, NULL) : -1;
+    free(rows);
+    return rc;
+}
+
+// What load_map does with a source: parse, chunk when big, build occupancy
+// and (up to the cap) the distance field.
+typedef struct Loaded {
+    GridMap map;
+    uint8_t* data;
+    MapDist dist;
+    MapOcc  occ;
+} Loaded;
+
+static int load_source(const char* path, Loaded* l) {
+    memset(l, 0, sizeof(*l));
+    int w = 0, h = 0; char* err = NULL;
+    if (map_parse_cub3d_file(path, &l->data, &w, &h, &err) != 0) {
+        fprintf(stderr, "skipping '%s': %s\n", path, err ? err : "parse error");
+        free(err);
+        return -1;
+    }
+    MapLayout layout = MAP_LAYOUT_ROWS;
+    if ((size_t)w * (size_t)h >= BENCH_CHUNK_MIN_CELLS) {
+        uint8_t* c = map_convert_layout(l->data, MAP_LAYOUT_ROWS, MAP_LAYOUT_CHUNKED, w, h);
+        if (c) { free(l->data); l->data = c; layout = MAP_LAYOUT_CHUNKED; }
+    }
+    l->map = (GridMap){ .w = w, .h = h, .layout = layout, .data = l->data };
+    if (map_occ_build(&l->occ, &l->map) == 0) l->map.occ = &l->occ;
+    if ((size_t)w * (size_t)h <= BENCH_DIST_MAX_CELLS && map_dist_build(&l->dist, &l->map) == 0)
+        l->map.dist = l->dist.d;
+    return 0;
+}
+
+static void loaded_free(Loaded* l) {
+    free(l->data);
+    map_dist_free(&l->dist);
+    map_occ_free(&l->occ);
+}
+
+// Rays of a BENCH_STREAM_CHECK_RAYS wide view whose scalar and packet casts
+// end on a different cell, side or distance. Tile ids are not compared: a
+// prefetch may land between the two casts and replace a placeholder.
+static uint64_t stream_cast_mismatches(const GridMap* m, const Camera* cam) {
+    uint64_t bad = 0;
+    for (int x = 0; x < BENCH_STREAM_CHECK_RAYS; x += RAY_PACKET_MAX) {
+        int n = BENCH_STREAM_CHECK_RAYS - x < RAY_PACKET_MAX ? BENCH_STREAM_CHECK_RAYS - x : RAY_PACKET_MAX;
+        RayPacket a, b;
+        ray_packet_setup(&a, cam, x, n, BENCH_STREAM_CHECK_RAYS);
+        b = a;
+        ray_packet_cast_scalar(&a, m);
+        ray_packet_cast_simd(&b, m);
+        for (int i = 0; i < n; ++i)
+            bad += a.mapX[i] != b.mapX[i] || a.mapY[i] != b.mapY[i] || a.side[i] != b.side[i]
+                || a.perpDist[i] != b.perpDist[i];
+    }
+    return bad;
+}
+
+// Walk 'bin' streamed: forward at 0.25 cells a frame while turning slowly,
+// turning back at the edges. Prints the stream fields of the result.
+static void bench_stream(FILE* out, const BenchOpts* o, const char* bin) {
+    MapStreamConfig cfg = { (size_t)o->stream_mib << 20, 16384, 64, 512, true };
+    char* err = NULL;
+    uint64_t* frame_ns = (uint64_t*)malloc(sizeof(uint64_t) * BENCH_STREAM_FRAMES);
+    uint64_t t0 = bench_now_ns();
+    MapStream* s = frame_ns ? map_stream_open(bin, &cfg, &err) : NULL;
+    uint64_t open_ns = bench_now_ns() - t0;
+    if (!s) {
+        fprintf(stderr, "not streamed: %s\n", err ? err : "out of memory");
+        free(err);
+        free(frame_ns);
+        return;
+    }
+    GridMap m = map_stream_map(s);
+    Camera cam = { .pos = { m.w * 0.5f, m.h * 0.5f } };
+    float a = 0.0f;
+    uint64_t rays = 0, mismatches = 0;
+    for (int f = 0; f < BENCH_STREAM_FRAMES; ++f) {
+        cam.dir = (Vec2f){ cosf(a), sinf(a) };
+        cam.plane = (Vec2f){ -cam.dir.y * 0.66f, cam.dir.x * 0.66f };
+        Vec2f next = { cam.pos.x + cam.dir.x * 0.25f, cam.pos.y + cam.dir.y * 0.25f };
+        if (next.x < 2.0f || next.y < 2.0f || next.x > m.w - 2.0f || next.y > m.h - 2.0f) a += 3.14159265f;
+        else cam.pos = next;
+        a += 0.002f;
+        t0 = bench_now_ns();
+        map_stream_update(s, &cam);
+        frame_ns[f] = bench_now_ns() - t0;
+        if (f % BENCH_STREAM_CHECK_EVERY == 0) {
+            mismatches += stream_cast_mismatches(&m, &cam);
+            rays += BENCH_STREAM_CHECK_RAYS;
+        }
+    }
+    if (mismatches)
+        fprintf(stderr, "%s: %llu of %llu streamed rays differ between the scalar and packet casts\n", bin,
+                (unsigned long long)mismatches, (unsigned long long)rays);
+    BenchStats us = bench_stats(frame_ns, BENCH_STREAM_FRAMES);
+    MapStreamStats st = map_stream_stats(s);
+    fprintf(out, ",\n      \"stream_open_ns\": %llu, ", (unsigned long long)open_ns);
+    bench_json_stats(out, "stream_update_ns", us, 1.0);
+    fprintf(out, ",\n      \"stream_hits\": %llu, \"stream_misses\": %llu, \"prefetched\": %llu,"
+                 " \"prefetch_accuracy\": %.3f, \"evictions\": %llu, \"peak_resident_bytes\": %zu,"
+                 " \"tile_bytes\": %zu, \"stream_cast_mismatches\": %llu",
+            (unsigned long long)st.hits, (unsigned long long)st.misses, (unsigned long long)st.prefetched,
+            st.prefetch_accuracy, (unsigned long long)st.evictions, st.peak_resident_bytes,
+            map_stream_tile_bytes(s), (unsigned long long)mismatches);
+    free(frame_ns);
+    map_stream_close(s);
+}
+
+static void bench_level(FILE* out, const BenchOpts* o, const char* name, const char* src, uint64_t* ns,
+                        int* first) {
+    Loaded l;
+    if (load_source(src, &l) != 0) return;
+    char* bin = path_in(o->tmp_dir, "bench_load.cub3db");
+    char* err = NULL;
+    if (!bin || map_bin_write(bin, &l.map, l.map.dist ? &l.dist : NULL, &l.occ, &err) != 0) {
+        fprintf(stderr, "'%s': %s\n", name, err ? err : "out of memory");
+        free(err); free(bin); loaded_free(&l);
+        return;
+    }
+    int w = l.map.w, h = l.map.h;
+    bool chunked = l.map.layout == MAP_LAYOUT_CHUNKED;
+    loaded_free(&l);
+
+    BenchStats parse, text_parse, source, mapped[3];   // open, verify, first touch
+    for (int r = 0; r < o->runs; ++r) {
+        uint8_t* data = NULL; int pw, ph;
+        uint64_t t0 = bench_now_ns();
+        if (map_parse_cub3d_file(src, &data, &pw, &ph, NULL) == 0) free(data);
+        ns[r] = bench_now_ns() - t0;
+    }
+    parse = bench_stats(ns, (size_t)o->runs);
+    size_t src_bytes = file_bytes(src);
+    char* text = (char*)malloc(src_bytes ? src_bytes : 1);
+    FILE* f = text ? fopen(src, "rb") : NULL;
+    size_t got = f ? fread(text, 1, src_bytes, f) : 0;
+    if (f) fclose(f);
+    for (int r = 0; r < o->runs; ++r) {
+        uint8_t* data = NULL; int pw, ph;
+        uint64_t t0 = bench_now_ns();
+        if (map_parse_cub3d(text, got, &data, &pw, &ph, NULL) == 0) free(data);
+        ns[r] = bench_now_ns() - t0;
+    }
+    text_parse = bench_stats(ns, (size_t)o->runs);
+    free(text);
+    for (int r = 0; r < o->runs; ++r) {
+        uint64_t t0 = bench_now_ns();
+        if (load_source(src, &l) == 0) loaded_free(&l);
+        ns[r] = bench_now_ns() - t0;
+    }
+    source = bench_stats(ns, (size_t)o->runs);
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int r = 0; r < o->runs; ++r) {
+            MapBin b;
+            uint64_t t0 = bench_now_ns();
+            if (map_bin_open(&b, bin, pass == 1, NULL) != 0) { ns[r] = 0; continue; }
+            if (pass == 2) {
+                t0 = bench_now_ns();
+                volatile unsigned sum = 0;
+                size_t n = map_layout_bytes(b.map.layout, w, h);
+                for (size_t i = 0; i < n; i += 4096) sum += b.map.data[i];
+            }
+            ns[r] = bench_now_ns() - t0;
+            map_bin_close(&b);
+        }
+        mapped[pass] = bench_stats(ns, (size_t)o->runs);
+    }
+
+    if (!*first) fprintf(out, ",\n");
+    *first = 0;
+    fprintf(out, "    {\"map\": ");
+    bench_json_str(out, name);
+    fprintf(out, ", \"map_w\": %d, \"map_h\": %d, \"source_bytes\": %zu, \"bin_bytes\": %zu,\n      ",
+            w, h, src_bytes, file_bytes(bin));
+    bench_json_stats(out, "parse_ns", parse, 1.0);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "parse_text_ns", text_parse, 1.0);
+    fprintf(out, ",\n      \"parse_mb_s\": %.1f, \"parse_text_mb_s\": %.1f,\n      ",
+            parse.median > 0 ? (double)src_bytes * 1e3 / parse.median : 0.0,
+            text_parse.median > 0 ? (double)got * 1e3 / text_parse.median : 0.0);
+    bench_json_stats(out, "source_load_ns", source, 1.0);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "open_ns", mapped[0], 1.0);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "verify_ns", mapped[1], 1.0);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "first_touch_ns", mapped[2], 1.0);
+    fprintf(out, ",\n      \"speedup\": %.0f", mapped[0].median > 0 ? source.median / mapped[0].median : 0.0);
+    if (o->stream_mib > 0 && chunked) bench_stream(out, o, bin);
+    fprintf(out, "}");
+    remove(bin);
+    free(bin);
+}
+
+static int cmp_str(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--runs N] [--gen N] [--kind open|pillars|maze|corridors] [--stream MiB] [--tmp DIR] [--maps DIR] [--out FILE]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    BenchOpts o = { 5, 4096, MAP_GEN_OPEN, 0, "/tmp", "assets/maps", NULL };
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if      (!strcmp(a, "--runs") && v) { o.runs = atoi(v); ++i; }
+        else if (!strcmp(a, "--gen")  && v) { o.gen_n = atoi(v); ++i; }
+        else if (!strcmp(a, "--stream") && v) { o.stream_mib = atoi(v); ++i; }
+        else if (!strcmp(a, "--kind") && v && map_gen_kind(v) >= 0) { o.kind = (MapGenKind)map_gen_kind(v); ++i; }
+        else if (!strcmp(a, "--tmp")  && v) { o.tmp_dir = v; ++i; }
+        else if (!strcmp(a, "--maps") && v) { o.maps_dir = v; ++i; }
+        else if (!strcmp(a, "--out")  && v) { o.out_path = v; ++i; }
+        else { usage(argv[0]); return 2; }
+    }
+    if (o.runs <= 0) { usage(argv[0]); return 2; }
+
+    FILE* out = stdout;
+    if (o.out_path && !(out = fopen(o.out_path, "w"))) { perror(o.out_path); return 1; }
+    uint64_t* ns = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.runs);
+    if (!ns) { fprintf(stderr, "out of memory\n"); return 1; }
+
+    char** paths = NULL; size_t count = 0;
+    if (map_list_levels(o.maps_dir, &paths, &count) != 0) { paths = NULL; count = 0; }
+    if (count) qsort(paths, count, sizeof(char*), cmp_str);
+
+    fprintf(out, "{\n  \"bench\": \"load\", \"runs\": %d,\n  \"results\": [\n", o.runs);
+    int first = 1;
+    for (size_t i = 0; i < count; ++i) bench_level(out, &o, paths[i], paths[i], ns, &first);
+    if (o.gen_n > 2) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s%d.cub3d", o.kind == MAP_GEN_OPEN ? "gen" : map_gen_kind_name(o.kind), o.gen_n);
+        char* src = path_in(o.tmp_dir, name);
+        if (src && write_source(src, o.gen_n, o.kind) == 0) {
+            bench_level(out, &o, name, src, ns, &first);
+            remove(src);
+        } else {
+            fprintf(stderr, "cannot write '%s'\n", src ? src : name);
+        }
+        free(src);
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    map_free_paths(paths, count);
+    free(ns);
+    if (out != stdout) fclose(out);
+    return 0;
+}
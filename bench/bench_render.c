@@ -0,0 +1,494 @@
+// Headless renderer benchmark: renders scripted camera paths into heap
+// canvases (no window, no GPU) and prints per-frame timings as JSON.
+//
+//   ./bench_render [--width N] [--height N] [--frames N] [--threads N]
+//                  [--mode scalar|packet] [--layout row|col] [--textures on|off]
+//                  [--floor on|off] [--scale F] [--cache on|off] [--dist on|off]
+//                  [--occ on|off] [--tiles rows|chunked] [--open N] [--pillars N]
+//                  [--kind open|pillars|maze|corridors] [--present copy|direct]
+//                  [--maps DIR] [--out FILE]
+//
+// Frame time covers render_scene only; present_ns is the canvas_copy into a
+// row-major "screen" (a plain copy, or the transpose for --layout col).
+// --present direct renders straight into the screen instead, as the game
+// does at full resolution (game_scene.h): row-major, no present (--layout
+// and --scale below 1 then fall back to copy). present_bytes is the memory
+// traffic of the present per frame (pixels read plus written).
+// The present is the game's compositor (canvas_composite): only what the
+// frame changed is copied, and pushed_px_per_frame counts the screen
+// pixels written (0 for frames the ray cache skipped).
+// --scale renders at F * width x F * height (dynamic resolution) and the
+// present upscales with canvas_copy_scaled.
+// --cache on renders every path twice, without and with the ray cache, and
+// reports the hit rate and the render time saved per frame.
+// --dist on builds each map's distance field and renders every path with
+// plain DDA first, reporting DDA steps per ray and frame time for both.
+// --occ on does the same with the bit-packed occupancy grid (the walk uses
+// the distance field when both are on).
+// --tiles chunked stores every map in the chunked Z-order layout (map.h).
+// --open N adds a generated N x N map (map_gen.h) to the maps: an open arena
+// of scattered 2x2 pillars unless --kind picks another generator; --pillars
+// sets its density per 65536 cells (the kind's default: 128 pillar starts).
+// The east/north/diagonal paths hold one heading, to compare ray directions:
+// ns_per_step is the frame time per DDA step, e.g. for
+// --open 8192 --pillars 4 with --tiles rows and chunked. The minimap is
+// drawn like the game's (minimap.h): in place into the screen at (8,8), 6
+// pixels per cell, from a wall layer cached before the timed frames.
+#include "raycast.h"
+#include "raycast_dda.h"
+#include "map.h"
+#include "map_dist.h"
+#include "map_occ.h"
+#include "map_gen.h"
+#include "minimap.h"
+#include "bench_util.h"
+#include <math.h>
+
+#define BENCH_MINIMAP_SCALE 6   // GAME_SCENE_MINIMAP_SCALE
+#define BENCH_MINIMAP_AT    8   // GAME_SCENE_MINIMAP_X and _Y
+
+typedef struct BenchOpts {
+    int         width, height;
+    int         frames;
+    int         threads;
+    RaycastMode mode;
+    CanvasLayout layout;
+    int         textures;
+    int         floor;      // textured floor and ceiling
+    float       scale;      // render scale, (0, 1]
+    int         cache;      // compare against a ray-cached pass
+    int         dist;       // compare against a distance-field pass
+    int         occ;        // compare against an occupancy-grid pass
+    MapLayout   tiles;      // layout the maps are converted to
+    int         open_n;     // > 0: add a generated open map this size
+    int         pillars;    // density of the generated map, per 65536 cells (< 0 = default)
+    MapGenKind  kind;       // generator of the --open map
+    int         direct;     // render into the screen, no present
+    const char* maps_dir;
+    const char* out_path;
+} BenchOpts;
+
+typedef struct BenchMap {
+    char*   name;
+    GridMap map;
+    uint8_t* owned;     // heap tiles (NULL for WORLD_DATA)
+    MapDist dist;       // built with --dist
+    MapOcc  occ;        // built with --occ
+} BenchMap;
+
+// ---------------- Camera scripts ----------------
+typedef enum {
+    PATH_TURN = 0, PATH_WALK, PATH_WANDER, PATH_LOOK,
+    PATH_EAST, PATH_NORTH, PATH_DIAGONAL,   // fixed heading, creeping forward
+    PATH_COUNT
+} PathId;
+static const char* PATH_NAMES[PATH_COUNT] = { "turn", "walk", "wander", "look", "east", "north", "diagonal" };
+
+static void cam_rotate(Camera* cam, float a) {
+    float cs = cosf(a), sn = sinf(a);
+    Vec2f d = cam->dir, p = cam->plane;
+    cam->dir   = (Vec2f){ d.x*cs - d.y*sn, d.x*sn + d.y*cs };
+    cam->plane = (Vec2f){ p.x*cs - p.y*sn, p.x*sn + p.y*cs };
+}
+
+// Same sliding collision as the game scene. Returns 0 when fully blocked.
+static int cam_move(Camera* cam, const GridMap* map, float dist) {
+    Vec2f n = { cam->pos.x + cam->dir.x * dist, cam->pos.y + cam->dir.y * dist };
+    int moved = 0;
+    if (!map_is_wall(map, (int)n.x, (int)cam->pos.y)) { cam->pos.x = n.x; moved = 1; }
+    if (!map_is_wall(map, (int)cam->pos.x, (int)n.y)) { cam->pos.y = n.y; moved = 1; }
+    return moved;
+}
+
+// Empty cell closest to the map center (cell center), or the center itself.
+static Vec2f find_spawn(const GridMap* map) {
+    int cx = map->w / 2, cy = map->h / 2;
+    int rmax = map->w > map->h ? map->w : map->h;
+    for (int r = 0; r < rmax; ++r)
+        for (int y = cy - r; y <= cy + r; ++y)
+            for (int x = cx - r; x <= cx + r; ++x) {
+                if (x != cx - r && x != cx + r && y != cy - r && y != cy + r) continue;
+                if (!map_is_wall(map, x, y)) return (Vec2f){ x + 0.5f, y + 0.5f };
+            }
+    return (Vec2f){ cx + 0.5f, cy + 0.5f };
+}
+
+static Camera path_start(const GridMap* map, PathId id) {
+    Camera cam;
+    cam.pos   = find_spawn(map);
+    cam.dir   = (Vec2f){ -1.0f, 0.0f };
+    cam.plane = (Vec2f){  0.0f, 0.66f };
+    if (id == PATH_EAST)     cam_rotate(&cam, 3.1415927f);
+    if (id == PATH_NORTH)    cam_rotate(&cam, 1.5707963f);
+    if (id == PATH_DIAGONAL) cam_rotate(&cam, 2.3561945f);   // north-east
+    return cam;
+}
+
+typedef struct PathState {
+    unsigned rng;       // seeded per run: scripts are deterministic
+    float    turn;      // current wander turn rate
+} PathState;
+
+// Advance 'cam' by one frame of path 'id'.
+static void path_step(PathId id, PathState* st, Camera* cam, const GridMap* map, int frame, int frames) {
+    switch (id) {
+    case PATH_TURN:
+        cam_rotate(cam, 6.2831853f / (float)frames);
+        break;
+    case PATH_WALK:
+        if (!cam_move(cam, map, 0.05f)) cam_rotate(cam, 1.5707963f);
+        break;
+    case PATH_WANDER: {
+        if (frame % 30 == 0) {
+            st->rng = st->rng * 1664525u + 1013904223u;
+            st->turn = ((float)(st->rng >> 8) / 16777216.0f - 0.5f) * 0.1f;
+        }
+        cam_rotate(cam, st->turn);
+        if (!cam_move(cam, map, 0.04f)) cam_rotate(cam, 2.0f);
+        break;
+    }
+    case PATH_LOOK:
+        // look around in place: turn for 24 frames, hold still for 16
+        if (frame % 40 < 24) cam_rotate(cam, (frame / 40) % 2 ? -0.035f : 0.035f);
+        break;
+    case PATH_EAST: case PATH_NORTH: case PATH_DIAGONAL:
+        cam_move(cam, map, 0.02f);
+        break;
+    default: break;
+    }
+}
+
+// ---------------- Maps ----------------
+static int cmp_str(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Move 'bm' to 'layout' (a copy when the tiles are not owned).
+static void set_layout(BenchMap* bm, MapLayout layout) {
+    if (bm->map.layout == layout) return;
+    uint8_t* data = map_convert_layout(bm->map.data, bm->map.layout, layout, bm->map.w, bm->map.h);
+    if (!data) { fprintf(stderr, "'%s': out of memory, keeping row layout\n", bm->name); return; }
+    free(bm->owned);
+    bm->owned = data;
+    bm->map.data = data;
+    bm->map.layout = layout;
+}
+
+static size_t load_maps(const char* dir, const BenchOpts* o, BenchMap** out) {
+    char** paths = NULL; size_t count = 0;
+    if (map_list_levels(dir, &paths, &count) != 0) { paths = NULL; count = 0; }
+    if (count) qsort(paths, count, sizeof(char*), cmp_str);
+
+    BenchMap* maps = (BenchMap*)calloc(count + 2, sizeof(BenchMap));
+    if (!maps) { map_free_paths(paths, count); *out = NULL; return 0; }
+    size_t n = 0;
+    maps[n].name = strdup("world");
+    maps[n].map = (GridMap){ .w = WORLD_W, .h = WORLD_H, .data = WORLD_DATA };
+    n++;
+    if (o->open_n > 2) {
+        MapGenConfig gc = { o->kind, o->open_n, o->open_n, 0xB16B00B5u, o->pillars, 4 };
+        uint8_t* data = map_gen(&gc);
+        if (data) {
+            char name[32];
+            snprintf(name, sizeof(name), "%s%d", o->kind == MAP_GEN_PILLARS ? "open" : map_gen_kind_name(o->kind), o->open_n);
+            maps[n].name  = strdup(name);
+            maps[n].map   = (GridMap){ .w = o->open_n, .h = o->open_n, .data = data };
+            maps[n].owned = data;
+            n++;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t* data = NULL; int w = 0, h = 0; char* err = NULL;
+        if (map_parse_cub3d_file(paths[i], &data, &w, &h, &err) != 0) {
+            fprintf(stderr, "skipping '%s': %s\n", paths[i], err ? err : "parse error");
+            free(err);
+            continue;
+        }
+        maps[n].name  = strdup(paths[i]);
+        maps[n].map   = (GridMap){ .w = w, .h = h, .data = data };
+        maps[n].owned = data;
+        n++;
+    }
+    map_free_paths(paths, count);
+    *out = maps;
+    return n;
+}
+
+// ---------------- Run ----------------
+typedef struct BenchBuffers {
+    Canvas    scene;      // render target (--layout)
+    Canvas    screen;     // row-major stand-in for App->screen
+    CanvasDirty scene_dirty;   // scene.dirty
+    CanvasDirty damage;        // screen.dirty, reset every frame
+    size_t    pushed_px;       // damage area summed over a pass
+    uint64_t* frame_ns;
+    uint64_t* present_ns;
+    Minimap   minimap;
+    uint64_t* mini_ns;
+    uint64_t* base_ns;    // render times without the ray cache (--cache on)
+    uint64_t* plain_ns;   // render times with plain DDA (--dist on)
+} BenchBuffers;
+
+// The game's HUD pass: the minimap in place, all of it again when the
+// frame drew over it.
+static void draw_hud(BenchBuffers* b, const GridMap* map, const Camera* cam) {
+    Canvas mini = canvas_view(&b->screen, BENCH_MINIMAP_AT, BENCH_MINIMAP_AT,
+                              map->w * BENCH_MINIMAP_SCALE, map->h * BENCH_MINIMAP_SCALE);
+    bool covered = canvas_dirty_hits(&b->damage, mini.ox, mini.oy, mini.w, mini.h);
+    minimap_draw(&b->minimap, &mini, map, cam, BENCH_MINIMAP_SCALE, covered);
+}
+
+// Full-resolution frames go straight into the screen with --present direct.
+static int present_direct(const BenchOpts* o) {
+    return o->direct && o->scale >= 1.0f;
+}
+
+// One run of path 'id' from its start, filling frame/present/minimap times.
+static void run_pass(const BenchOpts* o, const RaycastCtx* rc, BenchBuffers* b, Canvas* scene,
+                     const GridMap* map, PathId id) {
+    PathState st = { 0xC0FFEEu, 0.0f };
+    Camera cam = path_start(map, id);
+    for (int i = 0; i < 3; ++i) render_scene(scene, map, &cam, rc);   // warm-up
+    draw_hud(b, map, &cam);   // builds the wall layer
+    if (rc->stats) memset(rc->stats, 0, sizeof(*rc->stats));
+    b->pushed_px = 0;
+
+    for (int f = 0; f < o->frames; ++f) {
+        path_step(id, &st, &cam, map, f, o->frames);
+        canvas_dirty_reset(&b->damage);
+        uint64_t t0 = bench_now_ns();
+        render_scene(scene, map, &cam, rc);
+        uint64_t t1 = bench_now_ns();
+        if (scene != &b->screen) canvas_composite(&b->screen, scene, &b->scene_dirty, 0, 0, o->width, o->height);
+        uint64_t t2 = bench_now_ns();
+        draw_hud(b, map, &cam);
+        uint64_t t3 = bench_now_ns();
+        b->pushed_px += canvas_dirty_area(&b->damage);
+        b->frame_ns[f]   = t1 - t0;
+        b->present_ns[f] = t2 - t1;
+        b->mini_ns[f]    = t3 - t2;
+    }
+}
+
+// DDA iterations per column that was cast (not taken from the ray cache).
+static double steps_per_ray(const RaycastStats* st) {
+    uint64_t cast = st->columns - st->cached_columns;
+    return cast ? (double)st->dda_steps / (double)cast : 0.0;
+}
+
+static void bench_path(FILE* out, const BenchOpts* o, RaycastCtx* rc, BenchBuffers* b,
+                       const BenchMap* bm, PathId id, RayCache* cache) {
+    int sw = (int)((float)o->width * o->scale + 0.5f), sh = (int)((float)o->height * o->scale + 0.5f);
+    Canvas view = canvas_reuse(&b->scene, sw > 0 ? sw : 1, sh > 0 ? sh : 1);
+    Canvas* scene = present_direct(o) ? &b->screen : &view;
+    const GridMap* map = &bm->map;
+
+    double plain_steps = 0.0;
+    int skip = map->dist || map->occ;
+    if (skip) {
+        // same path with plain DDA first, for steps and time saved
+        GridMap plain = *map;
+        plain.dist = NULL;
+        plain.occ = NULL;
+        run_pass(o, rc, b, scene, &plain, id);
+        memcpy(b->plain_ns, b->frame_ns, sizeof(uint64_t) * (size_t)o->frames);
+        plain_steps = steps_per_ray(rc->stats);
+        if (cache) ray_cache_invalidate(cache);
+    }
+    if (cache) {
+        // same path without the cache first, for the time saved
+        rc->cache = NULL;
+        run_pass(o, rc, b, scene, map, id);
+        memcpy(b->base_ns, b->frame_ns, sizeof(uint64_t) * (size_t)o->frames);
+        ray_cache_invalidate(cache);
+        rc->cache = cache;
+    }
+    run_pass(o, rc, b, scene, map, id);
+
+    BenchStats fs = bench_stats(b->frame_ns, (size_t)o->frames);
+    BenchStats ps = bench_stats(b->present_ns, (size_t)o->frames);
+    BenchStats ms = bench_stats(b->mini_ns, (size_t)o->frames);
+    fprintf(out, "    {\"map\": ");
+    bench_json_str(out, bm->name);
+    fprintf(out, ", \"map_w\": %d, \"map_h\": %d, \"path\": \"%s\",\n      ", map->w, map->h, PATH_NAMES[id]);
+    bench_json_stats(out, "frame_ns", fs, 1.0);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "column_ns", fs, (double)scene->w);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "present_ns", ps, 1.0);
+    fprintf(out, ",\n      ");
+    bench_json_stats(out, "minimap_ns", ms, 1.0);
+    fprintf(out, ",\n      \"present_bytes\": %zu",
+            scene == &b->screen ? (size_t)0 : ((size_t)scene->w * scene->h + (size_t)o->width * o->height) * 4);
+    fprintf(out, ", \"pushed_px_per_frame\": %.0f", (double)b->pushed_px / (double)o->frames);
+    fprintf(out, ",\n      \"wall_texels_per_frame\": %.0f, \"floor_texels_per_frame\": %.0f,"
+                 " \"steps_per_ray\": %.1f, \"ns_per_step\": %.2f",
+            (double)rc->stats->wall_texels / (double)o->frames,
+            (double)rc->stats->floor_texels / (double)o->frames, steps_per_ray(rc->stats),
+            rc->stats->dda_steps ? fs.mean * (double)o->frames / (double)rc->stats->dda_steps : 0.0);
+    MapMemory mem = map_memory(map);
+    fprintf(out, ",\n      \"tile_bytes\": %zu, \"plane_bytes\": %zu, \"dist_bytes\": %zu, \"occ_bytes\": %zu,"
+                 " \"map_bytes\": %zu, \"int_tile_bytes\": %zu, \"saved_bytes\": %zu",
+            mem.tiles, mem.planes, mem.dist, mem.occ, mem.total, mem.int_tiles, mem.int_tiles - mem.tiles);
+    if (skip) {
+        BenchStats ds = bench_stats(b->plain_ns, (size_t)o->frames);
+        fprintf(out, ",\n      ");
+        bench_json_stats(out, "plain_frame_ns", ds, 1.0);
+        fprintf(out, ",\n      \"plain_steps_per_ray\": %.1f", plain_steps);
+    }
+    if (cache) {
+        // a skipped frame reuses every column
+        const RaycastStats* st = rc->stats;
+        uint64_t cols = st->columns + st->skipped_frames * (uint64_t)scene->w;
+        uint64_t hits = st->cached_columns + st->skipped_frames * (uint64_t)scene->w;
+        BenchStats us = bench_stats(b->base_ns, (size_t)o->frames);
+        fprintf(out, ",\n      ");
+        bench_json_stats(out, "uncached_frame_ns", us, 1.0);
+        fprintf(out, ",\n      \"cache_hit_rate\": %.4f, \"skipped_frames\": %llu,"
+                     " \"edge_rays_per_frame\": %.1f, \"saved_ns_per_frame\": %.0f",
+                cols ? (double)hits / (double)cols : 0.0, (unsigned long long)st->skipped_frames,
+                (double)st->edge_rays / (double)o->frames, us.mean - fs.mean);
+    }
+    fprintf(out, "}");
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--width N] [--height N] [--frames N] [--threads N]"
+                    " [--mode scalar|packet] [--layout row|col] [--textures on|off]"
+                    " [--floor on|off] [--scale F] [--cache on|off] [--dist on|off] [--occ on|off]"
+                    " [--tiles rows|chunked] [--open N] [--pillars N]"
+                    " [--kind open|pillars|maze|corridors] [--present copy|direct] [--maps DIR] [--out FILE]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    BenchOpts o = { 800, 600, 240, 1, RAYCAST_PACKET, CANVAS_COL_MAJOR, 1, 1, 1.0f, 0, 0, 0, MAP_LAYOUT_ROWS, 0, -1,
+                    MAP_GEN_PILLARS, 0, "assets/maps", NULL };
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if      (!strcmp(a, "--width")   && v) { o.width   = atoi(v); ++i; }
+        else if (!strcmp(a, "--height")  && v) { o.height  = atoi(v); ++i; }
+        else if (!strcmp(a, "--frames")  && v) { o.frames  = atoi(v); ++i; }
+        else if (!strcmp(a, "--threads") && v) { o.threads = atoi(v); ++i; }
+        else if (!strcmp(a, "--scale")   && v) { o.scale   = (float)atof(v); ++i; }
+        else if (!strcmp(a, "--open")    && v) { o.open_n  = atoi(v); ++i; }
+        else if (!strcmp(a, "--pillars") && v) { o.pillars = atoi(v); ++i; }
+        else if (!strcmp(a, "--maps")    && v) { o.maps_dir = v; ++i; }
+        else if (!strcmp(a, "--out")     && v) { o.out_path = v; ++i; }
+        else if (!strcmp(a, "--mode")    && v) {
+            o.mode = !strcmp(v, "scalar") ? RAYCAST_SCALAR : RAYCAST_PACKET; ++i;
+        } else if (!strcmp(a, "--textures") && v) {
+            o.textures = strcmp(v, "off") != 0; ++i;
+        } else if (!strcmp(a, "--cache") && v) {
+            o.cache = strcmp(v, "off") != 0; ++i;
+        } else if (!strcmp(a, "--dist") && v) {
+            o.dist = strcmp(v, "off") != 0; ++i;
+        } else if (!strcmp(a, "--occ") && v) {
+            o.occ = strcmp(v, "off") != 0; ++i;
+        } else if (!strcmp(a, "--tiles") && v) {
+            o.tiles = !strcmp(v, "chunked") ? MAP_LAYOUT_CHUNKED : MAP_LAYOUT_ROWS; ++i;
+        } else if (!strcmp(a, "--floor") && v) {
+            o.floor = strcmp(v, "off") != 0; ++i;
+        } else if (!strcmp(a, "--layout") && v) {
+            o.layout = !strcmp(v, "row") ? CANVAS_ROW_MAJOR : CANVAS_COL_MAJOR; ++i;
+        } else if (!strcmp(a, "--present") && v) {
+            o.direct = !strcmp(v, "direct"); ++i;
+        } else if (!strcmp(a, "--kind") && v && map_gen_kind(v) >= 0) {
+            o.kind = (MapGenKind)map_gen_kind(v); ++i;
+        } else { usage(argv[0]); return 2; }
+    }
+    if (o.width <= 0 || o.height <= 0 || o.frames <= 0 || !(o.scale > 0.0f && o.scale <= 1.0f)) {
+        usage(argv[0]); return 2;
+    }
+
+    FILE* out = stdout;
+    if (o.out_path && !(out = fopen(o.out_path, "w"))) { perror(o.out_path); return 1; }
+
+    // procedural textures stand in for the PNGs (no MLX42 loader here)
+    WallTexSet walls;
+    memset(&walls, 0, sizeof(walls));
+    if (o.textures)
+        for (int i = 1; i < WALL_TEX_SLOTS; ++i) wall_tex_procedural(&walls.tex[i], raycast_wall_color(i), 6);
+    WallTex floor_tex = { 0 }, ceil_tex = { 0 };
+    if (o.floor) {
+        wall_tex_tiles(&floor_tex, rgba(110, 100, 90, 255), 6);
+        wall_tex_tiles(&ceil_tex, rgba(150, 150, 160, 255), 6);
+    }
+
+    RaycastStats stats;
+    RaycastCtx rc = { 0 };
+    rc.pool  = worker_pool_create(o.threads);
+    rc.mode  = o.mode;
+    rc.walls = o.textures ? &walls : NULL;
+    rc.floor   = o.floor ? &floor_tex : NULL;
+    rc.ceiling = o.floor ? &ceil_tex : NULL;
+    rc.stats = &stats;
+    RaycastRows rows = { 0 };
+    rc.rows  = &rows;
+    RayCache cache;
+    ray_cache_init(&cache);
+
+    BenchBuffers b;
+    int err = (o.layout == CANVAS_COL_MAJOR) ? canvas_init_transposed(&b.scene, o.width, o.height)
+                                             : canvas_init_heap(&b.scene, o.width, o.height);
+    err |= canvas_init_heap(&b.screen, o.width, o.height);
+    canvas_dirty_reset(&b.scene_dirty);
+    b.scene.dirty = &b.scene_dirty;
+    b.screen.dirty = &b.damage;
+    canvas_dirty_reset(&b.damage);
+    minimap_init(&b.minimap);
+    b.frame_ns   = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.frames);
+    b.present_ns = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.frames);
+    b.mini_ns    = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.frames);
+    b.base_ns    = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.frames);
+    b.plain_ns   = (uint64_t*)malloc(sizeof(uint64_t) * (size_t)o.frames);
+    if (err || !b.frame_ns || !b.present_ns || !b.mini_ns || !b.base_ns || !b.plain_ns) { fprintf(stderr, "out of memory\n"); return 1; }
+
+    BenchMap* maps = NULL;
+    size_t nmaps = load_maps(o.maps_dir, &o, &maps);
+    for (size_t m = 0; m < nmaps; ++m) {
+        set_layout(&maps[m], o.tiles);
+        if (o.dist && map_dist_build(&maps[m].dist, &maps[m].map) == 0) maps[m].map.dist = maps[m].dist.d;
+        if (o.occ && map_occ_build(&maps[m].occ, &maps[m].map) == 0) maps[m].map.occ = &maps[m].occ;
+    }
+
+    fprintf(out, "{\n  \"bench\": \"render\",\n");
+    fprintf(out, "  \"width\": %d, \"height\": %d, \"frames\": %d, \"threads\": %d,\n",
+            o.width, o.height, o.frames, worker_pool_threads(rc.pool));
+    fprintf(out, "  \"mode\": \"%s\", \"packet_width\": %d, \"layout\": \"%s\", \"present\": \"%s\",\n",
+            o.mode == RAYCAST_PACKET ? "packet" : "scalar", ray_packet_width(),
+            present_direct(&o) || o.layout == CANVAS_ROW_MAJOR ? "row" : "col", present_direct(&o) ? "direct" : "copy");
+    fprintf(out, "  \"scale\": %.3f, \"cache\": %s, \"dist\": %s, \"occ\": %s, \"tiles\": \"%s\",\n",
+            (double)o.scale, o.cache ? "true" : "false", o.dist ? "true" : "false", o.occ ? "true" : "false",
+            o.tiles == MAP_LAYOUT_CHUNKED ? "chunked" : "rows");
+    fprintf(out, "  \"textures\": %s, \"texture_bytes\": %zu,\n",
+            o.textures ? "true" : "false", wall_tex_set_bytes(&walls));
+    fprintf(out, "  \"floor\": %s, \"floor_texture_bytes\": %zu,\n",
+            o.floor ? "true" : "false", wall_tex_bytes(&floor_tex) + wall_tex_bytes(&ceil_tex));
+    fprintf(out, "  \"results\": [\n");
+    int first = 1;
+    for (size_t m = 0; m < nmaps; ++m) {
+        for (int p = 0; p < PATH_COUNT; ++p) {
+            if (!first) fprintf(out, ",\n");
+            first = 0;
+            bench_path(out, &o, &rc, &b, &maps[m], (PathId)p, o.cache ? &cache : NULL);
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    for (size_t m = 0; m < nmaps; ++m) { free(maps[m].name); free(maps[m].owned); map_dist_free(&maps[m].dist);
+                                      map_occ_free(&maps[m].occ); }
+    free(maps);
+    free(b.frame_ns); free(b.present_ns); free(b.mini_ns); free(b.base_ns); free(b.plain_ns);
+    ray_cache_free(&cache);
+    raycast_rows_free(&rows);
+    canvas_destroy(&b.scene);
+    canvas_destroy(&b.screen);
+    minimap_free(&b.minimap);
+    wall_tex_set_free(&walls);
+    wall_tex_free(&floor_tex);
+    wall_tex_free(&ceil_tex);
+    worker_pool_destroy(rc.pool);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// Small helpers shared by the headless benchmarks (timing, stats, JSON).
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct BenchStats {
+    double min, median, p99, mean;
+} BenchStats;
+
+static inline int bench_cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts 'samples' in place.
+static inline BenchStats bench_stats(uint64_t* samples, size_t n) {
+    BenchStats s = { 0, 0, 0, 0 };
+    if (n == 0) return s;
+    qsort(samples, n, sizeof(uint64_t), bench_cmp_u64);
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += (double)samples[i];
+    size_t i99 = (n * 99) / 100;
+    if (i99 >= n) i99 = n - 1;
+    s.min    = (double)samples[0];
+    s.median = (double)samples[n / 2];
+    s.p99    = (double)samples[i99];
+    s.mean   = sum / (double)n;
+    return s;
+}
+
+// {"min": .., "median": .., "p99": .., "mean": ..} with every value divided by 'div'.
+static inline void bench_json_stats(FILE* out, const char* key, BenchStats s, double div) {
+    fprintf(out, "\"%s\": {\"min\": %.1f, \"median\": %.1f, \"p99\": %.1f, \"mean\": %.1f}",
+            key, s.min / div, s.median / div, s.p99 / div, s.mean / div);
+}
+
+// Writes 's' as a JSON string literal (quotes, backslashes and control chars escaped).
+static inline void bench_json_str(FILE* out, const char* s) {
+    fputc('"', out);
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') { fputc('\\', out); fputc(c, out); }
+        else if (c < 0x20) fprintf(out, "\\u%04x", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+#endif
@@ -3,12 +3,34 @@
 
 #include <MLX42/MLX42.h>
 #include "canvas.h"
+#include "dirty_overlay.h"
 #include "scene_manager.h"
+#include "worker_pool.h"
+
+// Render thread count (calling thread included). 0 = one per online CPU.
+// Overridden at runtime by the RENDER_THREADS environment variable.
+#ifndef RENDER_THREADS
+# ifdef WEB
+#  define RENDER_THREADS 1
+# else
+#  define RENDER_THREADS 0
+# endif
+#endif
+
+// Diagnostics (load times, memory, reloads) on stderr through app_log().
+// Overridden at runtime by the APP_VERBOSE environment variable.
+#ifndef APP_VERBOSE
+#define APP_VERBOSE 0
+#endif
 
 typedef struct App {
     mlx_t*        mlx;
     Canvas        screen;      // only image attached to the window
+    CanvasDirty   damage;      // what this frame wrote into screen (screen.dirty)
+    DirtyOverlay  overlay;     // F3: damage outlines + pixels pushed per frame
     double        last_time;
+    WorkerPool*   pool;        // persistent render workers (shared by scenes)
+    bool          verbose;     // app_log() writes
 
     SceneManager  sm;
 } App;
@@ -16,4 +38,6 @@ typedef struct App {
 App* app_create(int width, int height, const char* title);
 void  app_run(App* app);
 void  app_destroy(App* app);
+// printf-style diagnostic line on stderr, only when app->verbose.
+void  app_log(const App* app, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
 #endif
\ No newline at end of file
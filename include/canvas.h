@@ -1,23 +1,120 @@
 #ifndef CANVAS_H
 #define CANVAS_H
 
+#ifdef HEADLESS
+/* Windowless builds (benchmarks): no MLX42, canvases live on the heap. */
+typedef struct mlx mlx_t;
+typedef struct mlx_image mlx_image_t;
+#else
 #include <MLX42/MLX42.h>
+#endif
 #include "types.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum {
+    CANVAS_ROW_MAJOR = 0,  // px[y * stride + x] (MLX images)
+    CANVAS_COL_MAJOR = 1,  // px[x * stride + y]: vertical spans are contiguous
+} CanvasLayout;
+
+/* Dirty rectangles: what was drawn into a canvas since the last reset, so
+   a compositor copies (and the window uploads) only what changed. Rects
+   that overlap or touch, or whose union wastes little, are merged as they
+   come, so the list stays disjoint; past CANVAS_DIRTY_MAX rects the two
+   whose union grows least are merged. */
+#ifndef CANVAS_DIRTY_MAX
+#define CANVAS_DIRTY_MAX 32
+#endif
+
+typedef struct CanvasRect {
+    int x, y, w, h;
+} CanvasRect;
+
+typedef struct CanvasDirty {
+    CanvasRect r[CANVAS_DIRTY_MAX];
+    int        n;
+} CanvasDirty;
+
 typedef struct {
     mlx_t*       mlx;
-    mlx_image_t* img;
+    mlx_image_t* img;      // NULL for heap canvases and views
+    uint32_t*    px;       // pixel (0,0) (img->pixels, heap, or inside a parent)
     int          w, h;
+    CanvasLayout layout;
+    int          stride;   // pixels from one row (column when COL_MAJOR) to the next:
+                           // w (h) when packed, the parent's in a view
+    CanvasDirty* dirty;    // drawing is recorded here (NULL = not tracked; views share it)
+    int          ox, oy;   // where (0,0) is in the canvas 'dirty' belongs to
 } Canvas;
 
+static inline size_t canvas_index(const Canvas* c, int x, int y) {
+    return c->layout == CANVAS_COL_MAJOR ? (size_t)x * (size_t)c->stride + (size_t)y
+                                         : (size_t)y * (size_t)c->stride + (size_t)x;
+}
+
+/* True when the w*h pixels are contiguous (no gaps between rows). */
+static inline int canvas_packed(const Canvas* c) {
+    return c->stride == (c->layout == CANVAS_COL_MAJOR ? c->h : c->w);
+}
+
+/* c's pixel buffer reused as a packed w x h canvas of the same layout
+   (w <= c->w, h <= c->h, c packed), e.g. to render at a lower resolution
+   without reallocating. Contents are not preserved; never canvas_destroy() it. */
+static inline Canvas canvas_reuse(const Canvas* c, int w, int h) {
+    Canvas v = { c->mlx, NULL, c->px, w, h, c->layout, c->layout == CANVAS_COL_MAJOR ? h : w,
+                 c->dirty, c->ox, c->oy };
+    return v;
+}
+
+/* The w x h rectangle of c at (x,y), clipped to c, as a canvas of its own:
+   drawing into it draws into c in place (e.g. a HUD element straight into
+   the screen). Empty (w or h 0) when nothing is left; never canvas_destroy() it. */
+static inline Canvas canvas_view(const Canvas* c, int x, int y, int w, int h) {
+    int x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int x1 = x + w < c->w ? x + w : c->w, y1 = y + h < c->h ? y + h : c->h;
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+    uint32_t* px = (x1 > x0 && y1 > y0) ? c->px + canvas_index(c, x0, y0) : c->px;
+    Canvas v = { c->mlx, NULL, px, x1 - x0, y1 - y0, c->layout, c->stride,
+                 c->dirty, c->ox + x0, c->oy + y0 };
+    return v;
+}
+
+#ifndef HEADLESS
 int  canvas_init(Canvas* c, mlx_t* mlx, int w, int h);
+#endif
+/* Canvases start untracked (dirty NULL). */
+/* Plain heap-backed canvas, usable without a window. */
+int  canvas_init_heap(Canvas* c, int w, int h);
+/* Heap canvas in column-major layout (off-screen only; present with canvas_copy). */
+int  canvas_init_transposed(Canvas* c, int w, int h);
 void canvas_destroy(Canvas* c);
 
+/* Fills run on the vector unit picked at startup (canvas_ops.h). */
 void canvas_clear(Canvas* c, Color col);
 void canvas_put(Canvas* c, int x, int y, Color col);
 void canvas_fill_rect(Canvas* c, int x, int y, int w, int h, Color col);
 
-/* Opaque blit (no alpha). Copies src into dst at (dx,dy). Bounds-safe. */
+/* Opaque blit (no alpha). Copies src into dst at (dx,dy). Bounds-safe:
+   clipped once, then same-layout rows (columns) are memcpy'd. Layouts may
+   differ: a column-major src is transposed in cache blocks. */
 void canvas_copy(Canvas* dst, const Canvas* src, int dx, int dy);
+/* Nearest-neighbour resize of all of src onto the dw x dh rectangle of dst
+   at (dx,dy). Bounds-safe; same size falls back to canvas_copy. */
+void canvas_copy_scaled(Canvas* dst, const Canvas* src, int dx, int dy, int dw, int dh);
+/* Compositor: canvas_copy_scaled of only the parts of src listed in 'd'
+   (src coordinates, e.g. src's own tracker), then resets 'd'. */
+void canvas_composite(Canvas* dst, const Canvas* src, CanvasDirty* d, int dx, int dy, int dw, int dh);
+
+/* Record the w x h rectangle of c at (x,y) (clipped to c) as drawn, for
+   code that writes c->px itself; no-op when c is not tracked. */
+void   canvas_mark(Canvas* c, int x, int y, int w, int h);
+void   canvas_dirty_reset(CanvasDirty* d);
+void   canvas_dirty_add(CanvasDirty* d, int x, int y, int w, int h);
+/* Pixels covered (the rects are disjoint). */
+size_t canvas_dirty_area(const CanvasDirty* d);
+/* Whether any rect meets the w x h rectangle at (x,y). */
+bool   canvas_dirty_hits(const CanvasDirty* d, int x, int y, int w, int h);
 
 #endif
@@ -0,0 +1,22 @@
+#ifndef CANVAS_OPS_H
+#define CANVAS_OPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Pixel primitives under canvas.c: spans and rectangles of 32-bit pixels,
+   already clipped by the caller (strides in pixels). Fills use the widest
+   vector unit the CPU has: AVX2 is picked at run time on x86 (SSE2
+   otherwise), NEON and WASM SIMD128 when the build targets them. Copies
+   are memcpy per row, which libc already dispatches. */
+void canvas_ops_fill(uint32_t* d, size_t n, uint32_t v);
+void canvas_ops_fill_rect(uint32_t* d, size_t ds, int w, int h, uint32_t v);
+void canvas_ops_copy_rect(uint32_t* d, size_t ds, const uint32_t* s, size_t ss, int w, int h);
+
+/* The fill in use: "avx2", "sse2", "neon", "wasm-simd128" or "scalar". */
+const char* canvas_ops_isa(void);
+/* Use the named fill instead (benchmarks and checks): 0, or -1 when this
+   build or CPU has no such fill. NULL restores the startup choice. */
+int         canvas_ops_select(const char* isa);
+
+#endif
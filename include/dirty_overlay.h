@@ -0,0 +1,43 @@
+#ifndef DIRTY_OVERLAY_H
+#define DIRTY_OVERLAY_H
+
+#include <MLX42/MLX42.h>
+#include <stdbool.h>
+#include "canvas.h"
+
+// Debug view of the screen's dirty rectangles (toggled with
+// DIRTY_OVERLAY_KEY): outlines on a transparent image above the screen,
+// so the screen itself is never drawn over, and a "pixels pushed" line
+// under the active scene's stats line, refreshed every
+// DIRTY_OVERLAY_TEXT_MS.
+#ifndef DIRTY_OVERLAY_KEY
+#define DIRTY_OVERLAY_KEY MLX_KEY_F3
+#endif
+#ifndef DIRTY_OVERLAY_TEXT_MS
+#define DIRTY_OVERLAY_TEXT_MS 250
+#endif
+
+typedef struct DirtyOverlay {
+    mlx_t*       mlx;
+    mlx_image_t* img;       // outlines (NULL while hidden)
+    mlx_image_t* text;
+    mlx_image_t* status;    // the scene's line
+    CanvasDirty  shown;     // outlines on img now
+    bool         key_down;
+    double       text_at;   // when 'text' was last rewritten
+    size_t       pushed;    // pixels written since then
+    int          frames;
+} DirtyOverlay;
+
+void dirty_overlay_init(DirtyOverlay* o, mlx_t* mlx);
+void dirty_overlay_free(DirtyOverlay* o);
+
+// Once per frame, after the scene rendered: 'd' is what it wrote into the
+// w x h screen, 'status' the scene's stats line (may be NULL). Handles the
+// toggle key.
+void dirty_overlay_frame(DirtyOverlay* o, const CanvasDirty* d, int w, int h, double now, const char* status);
+static inline bool dirty_overlay_shown(const DirtyOverlay* o) { return o->img != NULL; }
+// The screen was recreated above the overlay: put the overlay back on top.
+void dirty_overlay_resize(DirtyOverlay* o, int w, int h);
+
+#endif
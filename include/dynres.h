@@ -0,0 +1,45 @@
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include <stdbool.h>
+
+// Dynamic resolution: picks a render scale from the measured frame time.
+// The scene is rendered at scale * full size (fewer rays, fewer rows) and
+// upscaled on present. Hysteresis keeps the scale from oscillating: it only
+// drops after several slow frames, only rises after a longer run of frames
+// within budget, and every raise that has to be undone doubles the wait
+// before the next one (a vsync-capped dt cannot show headroom, so raising
+// is a probe).
+
+#ifndef DYNRES_BUDGET_MS
+#define DYNRES_BUDGET_MS 16.7f
+#endif
+
+typedef struct DynResConfig {
+    float budget;       // target frame time, seconds
+    float min_scale;    // lowest scale (fraction of full width and height)
+    float step;         // scale change per adjustment
+    float down_ratio;   // drop when the smoothed dt exceeds budget * down_ratio ...
+    int   down_frames;  // ... for this many frames in a row
+    float up_ratio;     // raise when it stays under budget * up_ratio ...
+    int   up_frames;    // ... for this many frames (doubled per undone raise)
+} DynResConfig;
+
+typedef struct DynRes {
+    DynResConfig cfg;
+    bool  enabled;
+    float scale;        // current render scale, min_scale .. 1
+    float avg;          // smoothed frame time, seconds
+    int   over, under;  // consecutive frames above / below the thresholds
+    int   up_wait;      // frames under budget needed before the next raise
+    int   since_up;     // frames since the last raise
+} DynRes;
+
+// NULL cfg = defaults (DYNRES_BUDGET_MS, 0.5 .. 1 in steps of 0.125).
+void dynres_init(DynRes* d, const DynResConfig* cfg);
+// Feed one frame time (the dt of the main loop); true when the scale changed.
+bool dynres_update(DynRes* d, float dt);
+// Render size for a full-size w x h target (at least 1 x 1).
+void dynres_size(const DynRes* d, int w, int h, int* sw, int* sh);
+
+#endif
@@ -4,22 +4,142 @@
 #include "scene.h"
 #include "canvas.h"
 #include "map.h"
+#include "level_loader.h"
+#include "level_watch.h"
+#include "map_bin.h"
+#include "map_dist.h"
+#include "map_occ.h"
+#include "minimap.h"
+#include "raycast.h"
+#include "dynres.h"
 #include "types.h"
+#include <stdbool.h>
+
+// Render full-resolution frames straight into App->screen (row-major), with
+// no off-screen buffer and no present copy. The buffer below is then only
+// allocated once a frame needs it: below full scale (dynamic resolution).
+#ifndef GAME_SCENE_DIRECT
+#define GAME_SCENE_DIRECT 1
+#endif
+
+// Render the 3D view into a column-major off-screen buffer that is
+// transposed into App->screen on present (0 = row-major MLX image).
+#ifndef GAME_SCENE_COL_MAJOR
+#define GAME_SCENE_COL_MAJOR 1
+#endif
+
+// Start with dynamic resolution on (toggle in game with R).
+#ifndef GAME_SCENE_DYNRES
+# ifdef WEB
+#  define GAME_SCENE_DYNRES 1
+# else
+#  define GAME_SCENE_DYNRES 0
+# endif
+#endif
+
+// Maps up to this many cells also get a distance field (1 byte per cell,
+// the fastest skipping); bigger maps only walk the occupancy bits.
+#ifndef GAME_SCENE_DIST_MAX_CELLS
+#define GAME_SCENE_DIST_MAX_CELLS (2048 * 2048)
+#endif
+
+// Maps of at least this many cells are stored in chunked (Z-order) layout,
+// so rays cost the same in every direction; smaller ones fit in cache as rows.
+#ifndef GAME_SCENE_CHUNK_MIN_CELLS
+#define GAME_SCENE_CHUNK_MIN_CELLS (1024 * 1024)
+#endif
+
+// Levels with an up-to-date compiled ".cub3db" next to them (cub3dc) are
+// mapped instead of parsed. 1 also checks the payload hash on load, which
+// reads the whole file; the header and section bounds are always checked.
+#ifndef GAME_SCENE_VERIFY_LEVELS
+#define GAME_SCENE_VERIFY_LEVELS 0
+#endif
+
+// Compiled levels of at least this many cells (chunked, with occupancy) are
+// streamed: only the tiles around and ahead of the camera stay resident, in
+// an LRU cache of MAP_STREAM_CACHE_BYTES (0 = always map the whole level).
+#ifndef GAME_SCENE_STREAM_MIN_CELLS
+#define GAME_SCENE_STREAM_MIN_CELLS (16384 * 16384)
+#endif
+
+// Levels load on a background thread while the current one keeps rendering
+// under a loading indicator (0 = load inline, as the web build does).
+#ifndef GAME_SCENE_ASYNC_LOAD
+# ifdef WEB
+#  define GAME_SCENE_ASYNC_LOAD 0
+# else
+#  define GAME_SCENE_ASYNC_LOAD 1
+# endif
+#endif
+
+// The loaded level's file is watched (level_watch.h) and reloaded when it
+// is saved: a few changed tiles are patched in place, keeping the camera.
+#ifndef GAME_SCENE_HOT_RELOAD
+# ifdef WEB
+#  define GAME_SCENE_HOT_RELOAD 0
+# else
+#  define GAME_SCENE_HOT_RELOAD 1
+# endif
+#endif
+
+// Minimap: pixels per map cell, and its top-left corner on the screen (it
+// is drawn in place, clipped to the screen, from a cached wall layer).
+#ifndef GAME_SCENE_MINIMAP_SCALE
+#define GAME_SCENE_MINIMAP_SCALE 6
+#endif
+#ifndef GAME_SCENE_MINIMAP_X
+#define GAME_SCENE_MINIMAP_X 8
+#endif
+#ifndef GAME_SCENE_MINIMAP_Y
+#define GAME_SCENE_MINIMAP_Y 8
+#endif
+
+// Sweeps per second of the loading indicator.
+#ifndef GAME_SCENE_LOADING_SPEED
+#define GAME_SCENE_LOADING_SPEED 1.5f
+#endif
 
 typedef struct GameScene {
     Scene   base;
 
     // resources
-    Canvas  scene;       // off-screen color buffer
-    Canvas  minimap;
+    Canvas  scene;       // off-screen color buffer (px NULL = not allocated yet)
+    CanvasDirty scene_dirty; // what changed in it since it was last composited
+    Minimap minimap;         // cached wall layer, drawn in place into the screen
 
     GridMap map;
+    MapBin  level;           // compiled level map points into (base NULL = none)
+    MapStream* stream;       // or streaming its tiles (NULL = none)
+    uint64_t stream_gen;     // its tile generation the last frame was drawn with
+    MapDist map_dist;        // empty-space skipping for map, unless the level has it
+    MapOcc  map_occ;         // wall bits for map, unless the level has them
     Camera  cam;
+    RaycastCtx rc;
+    RayCache ray_cache;      // reused rays while turning in place
+    RaycastRows floor_rows;  // floor/ceiling row table, kept across frames
+    WallTexSet walls;
+    WallTex floor_tex;
+    WallTex ceil_tex;        // empty = flat sky
+    bool    mode_key_down;   // P: toggle scalar / packet DDA
+    bool    tex_key_down;    // T: toggle wall/floor/ceiling textures
+    DynRes  dynres;          // render scale from the frame time
+    bool    dynres_key_down; // R: toggle dynamic resolution
 
-    // map to load on next show (NULL = keep current)
+    LevelLoader* loader;     // background level loads
+    bool    loading;         // a load is in flight: indicator on, input off
+    float   load_time;       // seconds since it started (indicator animation)
+    LevelWatch* watch;       // the current level's file (NULL = not watched)
+    bool    reloading;       // a reload of it is in flight (no indicator)
+    bool    screen_stale;    // App->screen holds more than the last frame rendered into it
+    // map queued before the scene was initialized (NULL = keep current)
     const char* pending_map_path;
 } GameScene;
 
 void game_scene_init_instance(GameScene* gs);
-void game_scene_queue_load(GameScene* gs, const char* map_path); // called from menu callback
+// Start loading a level (called from menu callback); it replaces the
+// current map at the start of a frame once loaded.
+void game_scene_queue_load(GameScene* gs, const char* map_path);
+// Current render scale (1 = full resolution), for stats overlays.
+float game_scene_render_scale(const GameScene* gs);
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@ typedef struct GuiPagedGridConfig {
     int rows;               // number of rows (>=1)
     int gap;                // pixels between buttons (>=0)
     int pager_h;            // reserved height at bottom for pager (<= h). If 0, defaults to 28.
+    int thumb_h;            // > 0: room for a thumbnail at the top of each item; labels move to the bottom
 
     // Skins
     const mlx_texture_t* item_skin_tex;   // not owned
@@ -49,6 +50,8 @@ typedef struct GuiPagedGrid {
 
     // Buttons for current page (size = per_page; owned)
     GuiButton* item_btns;
+    mlx_image_t** thumb_imgs;    // per slot, NULL until set (owned)
+    unsigned layout_serial;      // bumped when the page is laid out again (thumbnails dropped)
 
     // Pager controls (owned)
     GuiButton btn_prev;
@@ -66,5 +69,12 @@ void gui_paged_grid_update(GuiContext* ctx, GuiPagedGrid* g);
 void gui_paged_grid_free(GuiContext* ctx, GuiPagedGrid* g);
 void gui_paged_grid_set_enabled(GuiPagedGrid* g, bool en);
 
+// Items on the current page: [*first, *first + return value).
+size_t gui_paged_grid_page_items(const GuiPagedGrid* g, size_t* first);
+// Show w x h canvas pixels (color_to_u32) as the thumbnail of 'item' (fit
+// into cfg.thumb_h). False when the item is not on the current page.
+bool gui_paged_grid_set_thumbnail(GuiContext* ctx, GuiPagedGrid* g, size_t item,
+                                  const uint32_t* px, int w, int h);
+
 
 #endif // GUI_PAGED_GRID_H
@@ -0,0 +1,50 @@
+#ifndef LEVEL_CATALOG_H
+#define LEVEL_CATALOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Index of the levels in a directory, kept on disk next to it
+// ("assets/maps" -> "assets/maps.catalog") so the menu starts without
+// reading every level. A refresh only lists the directory again when its
+// mtime moved, and only reads (hashes and parses) levels that are new or
+// whose mtime or size changed; everything else comes from the index.
+//
+// The file is a header, the entries, then their names (relative to the
+// directory) back to back. Numbers are in host order; a file that does not
+// check out is ignored and rebuilt.
+#define LEVEL_CATALOG_MAGIC   "CUB3DCAT"
+#define LEVEL_CATALOG_VERSION 1
+#define LEVEL_CATALOG_EXT     ".catalog"
+
+typedef struct LevelInfo {
+    char*    path;        // directory + "/" + name (what the loader opens)
+    int64_t  mtime_ns;
+    uint64_t size;
+    uint64_t hash;        // map_bin_hash() of the file
+    int      w, h;        // 0 x 0 when it does not parse
+} LevelInfo;
+
+typedef struct LevelCatalog {
+    char*      dir;
+    LevelInfo* levels;    // sorted by path
+    size_t     count;
+    int64_t    dir_mtime_ns;   // of the listing the entries came from (0 = none)
+} LevelCatalog;
+
+// Start from the index at 'index_path' when it is valid for 'dir', else
+// empty. Returns 0, or -1 when out of memory.
+int  level_catalog_load(LevelCatalog* c, const char* dir, const char* index_path);
+// Bring the entries up to date with the directory. Returns the number of
+// changes (levels added, rescanned or dropped, or a new listing), or -1
+// with a message in *err (free()) when the directory cannot be read.
+int  level_catalog_refresh(LevelCatalog* c, char** err);
+// Write the index through a temporary file renamed into place.
+int  level_catalog_save(const LevelCatalog* c, const char* index_path, char** err);
+void level_catalog_free(LevelCatalog* c);
+
+// Index file for a level directory. free() the result.
+char* level_catalog_path_for(const char* dir);
+
+#endif
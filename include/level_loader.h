@@ -0,0 +1,89 @@
+#ifndef LEVEL_LOADER_H
+#define LEVEL_LOADER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "map.h"
+#include "map_bin.h"
+#include "map_dist.h"
+#include "map_occ.h"
+#include "map_stream.h"
+
+// Loads levels on a background thread, so the render loop never waits for
+// parsing or for the traversal structures to build. A finished level is
+// handed over whole at a poll (the caller swaps it in between frames) and
+// levels that are no longer wanted go back to the loader to be freed off
+// the calling thread too. A new request supersedes the one in flight: it
+// stops at its next stage and its result is dropped.
+//
+// A reload of the current level after its file was edited compares the
+// new tiles with the current map on the loader thread and, when only a
+// few tiles changed, hands back just those (a patch) for the caller to
+// apply in place between frames.
+typedef struct LevelLoader LevelLoader;
+
+#ifndef LEVEL_LOADER_PATCH_SHARE
+#define LEVEL_LOADER_PATCH_SHARE 16
+#endif
+
+typedef struct TileEdit {
+    int     x, y;
+    uint8_t tile;       // the new id
+} TileEdit;
+
+// Everything a loaded level owns. After copying one, re-point map.occ with
+// loaded_level_fix().
+typedef struct LoadedLevel {
+    GridMap  map;
+    MapBin   level;     // compiled level map points into (base NULL = none)
+    MapStream* stream;  // or the one streaming its tiles (NULL = none)
+    MapDist  dist;      // built here unless the level has one
+    MapOcc   occ;
+    uint8_t* tiles;     // heap tiles (NULL when mapped or not owned)
+    bool     compiled;
+    double   ms;        // time the load took
+    char*    path;      // the level file
+    // a reload's patch: edits to the current level instead of a new map
+    bool      patch;
+    TileEdit* edits;
+    size_t    edit_count;
+} LoadedLevel;
+
+typedef struct LevelLoaderConfig {
+    size_t chunk_min_cells;   // chunked layout from this many cells
+    size_t dist_max_cells;    // distance field up to this many cells
+    size_t stream_min_cells;  // stream compiled levels from this many cells (0 = never)
+    bool   verify;            // check the payload hash of compiled levels
+    bool   threaded;          // false: loads run inside level_loader_poll()
+} LevelLoaderConfig;
+
+typedef enum LevelLoadStatus {
+    LEVEL_LOAD_IDLE = 0,
+    LEVEL_LOAD_BUSY,          // a request is queued or loading
+    LEVEL_LOAD_READY,         // *out holds the level; the caller owns it now
+    LEVEL_LOAD_FAILED,        // the latest request failed (reported once)
+} LevelLoadStatus;
+
+// NULL on allocation failure. Falls back to loading inline when the thread
+// cannot be started.
+LevelLoader* level_loader_create(const LevelLoaderConfig* cfg);
+// Cancels the load in flight, joins the thread and frees what it holds.
+void level_loader_destroy(LevelLoader* l);
+
+// Load 'path' (copied), superseding any earlier request and dropping a
+// result that was not taken yet.
+void level_loader_request(LevelLoader* l, const char* path);
+LevelLoadStatus level_loader_poll(LevelLoader* l, LoadedLevel* out);
+// Reload 'path' after it changed, against 'current' (the level loaded from
+// it, which must stay unchanged until the result is taken). The result is
+// a patch when the size is the same and at most 1 / LEVEL_LOADER_PATCH_SHARE
+// of the tiles changed, else a whole level.
+void level_loader_reload(LevelLoader* l, const char* path, const GridMap* current);
+// Hand a level back to be freed on the loader thread (*lvl is zeroed).
+void level_loader_release(LevelLoader* l, LoadedLevel* lvl);
+
+void loaded_level_fix(LoadedLevel* lvl);
+void loaded_level_free(LoadedLevel* lvl);
+
+#endif
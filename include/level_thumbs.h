@@ -0,0 +1,51 @@
+#ifndef LEVEL_THUMBS_H
+#define LEVEL_THUMBS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "map.h"
+
+// Top-down level thumbnails, made on worker threads and cached on disk as
+// "<cache_dir>/<content hash>.thumb", so a level is only read again when
+// its content changes. Requests come in two kinds: the items the caller
+// shows now (delivered through level_thumbs_take(), newest request only)
+// and a background list that is only rendered into the cache, after them.
+//
+// Pixels are canvas colors (color_to_u32), the minimap's palette: each
+// pixel blends the floor and wall colors by the walls it covers.
+#define LEVEL_THUMB_MAGIC   "CUB3DTHB"
+#define LEVEL_THUMB_VERSION 1
+#define LEVEL_THUMB_EXT     ".thumb"
+
+typedef struct LevelThumbs LevelThumbs;
+
+typedef struct LevelThumbJob {
+    size_t      item;      // caller's index, handed back with the result
+    const char* path;      // copied
+    uint64_t    hash;      // content hash (the cache key)
+} LevelThumbJob;
+
+typedef struct LevelThumb {
+    size_t    item;
+    int       w, h;        // fits size x size, map aspect kept
+    uint32_t* px;          // w * h, row-major; free()
+} LevelThumb;
+
+// 'size' is the longer side in pixels; threads <= 0 picks 2. NULL when out
+// of memory or no thread starts.
+LevelThumbs* level_thumbs_create(const char* cache_dir, int size, int threads);
+void         level_thumbs_destroy(LevelThumbs* t);
+
+// Replace the shown set: queued and finished thumbnails of the previous one
+// are dropped (one being rendered still lands in the cache).
+void level_thumbs_request(LevelThumbs* t, const LevelThumbJob* jobs, size_t n);
+// Add levels to render into the cache once the shown set is done.
+void level_thumbs_warm(LevelThumbs* t, const LevelThumbJob* jobs, size_t n);
+// Take one finished thumbnail of the current request. False when none.
+bool level_thumbs_take(LevelThumbs* t, LevelThumb* out);
+
+// Render 'm' into px (size * size capacity); returns the used w and h.
+void level_thumb_render(const GridMap* m, int size, uint32_t* px, int* out_w, int* out_h);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef LEVEL_WATCH_H
+#define LEVEL_WATCH_H
+
+#include <stdbool.h>
+
+// Notices when a level file is written, so an edited level can be reloaded
+// while it is played. On Linux it watches the file's directory with
+// inotify (editors that save through a rename replace the file's inode);
+// elsewhere it compares the file's mtime and size at most every
+// LEVEL_WATCH_POLL_MS.
+#ifndef LEVEL_WATCH_POLL_MS
+#define LEVEL_WATCH_POLL_MS 250
+#endif
+
+typedef struct LevelWatch LevelWatch;
+
+// Watch 'path' (copied). NULL when it cannot be watched.
+LevelWatch* level_watch_create(const char* path);
+void        level_watch_destroy(LevelWatch* w);
+
+// True once per burst of writes since the last call (never blocks).
+bool        level_watch_changed(LevelWatch* w);
+const char* level_watch_path(const LevelWatch* w);
+
+#endif
@@ -2,20 +2,97 @@
 #define MAP_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+/* Optional per-cell attribute planes, one byte per cell in the same
+   row-major layout as the tiles (structure of arrays: a pass that only
+   needs tiles never loads them). */
+typedef enum MapPlane {
+    MAP_PLANE_FLAGS = 0,    /* gameplay bits */
+    MAP_PLANE_DOOR,         /* door state (0 = closed .. 255 = open) */
+    MAP_PLANE_LIGHT,        /* light level */
+    MAP_PLANE_COUNT
+} MapPlane;
+
+/* SIMD walks read tiles and distance bytes with 32-bit gathers, so every
+   byte buffer of a GridMap is followed by this many readable bytes. */
+#define MAP_PAD 3
+
+/* Order of the per-cell byte buffers (tiles, planes, distance field).
+   Chunked maps store MAP_CHUNK x MAP_CHUNK chunks one after another, chunk
+   rows top to bottom, and the cells of a chunk in Morton (Z) order: every
+   aligned 8x8 square is one 64-byte line and a whole chunk is 1 KiB, so a
+   ray touches about as much memory heading north as heading east. Row
+   order pays a new line per step on north/south rays of wide maps. */
+typedef enum MapLayout {
+    MAP_LAYOUT_ROWS = 0,    /* data[y * w + x] */
+    MAP_LAYOUT_CHUNKED,
+} MapLayout;
+
+#ifndef MAP_CHUNK_LOG2
+#define MAP_CHUNK_LOG2 5    /* 32x32 chunks (at most 8: Morton codes below are 16-bit) */
+#endif
+#define MAP_CHUNK (1 << MAP_CHUNK_LOG2)
+
+/* Interleave the low 8 bits of v with zeros (x -> even bits). */
+static inline uint32_t map_morton_spread(uint32_t v) {
+    v &= 0xFFu;
+    v = (v | (v << 4)) & 0x0F0Fu;
+    v = (v | (v << 2)) & 0x3333u;
+    v = (v | (v << 1)) & 0x5555u;
+    return v;
+}
+
+/* Offset of in-map cell (x, y) in a byte buffer of a w-wide map. */
+static inline size_t map_index_in(MapLayout layout, int w, int x, int y) {
+    if (layout == MAP_LAYOUT_ROWS) return (size_t)y * (size_t)w + (size_t)x;
+    size_t cw = (size_t)((w + MAP_CHUNK - 1) >> MAP_CHUNK_LOG2);
+    size_t chunk = (size_t)(y >> MAP_CHUNK_LOG2) * cw + (size_t)(x >> MAP_CHUNK_LOG2);
+    return (chunk << (2 * MAP_CHUNK_LOG2))
+         | map_morton_spread((uint32_t)x & (MAP_CHUNK - 1))
+         | map_morton_spread((uint32_t)y & (MAP_CHUNK - 1)) << 1;
+}
+
 typedef struct {
     int w, h;
-    const int* data; /* row-major: data[y * w + x] */
+    MapLayout layout;    /* of data, plane[] and dist (rows unless converted) */
+    const uint8_t* data; /* tile ids, 0 = empty; see map_index() */
+    const uint8_t* plane[MAP_PLANE_COUNT]; /* NULL = plane absent (reads 0) */
+    const uint8_t* dist; /* optional, same layout: Chebyshev distance to the
+                            nearest wall (see map_dist.h); NULL = plain DDA */
+    const struct MapOcc* occ; /* optional bit-packed occupancy (see map_occ.h),
+                                 used by the DDA when there is no 'dist' */
 } GridMap;
 
+static inline size_t map_index(const GridMap* m, int x, int y) {
+    return map_index_in(m->layout, m->w, x, y);
+}
+
 int map_at(const GridMap* m, int x, int y);
 int map_is_wall(const GridMap* m, int x, int y);
+/* Attribute of cell (x, y); 0 outside the map or when the plane is absent. */
+int map_plane_at(const GridMap* m, MapPlane p, int x, int y);
+
+/* Heap bytes behind a GridMap, and what int tiles would have taken. */
+typedef struct MapMemory {
+    size_t tiles, planes, dist, occ;
+    size_t total;
+    size_t int_tiles;   /* w * h * sizeof(int): the old tile storage */
+} MapMemory;
+MapMemory map_memory(const GridMap* m);
+
+/* Bytes a w x h buffer takes in 'layout' (chunked maps round up to whole
+   chunks), without MAP_PAD. */
+size_t map_layout_bytes(MapLayout layout, int w, int h);
+/* Copy a w x h byte buffer from one layout into a new heap buffer (with
+   MAP_PAD, free()); NULL when out of memory. */
+uint8_t* map_convert_layout(const uint8_t* src, MapLayout from, MapLayout to, int w, int h);
 // int map_is_door(const GridMap* m, int x, int y);
 
 extern const int WORLD_W;
 extern const int WORLD_H;
-extern const int WORLD_DATA[]; /* exposed for init */
+extern const uint8_t WORLD_DATA[]; /* exposed for init */
 
 
 // Scan 'dir' for files ending with ".cub3d" (case-insensitive).
@@ -28,10 +105,15 @@ int map_list_levels(const char* dir, char*** out_paths, size_t* out_count);
 void map_free_paths(char** paths, size_t count);
 
 // Parse a simple .cub3d ASCII grid file (digits 0-9, spaces allowed).
-// Lines starting with '#' are ignored. All map rows must have the same width.
-// On success, returns 0 and sets *out_data (heap int[w*h]), *out_w, *out_h.
-// On failure, returns -1 and sets *out_err to a heap string (print+free).
-int map_parse_cub3d_file(const char* path, int** out_data, int* out_w, int* out_h, char** out_err);
+// Lines starting with '#' are ignored. All map rows must have the same width
+// (any length). Tile ids must fit a byte (0-255).
+// On success, returns 0 and sets *out_data (heap uint8_t[w*h + MAP_PAD]),
+// *out_w, *out_h. On failure, returns -1 and sets *out_err to a heap string
+// (print+free) that starts with "line L, column C:" for errors in the text.
+// The file is mapped (or read, when it cannot be) and parsed in one pass.
+int map_parse_cub3d_file(const char* path, uint8_t** out_data, int* out_w, int* out_h, char** out_err);
+// Same for 'len' bytes of text already in memory.
+int map_parse_cub3d(const char* text, size_t len, uint8_t** out_data, int* out_w, int* out_h, char** out_err);
 
 
 #endif
@@ -0,0 +1,89 @@
+#ifndef MAP_BIN_H
+#define MAP_BIN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "map.h"
+#include "map_dist.h"
+#include "map_occ.h"
+
+// Compiled levels (".cub3db", written by the cub3dc tool).
+//
+// A header, a section table, then the sections at MAP_BIN_ALIGN offsets:
+// the tile bytes exactly as GridMap::data holds them (in the header's
+// layout, followed by MAP_PAD zero bytes), the optional planes, and
+// optionally a prebuilt distance field and occupancy levels. Opening one
+// maps the file and points the GridMap into the mapping: nothing is parsed
+// or copied, and pages load on first touch. The mapping is private and
+// writable, so in-place tile edits and map_dist/occ updates stay local.
+//
+// Numbers are stored in host order; a file from a machine of the other
+// endianness fails the version check.
+#define MAP_BIN_MAGIC   "CUB3DBIN"
+#define MAP_BIN_VERSION 1
+#define MAP_BIN_EXT     ".cub3db"
+#define MAP_BIN_ALIGN   64
+#define MAP_BIN_MAX_SECTIONS (3 + MAP_PLANE_COUNT)
+
+typedef enum MapBinKind {
+    MAP_BIN_TILES  = 1,
+    MAP_BIN_DIST   = 2,    // MapDist::d, same layout as the tiles
+    MAP_BIN_OCC    = 3,    // MapOcc levels one after another
+    MAP_BIN_PLANE0 = 16,   // + MapPlane
+} MapBinKind;
+
+typedef struct MapBinSection {
+    uint32_t kind;         // MapBinKind
+    uint32_t reserved;
+    uint64_t offset;       // from the start of the file, MAP_BIN_ALIGN aligned
+    uint64_t bytes;        // without the MAP_PAD tail of byte sections
+} MapBinSection;
+
+typedef struct MapBinHeader {
+    char     magic[8];     // MAP_BIN_MAGIC, no terminator
+    uint32_t version;      // MAP_BIN_VERSION
+    uint32_t section_count;
+    int32_t  w, h;
+    uint8_t  tile_bytes;   // 1
+    uint8_t  layout;       // MapLayout of every byte section
+    uint8_t  chunk_log2;   // MAP_CHUNK_LOG2 of a chunked layout
+    uint8_t  occ_levels;   // MAP_OCC_LEVELS of the occupancy section
+    uint32_t dist_max;     // MapDist::max of the distance section
+    uint64_t file_bytes;
+    uint64_t payload_hash; // map_bin_hash() of everything after the table
+    uint64_t header_hash;  // of the header (with this field 0) and the table
+} MapBinHeader;
+
+typedef struct MapBin {
+    GridMap map;           // points into the mapping; map.occ points at 'occ'
+    MapDist dist;          // borrowed views, empty when the file has none
+    MapOcc  occ;
+    void*   base;          // the mapping (NULL when closed)
+    size_t  bytes;
+} MapBin;
+
+// Map 'path' and fill 'b'. 'verify' also checks the payload hash, which
+// reads the whole file; the header and section bounds are always checked.
+// Returns 0, or -1 with a message in *err (free()).
+int  map_bin_open(MapBin* b, const char* path, bool verify, char** err);
+void map_bin_close(MapBin* b);
+
+// Read and check the header and section table (MAP_BIN_MAX_SECTIONS
+// entries) without mapping the file, for readers that load sections
+// themselves. Returns the open file descriptor (close()), or -1 with *err.
+int  map_bin_read_table(const char* path, MapBinHeader* hd, MapBinSection* table, char** err);
+
+// Write 'm' (and 'dist' / 'occ' when not NULL and built for it) to 'path',
+// through a temporary file renamed into place. Returns 0 or -1 with *err.
+int  map_bin_write(const char* path, const GridMap* m, const MapDist* dist, const MapOcc* occ, char** err);
+
+// Compiled file next to a source: "a.cub3d" -> "a.cub3db" (a .cub3db path is
+// returned as is). free() the result.
+char* map_bin_path_for(const char* src);
+// True when 'bin' exists and is not older than 'src' (or 'src' is gone).
+bool  map_bin_is_fresh(const char* bin, const char* src);
+
+uint64_t map_bin_hash(const void* p, size_t n);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef MAP_DIST_H
+#define MAP_DIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "map.h"
+
+// Empty-space distance field for a GridMap: per cell, the Chebyshev
+// distance to the nearest wall (0 on walls, 1 next to one, capped at 255).
+// Cells outside the map count as walls, like map_at().
+//
+// A cell with distance d has no wall within d - 1 cells in any direction,
+// so the DDA can cross that whole square in one jump instead of visiting
+// each cell. Point GridMap::dist at 'd' to turn the jumps on.
+typedef struct MapDist {
+    int       w, h;
+    MapLayout layout; // of 'd': the map's, so one map_index() addresses both
+    uint8_t*  d;      // map_layout_bytes() (plus MAP_PAD bytes)
+    int       max;    // upper bound of every entry (bounds incremental updates)
+    bool      external; // 'd' is borrowed (a mapped level): free only forgets it
+} MapDist;
+
+// Build the field for 'm'. Returns 0, or -1 (f left empty) when out of memory.
+int  map_dist_build(MapDist* f, const GridMap* m);
+void map_dist_free(MapDist* f);
+
+// Refresh the field after tile (x, y) of 'm' changed in place. Only cells
+// within the largest distance of (x, y) are revisited. Returns false when
+// the change did not affect the field (still a wall / still empty).
+bool map_dist_update(MapDist* f, const GridMap* m, int x, int y);
+
+#endif
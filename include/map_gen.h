@@ -0,0 +1,50 @@
+#ifndef MAP_GEN_H
+#define MAP_GEN_H
+
+#include <stdint.h>
+#include "map.h"
+
+// Deterministic stress maps: the same config (seed included) gives the same
+// tiles on every platform. Every kind has border walls (tile 1) and keeps
+// the 3x3 cells around the center empty for the spawn.
+//
+//   open       single walls on 'density' of every 65536 cells: long rays,
+//              the most DDA steps without traversal structures
+//   pillars    2x2 pillars started on 'density' of every 65536 cells
+//   maze       a perfect maze of 1-cell corridors (sidewinder: one open row
+//              along the top); 'density' of every 65536 inner walls are
+//              knocked out again, adding loops
+//   corridors  east-west corridors 1-3 cells wide, the walls between them
+//              opened on 'density' of every 65536 cells (at least once per
+//              wall): long rays one way, short ones the other
+typedef enum MapGenKind {
+    MAP_GEN_OPEN = 0,
+    MAP_GEN_PILLARS,
+    MAP_GEN_MAZE,
+    MAP_GEN_CORRIDORS,
+    MAP_GEN_KIND_COUNT
+} MapGenKind;
+
+typedef struct MapGenConfig {
+    MapGenKind kind;
+    int        w, h;        // at least 3 x 3
+    uint32_t   seed;
+    int        density;     // per 65536, see the kinds; < 0 = the kind's default
+    int        tile_ids;    // walls use ids 1..tile_ids (1-255; 0 = 4)
+} MapGenConfig;
+
+// Row-major tiles (w * h plus MAP_PAD bytes, free()). NULL when out of
+// memory or the size is too small.
+uint8_t* map_gen(const MapGenConfig* cfg);
+
+// Kind by name ("open", "pillars", "maze", "corridors"); -1 when unknown.
+int         map_gen_kind(const char* name);
+const char* map_gen_kind_name(MapGenKind kind);
+// The kind's density when cfg->density < 0.
+int         map_gen_default_density(MapGenKind kind);
+
+// Write row-major tiles as a .cub3d source. Returns 0, or -1 with a message
+// in *err (free()).
+int map_gen_write_cub3d(const char* path, const uint8_t* tiles, int w, int h, char** err);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef MAP_OCC_H
+#define MAP_OCC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "map.h"
+
+// Bit-packed occupancy of a GridMap (1 = wall) with coarse levels.
+//
+// Level k has one bit per square of 8^k x 8^k cells (level 0 = cells), set
+// when the square holds any wall. Bits are packed by 8 x 8 tiles into one
+// 64-bit word, bit (y & 7) * 8 + (x & 7), so a level-k word is zero exactly
+// when its bit on level k + 1 is clear. Cells past the map edge read as
+// walls, like map_at(), which keeps every edge square occupied.
+//
+// The DDA tests walls with one bit instead of an int tile and steps out of
+// empty 8x8 / 64x64 squares in one jump; the int tile is only read for the
+// wall it finally hits. A 1024x1024 map takes 128 KiB of level-0 bits
+// against 4 MiB of tiles and 1 MiB of distance field. The distance field
+// takes bigger jumps, so the walk prefers it when a map has both.
+#ifndef MAP_OCC_LEVELS
+#define MAP_OCC_LEVELS 3
+#endif
+
+typedef struct MapOcc {
+    int       w, h;                          // map size in cells
+    int       words_w[MAP_OCC_LEVELS];       // 64-bit words per row of tiles
+    int       words_h[MAP_OCC_LEVELS];
+    uint64_t* level[MAP_OCC_LEVELS];
+    bool      external;                      // levels borrowed (a mapped level)
+} MapOcc;
+
+// Build the levels for 'm'. Returns 0, or -1 (o left empty) when out of memory.
+int    map_occ_build(MapOcc* o, const GridMap* m);
+void   map_occ_free(MapOcc* o);
+// Refresh the bits after tile (x, y) of 'm' changed in place.
+void   map_occ_update(MapOcc* o, const GridMap* m, int x, int y);
+size_t map_occ_bytes(const MapOcc* o);
+// Point 'o' at prebuilt levels for a w x h map, stored one after another
+// (map_occ_bytes() long). 'words' stays owned by the caller. Returns 0, or
+// -1 when 'bytes' does not match the map size.
+int    map_occ_view(MapOcc* o, int w, int h, uint64_t* words, size_t bytes);
+
+// Word and bit of unit (ux, uy) on 'level'.
+static inline size_t map_occ_word(const MapOcc* o, int level, int ux, int uy) {
+    return (size_t)(uy >> 3) * (size_t)o->words_w[level] + (size_t)(ux >> 3);
+}
+static inline int map_occ_shift(int ux, int uy) {
+    return ((uy & 7) << 3) | (ux & 7);
+}
+// Level-0 wall test for an in-map cell.
+static inline bool map_occ_wall(const MapOcc* o, int x, int y) {
+    return (o->level[0][map_occ_word(o, 0, x, y)] >> map_occ_shift(x, y)) & 1u;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef MAP_STREAM_H
+#define MAP_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "map.h"
+#include "types.h"
+
+// Out-of-core tiles for compiled levels too big to keep resident
+// (".cub3db", chunked layout, with occupancy levels).
+//
+// The GridMap's tile pointer addresses a reserved range as big as the
+// whole tile section, but only blocks of it (a run of whole map chunks,
+// at least a page) are resident: the ones around the camera, loaded before
+// a frame, and the ones along the view frustum, prefetched in the
+// background. A bounded LRU cache returns the rest to the system, only
+// inside map_stream_update() so no block goes away under a frame. A block
+// that is not resident reads as zeros, so map_at() and the raycaster run
+// unchanged: geometry always comes from the occupancy levels, which stay
+// resident (1 bit per cell), and only a far wall's tile id (its color or
+// texture) may show as wall 1, the raycaster's stand-in for a tile that
+// reads 0, until its block arrives.
+//
+// Tile edits to a streamed map are lost when their block is evicted.
+// Planes and the distance field are not streamed (absent).
+
+#ifndef MAP_STREAM_CACHE_BYTES
+#define MAP_STREAM_CACHE_BYTES (64u << 20)
+#endif
+
+typedef struct MapStreamConfig {
+    size_t cache_bytes;     // resident tile budget
+    size_t block_bytes;     // streaming unit, rounded up to pages and map chunks
+    int    near_cells;      // radius around the camera made resident before a frame
+    int    prefetch_cells;  // how far along the view frustum blocks are loaded ahead
+    bool   threaded;        // prefetch on a background thread (else a few per update)
+} MapStreamConfig;
+
+typedef struct MapStreamStats {
+    uint64_t hits;            // near blocks already resident
+    uint64_t misses;          // near blocks the frame had to wait for
+    uint64_t prefetched;      // blocks loaded ahead
+    uint64_t prefetch_used;   // ... and then needed near the camera before eviction
+    uint64_t evictions;
+    size_t   resident_bytes, peak_resident_bytes;
+    double   prefetch_accuracy;   // prefetch_used / prefetched
+} MapStreamStats;
+
+typedef struct MapStream MapStream;
+
+// Open 'path' for streaming (NULL cfg = defaults: MAP_STREAM_CACHE_BYTES,
+// 16 KiB blocks, 64 cells near, 512 ahead, threaded). NULL with *err
+// (free()) when it cannot be streamed.
+MapStream* map_stream_open(const char* path, const MapStreamConfig* cfg, char** err);
+void       map_stream_close(MapStream* s);
+
+// The streamed map (tiles and occupancy point into 's').
+GridMap    map_stream_map(const MapStream* s);
+// Before rendering a frame from 'cam': load the blocks near it and queue
+// the ones along the view for prefetch (superseding the last queue).
+// Returns the tile generation, which moves whenever a block was loaded or
+// evicted (tile bytes changed: a frame showing them is out of date).
+uint64_t   map_stream_update(MapStream* s, const Camera* cam);
+MapStreamStats map_stream_stats(MapStream* s);
+// Tile bytes of the whole map (what a resident copy would take).
+size_t     map_stream_tile_bytes(const MapStream* s);
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "MLX42/MLX42.h"
 #include "gui.h"
+#include "canvas.h"
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -18,6 +19,12 @@ typedef struct MenuBg {
     int     cell_w;
     int     cell_h;
     float*  cell_phase;   // size = grid_cols * grid_rows
+    struct CellLook {     // what each cell was last drawn with
+        uint32_t fill, outline, accent;
+        int      sq_x, side, accent_x;
+    } *cell_look;
+    uint8_t* cell_ripple; // per cell: bit 0 = a ripple crosses it this frame, bit 1 = last frame
+    bool    repaint;      // next render draws every cell
 
     // Ripples
     struct Ripple {
@@ -35,8 +42,13 @@ bool menu_bg_init(MenuBg* bg, int w, int h, unsigned seed);
 void menu_bg_resize(MenuBg* bg, int w, int h);
 /** Advance internal timers and motion */
 void menu_bg_update(MenuBg* bg, double now, float dt);
-/** Draw the animated background into dst (full-screen) */
-void menu_bg_render(MenuBg* bg, mlx_image_t* dst);
+/** Draw the animated background into dst (full-screen). Only cells whose
+    look changed or that a ripple crosses (now or last frame) are redrawn,
+    plus the strips the grid leaves at the edges; each redrawn rectangle is
+    recorded in 'dirty' (may be NULL). */
+void menu_bg_render(MenuBg* bg, mlx_image_t* dst, CanvasDirty* dirty);
+/** Redraw everything next time (something else drew into dst) */
+void menu_bg_invalidate(MenuBg* bg);
 /** Free all allocations */
 void menu_bg_free(MenuBg* bg);
 
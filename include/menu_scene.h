@@ -5,21 +5,22 @@
 #include "menu_bg.h"
 #include "gui.h"
 #include "gui_paged_grid.h"
+#include "level_catalog.h"
+#include "level_thumbs.h"
 
 typedef struct MenuScene {
     Scene        base;
 
-    Canvas       scene;      // offscreen menu canvas
-    MenuBg       bg;
+    MenuBg       bg;         // drawn straight into App->screen
 
     GuiContext   gui;
     GuiPagedGrid grid;
     mlx_texture_t* ui_item_skin;
     mlx_texture_t* ui_pager_skin;
 
-    // file list
-    char**  map_files;
-    size_t  map_file_count;
+    LevelCatalog catalog;    // levels in LEVELS_DIR
+    LevelThumbs* thumbs;     // thumbnail workers (NULL = labels only)
+    unsigned     thumbs_serial; // grid layout the requested thumbnails are for
 
     struct MapSelectUD* ud;  // forward-declared in .c
 } MenuScene;
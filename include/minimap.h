@@ -0,0 +1,41 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <stdbool.h>
+#include "canvas.h"
+#include "map.h"
+#include "types.h"
+
+// Top-down map at 'scale' pixels per cell, drawn from a view's (0,0)
+// (typically a view of the screen where the minimap goes).
+//
+// The wall layer of the cells the view shows is drawn once into a cached
+// canvas of the view's size (again when the map, scale or view size
+// changes, and cell by cell for tile edits). A frame then only copies back
+// what changed in the layer and what the old player marker covered, and
+// draws the marker and its facing line: the cost no longer grows with the
+// map. Walls come from the occupancy bits when the map has them, so a
+// streamed level's minimap does not wait for its tiles.
+
+typedef struct Minimap {
+    Canvas      layer;     // walls (heap, px NULL = not built)
+    CanvasDirty pending;   // layer.dirty: parts of the view to restore from it
+    int         scale;
+    const uint8_t* tiles;  // map the layer shows (by tile pointer and size; NULL = rebuild)
+    int         map_w, map_h;
+    CanvasRect  marker;    // player marker + facing line drawn last frame (w 0 = none)
+} Minimap;
+
+void minimap_init(Minimap* mm);
+void minimap_free(Minimap* mm);
+
+// The map was replaced (or changed wholesale): rebuild the layer.
+void minimap_invalidate(Minimap* mm);
+// Cell (x, y) was edited in place: redraw it in the layer.
+void minimap_update_tile(Minimap* mm, const GridMap* map, int x, int y);
+
+// Draw into 'view'. 'covered': something drew over the view since the
+// last call, so all of it is restored from the layer.
+void minimap_draw(Minimap* mm, Canvas* view, const GridMap* map, const Camera* cam, int scale, bool covered);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef RAY_CACHE_H
+#define RAY_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "map.h"
+#include "raycast_dda.h"
+#include "types.h"
+#include "worker_pool.h"
+
+// Ray results reused between frames while the camera only turns.
+//
+// Directions around the camera are split into bins by angle. The cache
+// holds the wall cell and side hit by the ray along each bin edge, cast
+// from the current camera position. When a screen column's two bin edges
+// end on the same grid line in the same or adjacent cells, the solid face
+// between them spans the wedge, so the column ends on it too and only
+// needs the exact distance to that line instead of a DDA walk. That holds
+// only while no wall fits between the edges: both edges crossed empty
+// cells only, so the wedge must also be narrower than a cell (far-away
+// hits on huge maps are cast). Columns whose edges disagree (silhouettes,
+// corners) or that land next to a cell corner, where float rounding could
+// make the DDA pick the neighbouring cell or face, are cast as usual.
+// Turning in place keeps every edge valid, so a frame only casts the edges
+// that rotated into view.
+//
+// Cached columns get the same wall cell and face as a full cast but
+// compute its distance directly, so they can differ from the uncached
+// frame in float rounding of the distance only.
+//
+// Any change of camera position, map (pointer or size) or screen width
+// drops the cache. Tile edits made in place must call ray_cache_invalidate().
+
+typedef struct RayCacheEdge {
+    int32_t  mapX, mapY;   // wall cell hit along the edge
+    int32_t  side;
+    uint32_t stamp;        // valid when equal to RayCache::stamp
+} RayCacheEdge;
+
+// Everything a rendered frame depends on besides tile contents. Zero it
+// before filling it in (it is compared bytewise).
+typedef struct RayCacheFrame {
+    Camera          cam;
+    const GridMap*  map;
+    const uint8_t*  map_data;
+    const uint8_t*  map_dist;
+    const void*     map_occ;
+    int             map_w, map_h;
+    const uint32_t* px;
+    int             w, h, layout, stride, mode;
+    const void*     tex[3];        // walls, floor, ceiling
+} RayCacheFrame;
+
+typedef struct RayCache {
+    RayCacheEdge*  edge;          // nbins edges (edge k starts bin k)
+    int            nbins;
+    uint32_t       stamp;
+    // what the edges are cast for
+    bool           keyed;
+    Vec2f          pos;
+    const GridMap* map;
+    const uint8_t* map_data;
+    int            map_w, map_h, screen_w;
+    // last rendered frame, for skipping identical frames
+    bool           have_frame;
+    RayCacheFrame  frame;
+} RayCache;
+
+#ifndef RAY_CACHE_BINS_PER_COLUMN
+#define RAY_CACHE_BINS_PER_COLUMN 1.3f   // at the widest bins (diagonals)
+#endif
+
+void ray_cache_init(RayCache* c);
+void ray_cache_free(RayCache* c);
+// Forget every edge and the last frame (call after editing map tiles).
+void ray_cache_invalidate(RayCache* c);
+// Forget only the last frame, keeping the edges (call when something else
+// was drawn over the canvas it is in).
+void ray_cache_forget_frame(RayCache* c);
+
+// True when 'f' matches the frame rendered last (which is then still in
+// the canvas); otherwise remembers 'f' and returns false.
+bool ray_cache_same_frame(RayCache* c, const RayCacheFrame* f);
+
+// Make every edge spanning the camera's view valid for this camera and map,
+// casting the missing ones on 'pool'. Returns the number of edge rays cast,
+// or -1 when the cache cannot be used for this frame: the first frame at a
+// new position only records it (a camera that keeps moving would pay for
+// the edges and never reuse them), and allocation failures.
+int  ray_cache_prepare(RayCache* c, const GridMap* map, const Camera* cam, int screen_w,
+                       WorkerPool* pool, bool simd);
+// Resolve the lanes of a set-up packet whose bin edges agree (side, tile,
+// mapX/Y and perpDist filled). Returns the mask of lanes still to cast.
+unsigned ray_cache_apply(const RayCache* c, RayPacket* p, const GridMap* map, Vec2f pos);
+
+#endif
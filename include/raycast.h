@@ -4,9 +4,79 @@
 #include "canvas.h"
 #include "map.h"
 #include "types.h"
+#include "worker_pool.h"
+#include "wall_tex.h"
+#include "ray_cache.h"
 
-void render_scene(Canvas* scene, const GridMap* map, const Camera* cam);
+typedef enum {
+    RAYCAST_SCALAR = 0,    // one DDA loop per column
+    RAYCAST_PACKET = 1,    // adjacent columns stepped together in SIMD lanes
+} RaycastMode;
 
-void draw_minimap(Canvas* mini, const GridMap* map, const Camera* cam, int scale);
+// Counters accumulated by render_scene() (reset them yourself).
+typedef struct RaycastStats {
+    uint64_t columns;         // columns rendered
+    uint64_t wall_texels;     // texture samples written for wall slices
+    uint64_t floor_texels;    // texture samples written for floor/ceiling rows
+    uint64_t cached_columns;  // columns resolved from the ray cache (no DDA walk)
+    uint64_t edge_rays;       // rays cast to fill the ray cache
+    uint64_t skipped_frames;  // render_scene calls that found nothing changed
+    uint64_t dda_steps;       // DDA iterations of the columns cast (jumps count as one)
+} RaycastStats;
+
+// Floor/ceiling row table kept across frames: render_scene() refills it
+// every frame and reallocates it only when the canvas gets taller. Zero it
+// before first use; raycast_rows_free() it when done.
+typedef struct RaycastRows {
+    uint32_t* mem;
+    int       cap;      // rows allocated
+} RaycastRows;
+
+// Per-renderer settings shared by every render_scene() call.
+typedef struct RaycastCtx {
+    WorkerPool*       pool;     // not owned; NULL = render on the calling thread
+    RaycastMode       mode;     // both modes produce identical frames
+    const WallTexSet* walls;    // not owned; NULL (or empty slot) = flat colors
+    const WallTex*    floor;    // not owned; NULL = flat floor color
+    const WallTex*    ceiling;  // not owned; NULL = flat sky color
+    RaycastStats*     stats;    // not owned; NULL = no counters
+    RayCache*         cache;    // not owned; NULL = cast every column, every frame
+    RaycastRows*      rows;     // not owned; NULL = a row table allocated per frame
+} RaycastCtx;
+
+// Columns handed to a worker are strips of this many pixels (keeps strip
+// edges on separate cache lines of a row-major framebuffer).
+#ifndef RAYCAST_STRIP_ALIGN
+#define RAYCAST_STRIP_ALIGN 16
+#endif
+// Strips per pool thread; >1 evens out columns that hit walls at different depths.
+#ifndef RAYCAST_STRIPS_PER_THREAD
+#define RAYCAST_STRIPS_PER_THREAD 4
+#endif
+// Row-major canvases cast floor/ceiling rows over spans of this many columns;
+// rows covered by a wall in every column of the span are skipped.
+#ifndef RAYCAST_FLOOR_SPAN
+#define RAYCAST_FLOOR_SPAN 64
+#endif
+
+// Render the 3D view into a row- or column-major canvas (column-major writes
+// every sky/wall/floor span contiguously, see canvas_init_transposed), or
+// a view into one (canvas_view) in place.
+// Floor and ceiling are cast per screen row: every row has one distance, so
+// texture coordinates are linear in x and both layouts sample the same texels.
+// Output does not depend on the thread count: every column is computed
+// independently and strips never overlap.
+// With a ray cache, a call whose camera, map, canvas and settings all match
+// the previous call returns at once (the canvas still holds that frame; do
+// not draw into it in between), and turning in place reuses ray hits.
+// A frame drawn marks the whole canvas (canvas_mark); a skipped one nothing.
+// When the row table cannot be allocated the frame is still drawn, with
+// flat floor and ceiling colors.
+void render_scene(Canvas* scene, const GridMap* map, const Camera* cam, const RaycastCtx* rc);
+
+void raycast_rows_free(RaycastRows* r);
+
+// Flat color of wall 'tile' (used when it has no texture).
+Color raycast_wall_color(int tile);
 
 #endif
@@ -0,0 +1,64 @@
+#ifndef RAYCAST_DDA_H
+#define RAYCAST_DDA_H
+
+#include "map.h"
+#include "types.h"
+
+// DDA traversal kernels used by render_scene(). Rays are kept in SoA form
+// so adjacent columns can be stepped together in SIMD lanes. Setup and the
+// final distance are shared scalar code, so the packet kernels only repeat
+// the exact same per-lane float adds/compares as the scalar loop and give
+// bit-identical hits.
+//
+// When the map carries a distance field (GridMap::dist), every kernel jumps
+// across the wall-free square around the current cell in one step: it
+// advances sideX/sideY by whole multiples of deltaX/deltaY, up to the last
+// crossing inside the square. Results match plain DDA up to float rounding
+// (k * delta instead of k repeated adds, which rounds less): on long rays
+// that graze a corner the two can end on different cells. Scalar and SIMD
+// casts still agree bit for bit.
+
+#define RAY_PACKET_MAX 8
+
+typedef struct RayPacket {
+    int   n;                          // live lanes (<= RAY_PACKET_MAX)
+    float rayDirX[RAY_PACKET_MAX], rayDirY[RAY_PACKET_MAX];
+    float deltaX[RAY_PACKET_MAX],  deltaY[RAY_PACKET_MAX];
+    float sideX[RAY_PACKET_MAX],   sideY[RAY_PACKET_MAX];
+    int   mapX[RAY_PACKET_MAX],    mapY[RAY_PACKET_MAX];
+    int   stepX[RAY_PACKET_MAX],   stepY[RAY_PACKET_MAX];
+    // results
+    int   side[RAY_PACKET_MAX];       // 0 = x-side, 1 = y-side
+    int   tile[RAY_PACKET_MAX];       // wall id that stopped the ray (> 0)
+    float perpDist[RAY_PACKET_MAX];
+    int   steps[RAY_PACKET_MAX];      // DDA iterations (cells or jumps), for stats
+} RayPacket;
+
+// Fill lanes for screen columns x0 .. x0+n-1 of a screen 'screen_w' wide.
+void ray_packet_setup(RayPacket* p, const Camera* cam, int x0, int n, int screen_w);
+// Fill lanes for n rays from 'pos' along arbitrary directions (not screen columns).
+void ray_packet_setup_dirs(RayPacket* p, Vec2f pos, const float* dirX, const float* dirY, int n);
+
+// Copy every field of lane i of src into lane j of dst (repacking lanes).
+void ray_packet_copy_lane(RayPacket* dst, int j, const RayPacket* src, int i);
+
+// Walk every lane to its hit and fill side/tile/perpDist.
+void ray_packet_cast_scalar(RayPacket* p, const GridMap* map);
+// Same result as the scalar cast, stepping lanes with SIMD where available.
+// Lanes that are still walking once the packet has diverged (fewer than
+// RAY_PACKET_MIN_ACTIVE left) are finished by the scalar loop.
+void ray_packet_cast_simd(RayPacket* p, const GridMap* map);
+// Both casts for the lanes set in the 'lanes' bit mask only; the other lanes
+// keep whatever side/tile/perpDist they already hold.
+void ray_packet_cast_scalar_lanes(RayPacket* p, const GridMap* map, unsigned lanes);
+void ray_packet_cast_simd_lanes(RayPacket* p, const GridMap* map, unsigned lanes);
+
+// Lanes stepped together by ray_packet_cast_simd() on this CPU
+// (8 with AVX2, 4 with SSE2 / WASM SIMD128, 1 when there is no SIMD path).
+int  ray_packet_width(void);
+
+#ifndef RAY_PACKET_MIN_ACTIVE
+#define RAY_PACKET_MIN_ACTIVE 2
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 #define SCENE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 struct App;
 
@@ -14,6 +15,7 @@ typedef struct Scene {
     void (*on_render)(struct Scene*);               // draw into App->screen
     void (*on_resize)(struct Scene*, int w, int h); // keep buffers sized
     void (*on_destroy)(struct Scene*);
+    void (*on_stats)(struct Scene*, char* buf, size_t n);  // one line for the stats overlay (optional)
 
     struct App* app;
 } Scene;
@@ -25,4 +27,5 @@ static inline void scene_update(Scene* s, double n, float dt)  { if (s && s->on_
 static inline void scene_render(Scene* s)                      { if (s && s->on_render) s->on_render(s); }
 static inline void scene_resize(Scene* s, int w, int h)        { if (s && s->on_resize) s->on_resize(s, w, h); }
 static inline void scene_destroy(Scene* s)                     { if (s && s->on_destroy) s->on_destroy(s); }
+static inline void scene_stats(Scene* s, char* b, size_t n)    { if (n) b[0] = '\0'; if (s && s->on_stats) s->on_stats(s, b, n); }
 #endif
\ No newline at end of file
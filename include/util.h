@@ -0,0 +1,23 @@
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+// Small helpers shared by the loaders, the level catalog and the tools.
+
+// Modification time of a struct stat in nanoseconds.
+#ifdef __APPLE__
+# define ST_MTIME_NS(st) ((int64_t)(st).st_mtimespec.tv_sec * 1000000000 + (st).st_mtimespec.tv_nsec)
+#else
+# define ST_MTIME_NS(st) ((int64_t)(st).st_mtim.tv_sec * 1000000000 + (st).st_mtim.tv_nsec)
+#endif
+
+// Formats a message into a new *err (free() it) when err is not NULL.
+// Always returns -1, so callers can 'return util_error(err, ...);'.
+int util_error(char** err, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Monotonic clock, milliseconds.
+double util_now_ms(void);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef WALL_TEX_H
+#define WALL_TEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+// Wall textures repacked for the raycaster: square, power-of-two, mip-mapped
+// and stored column-major, so one wall slice reads one contiguous texture
+// column. Texels use the Canvas pixel format (color_to_u32).
+
+#define WALL_TEX_SLOTS      10                     /* tile ids 0..9 (0 = empty) */
+#define WALL_TEX_MAX_LOG2   10                     /* 1024 x 1024 base level */
+#define WALL_TEX_MAX_LEVELS (WALL_TEX_MAX_LOG2 + 1)
+
+typedef struct WallTex {
+    uint32_t* texels;                       // all levels; NULL = no texture
+    int       log2;                         // level 0 is (1 << log2) texels square
+    int       levels;                       // level L is (1 << (log2 - L)) square
+    size_t    offset[WALL_TEX_MAX_LEVELS];  // start of each level in texels
+} WallTex;
+
+typedef struct WallTexSet {
+    WallTex tex[WALL_TEX_SLOTS];            // indexed by tile id
+} WallTexSet;
+
+// Repack an RGBA8 image (row-major bytes, e.g. mlx_texture_t::pixels).
+// Non power-of-two or non-square images are resampled (nearest) to the next
+// power of two of the larger side, capped at 1 << WALL_TEX_MAX_LOG2.
+bool   wall_tex_from_rgba(WallTex* t, const uint8_t* pixels, int w, int h);
+// Brick pattern tinted with 'base', (1 << log2) texels square.
+bool   wall_tex_procedural(WallTex* t, Color base, int log2);
+// Checkered floor tiles (two per side) tinted with 'base'.
+bool   wall_tex_tiles(WallTex* t, Color base, int log2);
+void   wall_tex_free(WallTex* t);
+size_t wall_tex_bytes(const WallTex* t);
+
+void   wall_tex_set_free(WallTexSet* s);
+size_t wall_tex_set_bytes(const WallTexSet* s);
+
+// Mip level for a slice showing 'texels_per_px' level-0 texels per screen
+// pixel: the finest level that does not skip texels.
+static inline int wall_tex_level(const WallTex* t, float texels_per_px) {
+    int level = 0;
+    while (texels_per_px >= 2.0f && level < t->levels - 1) { texels_per_px *= 0.5f; ++level; }
+    return level;
+}
+
+#endif
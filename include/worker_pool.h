@@ -0,0 +1,22 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+// Persistent pool of worker threads for data-parallel jobs (render strips, ...).
+// Threads are created once and sleep between jobs; a job is split into
+// 'count' independent tasks that are handed out to the workers and to the
+// calling thread, which blocks until every task has returned.
+typedef struct WorkerPool WorkerPool;
+
+// Task callback: process task 'index' of 'count'. Runs concurrently.
+typedef void (*WorkerTaskFn)(void* arg, int index, int count);
+
+// Total thread count (calling thread included). <= 0 = one per online CPU.
+WorkerPool* worker_pool_create(int threads);
+void        worker_pool_destroy(WorkerPool* p);
+int         worker_pool_threads(const WorkerPool* p);   // 1 for a NULL pool
+
+// Run fn(arg, i, count) for every i in [0, count) and wait for completion.
+// A NULL pool runs all tasks in order on the calling thread.
+void worker_pool_run(WorkerPool* p, WorkerTaskFn fn, void* arg, int count);
+
+#endif
@@ -1,4 +1,5 @@
 #include "app.h"
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -13,11 +14,13 @@ static void on_resize_hook(int32_t w, int32_t h, void* param) {
     // keep screen canvas exactly window-sized
     canvas_destroy(&app->screen);
     canvas_init(&app->screen, app->mlx, w, h);
+    app->screen.dirty = &app->damage;
     if (app->screen.img->count == 0) {
         if (mlx_image_to_window(app->mlx, app->screen.img, 0, 0) < 0) {
             puts(mlx_strerror(mlx_errno)); exit(EXIT_FAILURE);
         }
     }
+    dirty_overlay_resize(&app->overlay, w, h);
     // let all scenes react (so switching back later is instant)
     for (int i = 0; i < SCN_COUNT; ++i) {
         Scene* sc = app->sm.scenes[i];
@@ -33,10 +36,14 @@ static void loop(void* param) {
     app->last_time = now;
 
     Scene* sc = sm_active(&app->sm);
+    canvas_dirty_reset(&app->damage);
     if (sc) {
         scene_update(sc, now, dt);
         scene_render(sc);
     }
+    char status[160] = "";
+    if (dirty_overlay_shown(&app->overlay)) scene_stats(sc, status, sizeof(status));
+    dirty_overlay_frame(&app->overlay, &app->damage, app->screen.w, app->screen.h, now, status);
 
     // apply any requested scene change at safe point
     sm_process_switch(&app->sm);
@@ -53,6 +60,17 @@ App* app_create(int width, int height, const char* title) {
     if (mlx_image_to_window(app->mlx, app->screen.img, 0, 0) < 0) {
         puts(mlx_strerror(mlx_errno)); mlx_terminate(app->mlx); free(app); return NULL;
     }
+    app->screen.dirty = &app->damage;
+    dirty_overlay_init(&app->overlay, app->mlx);
+
+    int threads = RENDER_THREADS;
+    const char* env = getenv("RENDER_THREADS");
+    if (env && *env) threads = atoi(env);
+    app->pool = worker_pool_create(threads);
+    if (!app->pool) fprintf(stderr, "worker pool unavailable, rendering single-threaded\n");
+    app->verbose = APP_VERBOSE;
+    env = getenv("APP_VERBOSE");
+    if (env && *env) app->verbose = atoi(env) != 0;
 
     sm_init(&app->sm, app);
     app->last_time = mlx_get_time();
@@ -62,6 +80,15 @@ App* app_create(int width, int height, const char* title) {
     return app;
 }
 
+void app_log(const App* app, const char* fmt, ...) {
+    if (!app || !app->verbose) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
 void app_run(App* app) {
 #ifdef WEB
     g_mlx = app->mlx;
@@ -78,6 +105,8 @@ void app_destroy(App* app) {
         Scene* sc = app->sm.scenes[i];
         if (sc) scene_destroy(sc);
     }
+    worker_pool_destroy(app->pool);
+    dirty_overlay_free(&app->overlay);
     canvas_destroy(&app->screen);
     mlx_terminate(app->mlx);
     free(app);
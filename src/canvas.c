@@ -1,29 +1,124 @@
 #include "canvas.h"
+#include "canvas_ops.h"
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifndef HEADLESS
 int canvas_init(Canvas* c, mlx_t* mlx, int w, int h) {
     c->mlx = mlx; c->w = w; c->h = h;
+    c->layout = CANVAS_ROW_MAJOR;
+    c->stride = w;
+    c->dirty = NULL; c->ox = c->oy = 0;
     c->img = mlx_new_image(mlx, w, h);
+    c->px  = c->img ? (uint32_t*)c->img->pixels : NULL;
     return c->img ? 0 : -1;
 }
+#endif
+
+int canvas_init_heap(Canvas* c, int w, int h) {
+    c->mlx = NULL; c->img = NULL; c->w = w; c->h = h;
+    c->layout = CANVAS_ROW_MAJOR;
+    c->stride = w;
+    c->dirty = NULL; c->ox = c->oy = 0;
+    c->px = (uint32_t*)calloc((size_t)w * (size_t)h, sizeof(uint32_t));
+    return c->px ? 0 : -1;
+}
+
+int canvas_init_transposed(Canvas* c, int w, int h) {
+    int r = canvas_init_heap(c, w, h);
+    c->layout = CANVAS_COL_MAJOR;
+    c->stride = h;
+    return r;
+}
 
 void canvas_destroy(Canvas* c) {
+#ifndef HEADLESS
     if (c->img) {
         mlx_delete_image(c->mlx, c->img);
         c->img = NULL;
+        c->px = NULL;
+    }
+#endif
+    free(c->px);   // heap canvas (NULL otherwise)
+    c->px = NULL;
+}
+
+// ---------------- Dirty rectangles ----------------
+static int64_t rect_area(CanvasRect r) {
+    return (int64_t)r.w * (int64_t)r.h;
+}
+
+static CanvasRect rect_union(CanvasRect a, CanvasRect b) {
+    int x0 = a.x < b.x ? a.x : b.x, y0 = a.y < b.y ? a.y : b.y;
+    int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    CanvasRect u = { x0, y0, x1 - x0, y1 - y0 };
+    return u;
+}
+
+static int rects_overlap(CanvasRect a, CanvasRect b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// Merge when the union covers at most a quarter more than the two do.
+static int union_is_cheap(CanvasRect a, CanvasRect b) {
+    return rect_area(rect_union(a, b)) * 4 <= (rect_area(a) + rect_area(b)) * 5;
+}
+
+void canvas_dirty_reset(CanvasDirty* d) {
+    d->n = 0;
+}
+
+void canvas_dirty_add(CanvasDirty* d, int x, int y, int w, int h) {
+    if (!d || w <= 0 || h <= 0) return;
+    CanvasRect r = { x, y, w, h };
+    for (;;) {
+        int k = -1;
+        for (int i = 0; i < d->n && k < 0; ++i)
+            if (rects_overlap(r, d->r[i]) || union_is_cheap(r, d->r[i])) k = i;
+        if (k < 0 && d->n == CANVAS_DIRTY_MAX) {
+            int64_t best = INT64_MAX;
+            for (int i = 0; i < d->n; ++i) {
+                int64_t grow = rect_area(rect_union(r, d->r[i])) - rect_area(d->r[i]);
+                if (grow < best) { best = grow; k = i; }
+            }
+        }
+        if (k < 0) break;
+        r = rect_union(r, d->r[k]);   // may now overlap others: look again
+        d->r[k] = d->r[--d->n];
     }
+    d->r[d->n++] = r;
+}
+
+size_t canvas_dirty_area(const CanvasDirty* d) {
+    size_t n = 0;
+    for (int i = 0; i < d->n; ++i) n += (size_t)rect_area(d->r[i]);
+    return n;
+}
+
+bool canvas_dirty_hits(const CanvasDirty* d, int x, int y, int w, int h) {
+    CanvasRect r = { x, y, w, h };
+    for (int i = 0; i < d->n; ++i)
+        if (rects_overlap(r, d->r[i])) return true;
+    return false;
+}
+
+void canvas_mark(Canvas* c, int x, int y, int w, int h) {
+    if (!c->dirty) return;
+    int x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int x1 = x + w < c->w ? x + w : c->w, y1 = y + h < c->h ? y + h : c->h;
+    if (x0 < x1 && y0 < y1) canvas_dirty_add(c->dirty, c->ox + x0, c->oy + y0, x1 - x0, y1 - y0);
 }
 
 void canvas_put(Canvas* c, int x, int y, Color col) {
     if ((unsigned)x >= (unsigned)c->w || (unsigned)y >= (unsigned)c->h) return;
-    uint32_t* px = (uint32_t*)c->img->pixels;
-    px[y * c->w + x] = color_to_u32(col);
+    c->px[canvas_index(c, x, y)] = color_to_u32(col);
+    if (c->dirty) canvas_dirty_add(c->dirty, c->ox + x, c->oy + y, 1, 1);
 }
 
 void canvas_clear(Canvas* c, Color col) {
-    uint32_t* px = (uint32_t*)c->img->pixels;
-    uint32_t v = color_to_u32(col);
-    for (int i = 0; i < c->w * c->h; ++i) px[i] = v;
+    canvas_fill_rect(c, 0, 0, c->w, c->h, col);   // one span when packed
 }
 
 void canvas_fill_rect(Canvas* c, int x, int y, int w, int h, Color col) {
@@ -31,24 +126,190 @@ void canvas_fill_rect(Canvas* c, int x, int y, int w, int h, Color col) {
     int y0 = y < 0 ? 0 : y;
     int x1 = x + w; if (x1 > c->w) x1 = c->w;
     int y1 = y + h; if (y1 > c->h) y1 = c->h;
+    if (x0 >= x1 || y0 >= y1) return;
+    if (c->dirty) canvas_dirty_add(c->dirty, c->ox + x0, c->oy + y0, x1 - x0, y1 - y0);
     uint32_t v = color_to_u32(col);
-    uint32_t* px = (uint32_t*)c->img->pixels;
-    for (int yy = y0; yy < y1; ++yy) {
-        uint32_t* row = px + yy * c->w;
-        for (int xx = x0; xx < x1; ++xx) row[xx] = v;
+    if (c->layout == CANVAS_COL_MAJOR)   // columns are the rows here
+        canvas_ops_fill_rect(c->px + canvas_index(c, x0, y0), (size_t)c->stride, y1 - y0, x1 - x0, v);
+    else
+        canvas_ops_fill_rect(c->px + canvas_index(c, x0, y0), (size_t)c->stride, x1 - x0, y1 - y0, v);
+}
+
+// ---------------- Transposing present (column-major -> row-major) ----------------
+// Tile size of the transpose. Wide and short: a tile reads BH pixels from
+// each of BW columns and writes BH rows of BW pixels, so few pages are live
+// at once (TLB) and each dst row segment is written as whole cache lines.
+#ifndef CANVAS_TRANSPOSE_BW
+#define CANVAS_TRANSPOSE_BW 128
+#endif
+#ifndef CANVAS_TRANSPOSE_BH
+#define CANVAS_TRANSPOSE_BH 8
+#endif
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define CANVAS_HAVE_T4 1
+// 4 columns of 4 pixels (src, col stride ss) -> 4 rows of 4 pixels (dst, row stride ds)
+static inline void transpose4(uint32_t* d, size_t ds, const uint32_t* s, size_t ss) {
+    __m128i c0 = _mm_loadu_si128((const __m128i*)(s));
+    __m128i c1 = _mm_loadu_si128((const __m128i*)(s + ss));
+    __m128i c2 = _mm_loadu_si128((const __m128i*)(s + 2 * ss));
+    __m128i c3 = _mm_loadu_si128((const __m128i*)(s + 3 * ss));
+    __m128i t0 = _mm_unpacklo_epi32(c0, c1), t1 = _mm_unpacklo_epi32(c2, c3);
+    __m128i t2 = _mm_unpackhi_epi32(c0, c1), t3 = _mm_unpackhi_epi32(c2, c3);
+    _mm_storeu_si128((__m128i*)(d),          _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(d + ds),     _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(d + 2 * ds), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i*)(d + 3 * ds), _mm_unpackhi_epi64(t2, t3));
+}
+#elif defined(__wasm_simd128__)
+# include <wasm_simd128.h>
+# define CANVAS_HAVE_T4 1
+static inline void transpose4(uint32_t* d, size_t ds, const uint32_t* s, size_t ss) {
+    v128_t c0 = wasm_v128_load(s),          c1 = wasm_v128_load(s + ss);
+    v128_t c2 = wasm_v128_load(s + 2 * ss), c3 = wasm_v128_load(s + 3 * ss);
+    v128_t t0 = wasm_i32x4_shuffle(c0, c1, 0, 4, 1, 5), t1 = wasm_i32x4_shuffle(c2, c3, 0, 4, 1, 5);
+    v128_t t2 = wasm_i32x4_shuffle(c0, c1, 2, 6, 3, 7), t3 = wasm_i32x4_shuffle(c2, c3, 2, 6, 3, 7);
+    wasm_v128_store(d,          wasm_i64x2_shuffle(t0, t1, 0, 2));
+    wasm_v128_store(d + ds,     wasm_i64x2_shuffle(t0, t1, 1, 3));
+    wasm_v128_store(d + 2 * ds, wasm_i64x2_shuffle(t2, t3, 0, 2));
+    wasm_v128_store(d + 3 * ds, wasm_i64x2_shuffle(t2, t3, 1, 3));
+}
+#endif
+
+// Copy a w x h block from column-major 's' (column stride ss) into
+// row-major 'd' (row stride ds), one cache-sized tile at a time.
+static void transpose_blocked(uint32_t* d, size_t ds, const uint32_t* s, size_t ss, int w, int h) {
+    const int BW = CANVAS_TRANSPOSE_BW, BH = CANVAS_TRANSPOSE_BH;
+    for (int by = 0; by < h; by += BH) {
+        int bh = (h - by < BH) ? h - by : BH;
+        for (int bx = 0; bx < w; bx += BW) {
+            int bw = (w - bx < BW) ? w - bx : BW;
+            int x = 0;
+#if defined(CANVAS_HAVE_T4)
+            for (; x + 4 <= bw; x += 4) {
+                int y = 0;
+                for (; y + 4 <= bh; y += 4)
+                    transpose4(d + (size_t)(by + y) * ds + bx + x, ds,
+                               s + (size_t)(bx + x) * ss + by + y, ss);
+                for (; y < bh; ++y)
+                    for (int i = 0; i < 4; ++i)
+                        d[(size_t)(by + y) * ds + bx + x + i] = s[(size_t)(bx + x + i) * ss + by + y];
+            }
+#endif
+            for (; x < bw; ++x)
+                for (int y = 0; y < bh; ++y)
+                    d[(size_t)(by + y) * ds + bx + x] = s[(size_t)(bx + x) * ss + by + y];
+        }
     }
 }
 
 void canvas_copy(Canvas* dst, const Canvas* src, int dx, int dy) {
-    int w = src->w, h = src->h;
-    for (int y = 0; y < h; ++y) {
-        int ty = y + dy;
-        if ((unsigned)ty >= (unsigned)dst->h) continue;
-        for (int x = 0; x < w; ++x) {
-            int tx = x + dx;
-            if ((unsigned)tx >= (unsigned)dst->w) continue;
-            ((uint32_t*)dst->img->pixels)[ty * dst->w + tx] =
-                ((uint32_t*)src->img->pixels)[y * src->w + x];
+    // clip once, then walk the visible block
+    int x0 = dx < 0 ? -dx : 0, y0 = dy < 0 ? -dy : 0;
+    int x1 = src->w, y1 = src->h;
+    if (x1 > dst->w - dx) x1 = dst->w - dx;
+    if (y1 > dst->h - dy) y1 = dst->h - dy;
+    if (x0 >= x1 || y0 >= y1) return;
+    if (dst->dirty) canvas_dirty_add(dst->dirty, dst->ox + x0 + dx, dst->oy + y0 + dy, x1 - x0, y1 - y0);
+    if (src->layout == dst->layout) {
+        if (src->layout == CANVAS_COL_MAJOR)
+            canvas_ops_copy_rect(dst->px + canvas_index(dst, x0 + dx, y0 + dy), (size_t)dst->stride,
+                                 src->px + canvas_index(src, x0, y0), (size_t)src->stride,
+                                 y1 - y0, x1 - x0);
+        else
+            canvas_ops_copy_rect(dst->px + canvas_index(dst, x0 + dx, y0 + dy), (size_t)dst->stride,
+                                 src->px + canvas_index(src, x0, y0), (size_t)src->stride,
+                                 x1 - x0, y1 - y0);
+        return;
+    }
+    if (src->layout == CANVAS_COL_MAJOR) {
+        transpose_blocked(dst->px + canvas_index(dst, x0 + dx, y0 + dy), (size_t)dst->stride,
+                          src->px + canvas_index(src, x0, y0), (size_t)src->stride,
+                          x1 - x0, y1 - y0);
+        return;
+    }
+    for (int x = x0; x < x1; ++x)
+        for (int y = y0; y < y1; ++y)
+            dst->px[canvas_index(dst, x + dx, y + dy)] = src->px[canvas_index(src, x, y)];
+}
+
+// ---------------- Scaled present (dynamic resolution) ----------------
+// Nearest neighbour in 16.16 steps. Each distinct source row is resampled
+// once; destination rows that map to the same source row are memcpy'd.
+// Only the part of the dw x dh rectangle inside 'clip' (same coordinates)
+// is written.
+static void copy_scaled(Canvas* dst, const Canvas* src, int dx, int dy, int dw, int dh, CanvasRect clip) {
+    if (dw == src->w && dh == src->h) {
+        int cx = clip.x < 0 ? 0 : clip.x, cy = clip.y < 0 ? 0 : clip.y;
+        Canvas part = canvas_view(src, clip.x, clip.y, clip.w, clip.h);
+        canvas_copy(dst, &part, dx + cx, dy + cy);
+        return;
+    }
+    if (src->w <= 0 || src->h <= 0) return;
+    int x0 = dx < 0 ? -dx : 0, y0 = dy < 0 ? -dy : 0;
+    int x1 = dw, y1 = dh;
+    if (x1 > dst->w - dx) x1 = dst->w - dx;
+    if (y1 > dst->h - dy) y1 = dst->h - dy;
+    if (x0 < clip.x) x0 = clip.x;
+    if (y0 < clip.y) y0 = clip.y;
+    if (x1 > clip.x + clip.w) x1 = clip.x + clip.w;
+    if (y1 > clip.y + clip.h) y1 = clip.y + clip.h;
+    if (x0 >= x1 || y0 >= y1) return;
+    if (dst->dirty) canvas_dirty_add(dst->dirty, dst->ox + x0 + dx, dst->oy + y0 + dy, x1 - x0, y1 - y0);
+
+    uint32_t xstep = (uint32_t)(((uint64_t)src->w << 16) / (uint64_t)dw);
+    uint32_t ystep = (uint32_t)(((uint64_t)src->h << 16) / (uint64_t)dh);
+    if (dst->layout != CANVAS_ROW_MAJOR) {
+        for (int y = y0; y < y1; ++y)
+            for (int x = x0; x < x1; ++x)
+                dst->px[canvas_index(dst, x + dx, y + dy)] =
+                    src->px[canvas_index(src, (int)(((uint64_t)x * xstep) >> 16), (int)(((uint64_t)y * ystep) >> 16))];
+        return;
+    }
+
+    size_t sstride = src->layout == CANVAS_COL_MAJOR ? (size_t)src->stride : 1;
+    const uint32_t* prev = NULL;
+    int prev_sy = -1;
+    for (int y = y0; y < y1; ++y) {
+        int sy = (int)(((uint64_t)y * ystep) >> 16);
+        uint32_t* d = dst->px + (size_t)(y + dy) * dst->stride + dx;
+        if (sy == prev_sy) {
+            memcpy(d + x0, prev + x0, (size_t)(x1 - x0) * sizeof(uint32_t));
+            continue;
+        }
+        const uint32_t* s = src->px + (src->layout == CANVAS_COL_MAJOR ? (size_t)sy : (size_t)sy * src->stride);
+        uint32_t sx = (uint32_t)x0 * xstep;
+        for (int x = x0; x < x1; ++x, sx += xstep) d[x] = s[(size_t)(sx >> 16) * sstride];
+        prev = d;
+        prev_sy = sy;
+    }
+}
+
+void canvas_copy_scaled(Canvas* dst, const Canvas* src, int dx, int dy, int dw, int dh) {
+    CanvasRect all = { 0, 0, dw, dh };
+    copy_scaled(dst, src, dx, dy, dw, dh, all);
+}
+
+// dst coordinates (of the dw-wide rectangle) that may sample source [lo, hi):
+// generous by a pixel or two for the rounding of the 16.16 step.
+static void scaled_span(int lo, int hi, int sn, int dn, int* d0, int* d1) {
+    *d0 = (int)((int64_t)lo * dn / sn) - 1;
+    *d1 = (int)(((int64_t)(hi + 2) * dn + sn - 1) / sn);
+    if (*d0 < 0) *d0 = 0;
+    if (*d1 > dn) *d1 = dn;
+}
+
+void canvas_composite(Canvas* dst, const Canvas* src, CanvasDirty* d, int dx, int dy, int dw, int dh) {
+    for (int i = 0; i < d->n && src->w > 0 && src->h > 0; ++i) {
+        CanvasRect r = d->r[i], clip = r;
+        if (dw != src->w || dh != src->h) {
+            int x0, x1, y0, y1;
+            scaled_span(r.x, r.x + r.w, src->w, dw, &x0, &x1);
+            scaled_span(r.y, r.y + r.h, src->h, dh, &y0, &y1);
+            clip = (CanvasRect){ x0, y0, x1 - x0, y1 - y0 };
         }
+        copy_scaled(dst, src, dx, dy, dw, dh, clip);
     }
+    canvas_dirty_reset(d);
 }
@@ -0,0 +1,179 @@
+#include "canvas_ops.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+# include <wasm_simd128.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+# include <immintrin.h>
+# define CANVAS_OPS_HAVE_AVX2 1
+#endif
+
+// Spans shorter than this are filled inline (minimap cells, UI borders):
+// the dispatch would cost more than the stores.
+#ifndef CANVAS_OPS_SHORT_SPAN
+#define CANVAS_OPS_SHORT_SPAN 16
+#endif
+
+typedef void (*FillFn)(uint32_t* d, size_t n, uint32_t v);
+
+typedef struct FillImpl {
+    const char* name;
+    FillFn      fn;
+} FillImpl;
+
+static void fill_scalar(uint32_t* d, size_t n, uint32_t v) {
+    for (size_t i = 0; i < n; ++i) d[i] = v;
+}
+
+// The vector fills store aligned: a scalar head up to the vector boundary,
+// four vectors per iteration, then one at a time and a scalar tail.
+#if defined(__SSE2__)
+static void fill_sse2(uint32_t* d, size_t n, uint32_t v) {
+    for (; n && ((uintptr_t)d & 15); --n) *d++ = v;
+    __m128i x = _mm_set1_epi32((int)v);
+    for (; n >= 16; n -= 16, d += 16) {
+        _mm_store_si128((__m128i*)d, x);
+        _mm_store_si128((__m128i*)(d + 4), x);
+        _mm_store_si128((__m128i*)(d + 8), x);
+        _mm_store_si128((__m128i*)(d + 12), x);
+    }
+    for (; n >= 4; n -= 4, d += 4) _mm_store_si128((__m128i*)d, x);
+    for (; n; --n) *d++ = v;
+}
+#elif defined(__ARM_NEON)
+static void fill_neon(uint32_t* d, size_t n, uint32_t v) {
+    for (; n && ((uintptr_t)d & 15); --n) *d++ = v;
+    uint32x4_t x = vdupq_n_u32(v);
+    for (; n >= 16; n -= 16, d += 16) {
+        vst1q_u32(d, x);
+        vst1q_u32(d + 4, x);
+        vst1q_u32(d + 8, x);
+        vst1q_u32(d + 12, x);
+    }
+    for (; n >= 4; n -= 4, d += 4) vst1q_u32(d, x);
+    for (; n; --n) *d++ = v;
+}
+#elif defined(__wasm_simd128__)
+static void fill_wasm(uint32_t* d, size_t n, uint32_t v) {
+    for (; n && ((uintptr_t)d & 15); --n) *d++ = v;
+    v128_t x = wasm_i32x4_splat((int32_t)v);
+    for (; n >= 16; n -= 16, d += 16) {
+        wasm_v128_store(d, x);
+        wasm_v128_store(d + 4, x);
+        wasm_v128_store(d + 8, x);
+        wasm_v128_store(d + 12, x);
+    }
+    for (; n >= 4; n -= 4, d += 4) wasm_v128_store(d, x);
+    for (; n; --n) *d++ = v;
+}
+#endif
+
+#if defined(CANVAS_OPS_HAVE_AVX2)
+__attribute__((target("avx2")))
+static void fill_avx2(uint32_t* d, size_t n, uint32_t v) {
+    for (; n && ((uintptr_t)d & 31); --n) *d++ = v;
+    __m256i x = _mm256_set1_epi32((int)v);
+    for (; n >= 32; n -= 32, d += 32) {
+        _mm256_store_si256((__m256i*)d, x);
+        _mm256_store_si256((__m256i*)(d + 8), x);
+        _mm256_store_si256((__m256i*)(d + 16), x);
+        _mm256_store_si256((__m256i*)(d + 24), x);
+    }
+    for (; n >= 8; n -= 8, d += 8) _mm256_store_si256((__m256i*)d, x);
+    for (; n; --n) *d++ = v;
+}
+
+static int cpu_has_avx2(void) { return __builtin_cpu_supports("avx2"); }
+#endif
+
+// Best first.
+static const FillImpl FILLS[] = {
+#if defined(CANVAS_OPS_HAVE_AVX2)
+    { "avx2", fill_avx2 },
+#endif
+#if defined(__SSE2__)
+    { "sse2", fill_sse2 },
+#elif defined(__ARM_NEON)
+    { "neon", fill_neon },
+#elif defined(__wasm_simd128__)
+    { "wasm-simd128", fill_wasm },
+#endif
+    { "scalar", fill_scalar },
+};
+#define FILL_COUNT (sizeof(FILLS) / sizeof(FILLS[0]))
+
+static int usable(const FillImpl* f) {
+#if defined(CANVAS_OPS_HAVE_AVX2)
+    if (f->fn == fill_avx2) return cpu_has_avx2();
+#endif
+    (void)f;
+    return 1;
+}
+
+// Picked on the first fill and kept (render workers may race to pick: they
+// all pick the same one).
+static const FillImpl* g_fill;
+
+static const FillImpl* startup_fill(void) {
+    for (size_t i = 0; i < FILL_COUNT; ++i)
+        if (usable(&FILLS[i])) return &FILLS[i];
+    return &FILLS[FILL_COUNT - 1];
+}
+
+static const FillImpl* fill_impl(void) {
+    const FillImpl* f = __atomic_load_n(&g_fill, __ATOMIC_ACQUIRE);
+    if (!f) {
+        f = startup_fill();
+        __atomic_store_n(&g_fill, f, __ATOMIC_RELEASE);
+    }
+    return f;
+}
+
+const char* canvas_ops_isa(void) {
+    return fill_impl()->name;
+}
+
+int canvas_ops_select(const char* isa) {
+    const FillImpl* f = NULL;
+    if (!isa) f = startup_fill();
+    for (size_t i = 0; !f && i < FILL_COUNT; ++i)
+        if (strcmp(FILLS[i].name, isa) == 0 && usable(&FILLS[i])) f = &FILLS[i];
+    if (!f) return -1;
+    __atomic_store_n(&g_fill, f, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void canvas_ops_fill(uint32_t* d, size_t n, uint32_t v) {
+    if (n < CANVAS_OPS_SHORT_SPAN) {
+        for (size_t i = 0; i < n; ++i) d[i] = v;
+        return;
+    }
+    fill_impl()->fn(d, n, v);
+}
+
+void canvas_ops_fill_rect(uint32_t* d, size_t ds, int w, int h, uint32_t v) {
+    if (w <= 0 || h <= 0) return;
+    if (ds == (size_t)w) { canvas_ops_fill(d, (size_t)w * (size_t)h, v); return; }
+    if ((size_t)w < CANVAS_OPS_SHORT_SPAN) {
+        for (int y = 0; y < h; ++y, d += ds)
+            for (int x = 0; x < w; ++x) d[x] = v;
+        return;
+    }
+    FillFn fn = fill_impl()->fn;
+    for (int y = 0; y < h; ++y, d += ds) fn(d, (size_t)w, v);
+}
+
+void canvas_ops_copy_rect(uint32_t* d, size_t ds, const uint32_t* s, size_t ss, int w, int h) {
+    if (w <= 0 || h <= 0) return;
+    if (ds == (size_t)w && ss == (size_t)w) {
+        memcpy(d, s, (size_t)w * (size_t)h * sizeof(uint32_t));
+        return;
+    }
+    for (int y = 0; y < h; ++y, d += ds, s += ss) memcpy(d, s, (size_t)w * sizeof(uint32_t));
+}
@@ -0,0 +1,75 @@
+#include "dirty_overlay.h"
+#include "gui.h"
+#include <stdio.h>
+#include <string.h>
+
+void dirty_overlay_init(DirtyOverlay* o, mlx_t* mlx) {
+    memset(o, 0, sizeof(*o));
+    o->mlx = mlx;
+}
+
+static void hide(DirtyOverlay* o) {
+    if (o->img)  mlx_delete_image(o->mlx, o->img);
+    if (o->text) mlx_delete_image(o->mlx, o->text);
+    if (o->status) mlx_delete_image(o->mlx, o->status);
+    o->img = o->text = o->status = NULL;
+    o->shown.n = 0;
+}
+
+void dirty_overlay_free(DirtyOverlay* o) {
+    hide(o);
+}
+
+static bool show(DirtyOverlay* o, int w, int h) {
+    o->img = mlx_new_image(o->mlx, (uint32_t)w, (uint32_t)h);   // zeroed: transparent
+    if (!o->img || mlx_image_to_window(o->mlx, o->img, 0, 0) < 0) {
+        hide(o);
+        return false;
+    }
+    o->text_at = 0.0;
+    o->pushed = 0;
+    o->frames = 0;
+    return true;
+}
+
+void dirty_overlay_resize(DirtyOverlay* o, int w, int h) {
+    if (!o->img) return;
+    hide(o);
+    show(o, w, h);
+}
+
+void dirty_overlay_frame(DirtyOverlay* o, const CanvasDirty* d, int w, int h, double now, const char* status) {
+    bool down = mlx_is_key_down(o->mlx, DIRTY_OVERLAY_KEY);
+    if (down && !o->key_down) {
+        if (o->img) hide(o);
+        else        show(o, w, h);
+    }
+    o->key_down = down;
+    if (!o->img) return;
+
+    // only the outlines change: erase last frame's, draw this frame's
+    for (int i = 0; i < o->shown.n; ++i) {
+        CanvasRect r = o->shown.r[i];
+        gui_draw_rect(o->img, r.x, r.y, r.w, r.h, 0);
+    }
+    o->shown = *d;
+    for (int i = 0; i < d->n; ++i) {
+        CanvasRect r = d->r[i];
+        gui_draw_rect(o->img, r.x, r.y, r.w, r.h, gui_rgba(0, 255, 0, 200));
+    }
+
+    o->pushed += canvas_dirty_area(d);
+    o->frames++;
+    if ((now - o->text_at) * 1000.0 < DIRTY_OVERLAY_TEXT_MS) return;
+    char buf[96];
+    double per = (double)o->pushed / (double)o->frames;
+    snprintf(buf, sizeof(buf), "%.0f px pushed/frame (%.1f%%)", per,
+             w > 0 && h > 0 ? 100.0 * per / ((double)w * (double)h) : 0.0);
+    if (o->text) mlx_delete_image(o->mlx, o->text);
+    o->text = mlx_put_string(o->mlx, buf, 8, h - 24);
+    if (o->status) mlx_delete_image(o->mlx, o->status);
+    o->status = status && *status ? mlx_put_string(o->mlx, status, 8, h - 48) : NULL;
+    o->text_at = now;
+    o->pushed = 0;
+    o->frames = 0;
+}
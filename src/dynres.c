@@ -0,0 +1,57 @@
+#include "dynres.h"
+#include <stddef.h>
+
+#define DYNRES_SMOOTHING 0.1f     /* weight of the newest dt */
+#define DYNRES_MAX_WAIT  16       /* up_wait stops at up_frames * this */
+#define DYNRES_NEVER     (1 << 30) /* since_up before the first raise */
+
+void dynres_init(DynRes* d, const DynResConfig* cfg) {
+    static const DynResConfig defaults = {
+        DYNRES_BUDGET_MS / 1000.0f, 0.5f, 0.125f, 1.2f, 10, 1.05f, 120
+    };
+    d->cfg = cfg ? *cfg : defaults;
+    d->enabled = false;
+    d->scale = 1.0f;
+    d->avg = d->cfg.budget;
+    d->over = d->under = 0;
+    d->up_wait = d->cfg.up_frames;
+    d->since_up = DYNRES_NEVER;
+}
+
+bool dynres_update(DynRes* d, float dt) {
+    if (!d->enabled || dt <= 0.0f) return false;
+    d->avg += (dt - d->avg) * DYNRES_SMOOTHING;
+    if (d->since_up < DYNRES_NEVER) d->since_up++;
+
+    d->over  = d->avg > d->cfg.budget * d->cfg.down_ratio ? d->over + 1 : 0;
+    d->under = d->avg < d->cfg.budget * d->cfg.up_ratio ? d->under + 1 : 0;
+
+    if (d->over >= d->cfg.down_frames && d->scale > d->cfg.min_scale) {
+        // a raise that did not hold: wait longer before probing again
+        if (d->since_up < d->up_wait && d->up_wait < d->cfg.up_frames * DYNRES_MAX_WAIT)
+            d->up_wait *= 2;
+        d->scale -= d->cfg.step;
+        if (d->scale < d->cfg.min_scale) d->scale = d->cfg.min_scale;
+        d->over = d->under = 0;
+        d->avg = d->cfg.budget;     // let the new scale show its own timing
+        return true;
+    }
+    if (d->under >= d->up_wait && d->scale < 1.0f) {
+        d->scale += d->cfg.step;
+        if (d->scale > 1.0f) d->scale = 1.0f;
+        d->over = d->under = 0;
+        d->since_up = 0;
+        return true;
+    }
+    return false;
+}
+
+void dynres_size(const DynRes* d, int w, int h, int* sw, int* sh) {
+    float s = d->enabled ? d->scale : 1.0f;
+    *sw = (int)((float)w * s + 0.5f);
+    *sh = (int)((float)h * s + 0.5f);
+    if (*sw < 1) *sw = 1;
+    if (*sh < 1) *sh = 1;
+    if (*sw > w) *sw = w;
+    if (*sh > h) *sh = h;
+}
@@ -1,61 +1,254 @@
 #include "game_scene.h"
 #include "app.h"
 #include "raycast.h"
+#include "gui.h"
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
 
+static void scene_buffer_init(GameScene* gs, mlx_t* mlx, int w, int h) {
+#if GAME_SCENE_COL_MAJOR
+    (void)mlx;
+    canvas_init_transposed(&gs->scene, w, h);
+#else
+    canvas_init(&gs->scene, mlx, w, h);
+#endif
+    canvas_dirty_reset(&gs->scene_dirty);
+    gs->scene.dirty = &gs->scene_dirty;
+}
+
+static bool load_png_tex(GuiContext* ctx, char* name, WallTex* t) {
+    mlx_texture_t* tex = gui_load_png_from_paths(ctx, name);
+    bool ok = false;
+    if (tex && tex->bytes_per_pixel == 4)
+        ok = wall_tex_from_rgba(t, tex->pixels, (int)tex->width, (int)tex->height);
+    if (tex) mlx_delete_texture(tex);
+    return ok;
+}
+
+// Wall textures: assets/textures/wall<N>.png for tile N, else a procedural
+// brick pattern in the tile's flat color. floor.png falls back to procedural
+// tiles; without ceiling.png the sky stays flat.
+static void load_wall_textures(GameScene* gs) {
+    GuiContext ctx = { .mlx = gs->base.app->mlx, .now = 0.0, .paths = NULL, .paths_len = 0 };
+    gui_paths_add(&ctx, "assets/textures");
+    gui_paths_add(&ctx, "assets");
+    for (int i = 1; i < WALL_TEX_SLOTS; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "wall%d.png", i);
+        if (!load_png_tex(&ctx, name, &gs->walls.tex[i]))
+            wall_tex_procedural(&gs->walls.tex[i], raycast_wall_color(i), 6);
+    }
+    if (!load_png_tex(&ctx, "floor.png", &gs->floor_tex))
+        wall_tex_tiles(&gs->floor_tex, rgba(110, 100, 90, 255), 6);
+    load_png_tex(&ctx, "ceiling.png", &gs->ceil_tex);
+    for (unsigned i = 0; i < ctx.paths_len; ++i) free(ctx.paths[i]);
+    free(ctx.paths);
+}
+
+static void set_textures(GameScene* gs, bool on) {
+    gs->rc.walls   = on ? &gs->walls : NULL;
+    gs->rc.floor   = on ? &gs->floor_tex : NULL;
+    gs->rc.ceiling = on ? &gs->ceil_tex : NULL;
+}
+
+// Build the traversal structures gs->map does not have yet (a compiled
+// level may bring them); without them the DDA steps cell by cell.
+static void build_map_accel(GameScene* gs) {
+    if (!gs->map.occ && map_occ_build(&gs->map_occ, &gs->map) == 0) gs->map.occ = &gs->map_occ;
+    if (!gs->map.dist && (size_t)gs->map.w * (size_t)gs->map.h <= (size_t)GAME_SCENE_DIST_MAX_CELLS
+        && map_dist_build(&gs->map_dist, &gs->map) == 0)
+        gs->map.dist = gs->map_dist.d;
+}
+
+// The current level as the loader holds one (nothing owned for the
+// built-in world's tiles); gs is left without a map.
+static LoadedLevel take_current(GameScene* gs) {
+    LoadedLevel cur = { .map = gs->map, .level = gs->level, .stream = gs->stream,
+                        .dist = gs->map_dist, .occ = gs->map_occ };
+    if (!gs->level.base && !gs->stream && gs->map.data != WORLD_DATA) cur.tiles = (uint8_t*)gs->map.data;
+    gs->stream = NULL;
+    memset(&gs->map, 0, sizeof(gs->map));
+    memset(&gs->level, 0, sizeof(gs->level));
+    memset(&gs->map_dist, 0, sizeof(gs->map_dist));
+    memset(&gs->map_occ, 0, sizeof(gs->map_occ));
+    return cur;
+}
+
+// Make a finished load the current level; the old one is freed on the
+// loader thread.
+static void swap_level(GameScene* gs, LoadedLevel* next) {
+    if (gs->stream) {
+        MapStreamStats st = map_stream_stats(gs->stream);
+        app_log(gs->base.app, "streamed tiles: %llu hits, %llu misses, %.0f%% of %llu prefetches used, %llu evictions, peak %.1f MiB",
+               (unsigned long long)st.hits, (unsigned long long)st.misses, st.prefetch_accuracy * 100.0,
+               (unsigned long long)st.prefetched, (unsigned long long)st.evictions,
+               st.peak_resident_bytes / 1048576.0);
+    }
+    LoadedLevel old = take_current(gs);
+    if (gs->loader) level_loader_release(gs->loader, &old);
+    else loaded_level_free(&old);
+    gs->map = next->map;
+    gs->level = next->level;
+    gs->stream = next->stream;
+    gs->map_dist = next->dist;
+    gs->map_occ = next->occ;
+    if (gs->map.occ && !gs->stream)   // the structs were copied
+        gs->map.occ = (gs->level.base && gs->level.map.occ) ? &gs->level.occ : &gs->map_occ;
+    ray_cache_invalidate(&gs->ray_cache);   // new tiles may reuse the old address
+    minimap_invalidate(&gs->minimap);
+    level_watch_destroy(gs->watch);
+    gs->watch = (GAME_SCENE_HOT_RELOAD && next->path) ? level_watch_create(next->path) : NULL;
+    free(next->path);
+
+    MapMemory mem = map_memory(&gs->map);
+    app_log(gs->base.app, "map %dx%d%s, %s in %.1f ms: %.1f MiB (tiles %.1f, dist %.1f, occupancy %.2f); %.1f MiB less than int tiles",
+           gs->map.w, gs->map.h, gs->map.layout == MAP_LAYOUT_CHUNKED ? " (chunked)" : "",
+           next->stream ? "streamed" : next->compiled ? "mapped" : "parsed", next->ms,
+           mem.total / 1048576.0, mem.tiles / 1048576.0, mem.dist / 1048576.0, mem.occ / 1048576.0,
+           ((double)mem.int_tiles - (double)mem.tiles) / 1048576.0);
+}
+
+// Apply a reload's edits to the current level in place (heap tiles, or the
+// private mapping of a compiled level), with the structures built on them.
+static void apply_patch(GameScene* gs, const LoadedLevel* patch) {
+    uint8_t* tiles = (uint8_t*)gs->map.data;
+    MapOcc* occ = (MapOcc*)gs->map.occ;
+    MapDist* dist = !gs->map.dist ? NULL : (gs->level.base && gs->level.map.dist) ? &gs->level.dist : &gs->map_dist;
+    for (size_t i = 0; i < patch->edit_count; ++i) {
+        const TileEdit* e = &patch->edits[i];
+        tiles[map_index(&gs->map, e->x, e->y)] = e->tile;
+        if (occ) map_occ_update(occ, &gs->map, e->x, e->y);
+        if (dist) map_dist_update(dist, &gs->map, e->x, e->y);
+        minimap_update_tile(&gs->minimap, &gs->map, e->x, e->y);
+    }
+    if (patch->edit_count) ray_cache_invalidate(&gs->ray_cache);
+    app_log(gs->base.app, "reloaded %s: %zu tiles changed, diffed in %.1f ms", patch->path, patch->edit_count, patch->ms);
+}
+
+// Start loading 'path' in the background; the current level stays playable
+// until it is swapped in at the start of a frame.
+static void start_load(GameScene* gs, const char* path) {
+    if (!path) return;
+    app_log(gs->base.app, "loading %s...", path);
+    level_loader_request(gs->loader, path);
+    gs->loading = true;
+    gs->reloading = false;
+    gs->load_time = 0.0f;
+}
+
+// Reload the current level after its file changed; the map is compared
+// on the loader thread and stays playable (streamed levels load whole).
+static void start_reload(GameScene* gs) {
+    if (!gs->loader) return;
+    level_loader_reload(gs->loader, level_watch_path(gs->watch), gs->stream ? NULL : &gs->map);
+    gs->reloading = true;
+}
+
+// Swap in a finished load or apply a reload's patch, if any. Called first
+// thing in a frame. Without a loader (it could not be created) the scene
+// keeps the map it has.
+static void poll_load(GameScene* gs) {
+    if (!gs->loader) return;
+    LoadedLevel next;
+    switch (level_loader_poll(gs->loader, &next)) {
+    case LEVEL_LOAD_READY:
+        if (next.patch) {
+            apply_patch(gs, &next);
+            level_loader_release(gs->loader, &next);
+        } else {
+            swap_level(gs, &next);
+        }
+        gs->loading = gs->reloading = false;
+        break;
+    case LEVEL_LOAD_BUSY: gs->loading = !gs->reloading; break;
+    default:              gs->loading = gs->reloading = false; break;   // failed: keep the current map
+    }
+    if (gs->watch && !gs->loading && level_watch_changed(gs->watch)) start_reload(gs);
+}
+
+// Loading indicator over the last frame: a block sliding along a track.
+static void draw_loading(GameScene* gs, Canvas* dst) {
+    int tw = dst->w / 3, th = 6;
+    int tx = (dst->w - tw) / 2, ty = dst->h - 40;
+    int bw = tw / 4;
+    float p = fmodf(gs->load_time * GAME_SCENE_LOADING_SPEED, 2.0f);
+    int bx = tx + (int)((p < 1.0f ? p : 2.0f - p) * (float)(tw - bw));
+    canvas_fill_rect(dst, tx - 2, ty - 2, tw + 4, th + 4, rgba(0, 0, 0, 255));
+    canvas_fill_rect(dst, tx, ty, tw, th, rgba(60, 60, 60, 255));
+    canvas_fill_rect(dst, bx, ty, bw, th, rgba(230, 230, 230, 255));
+}
+
 static void gs_on_init(Scene* s, struct App* app) {
     GameScene* gs = (GameScene*)s;
     s->app = app;
 
-    // init buffers
-    canvas_init(&gs->scene,  app->mlx, app->mlx->width,  app->mlx->height);
-    canvas_init(&gs->minimap,app->mlx, 1, 1); // resized after map load
+    // init buffers (direct frames need none)
+    if (!GAME_SCENE_DIRECT) scene_buffer_init(gs, app->mlx, app->mlx->width, app->mlx->height);
 
     // default world, later will be changed
-    extern const int WORLD_DATA[];
     gs->map.w = WORLD_W;
     gs->map.h = WORLD_H;
     gs->map.data = WORLD_DATA;
+    build_map_accel(gs);
 
     gs->cam.pos   = (Vec2f){ 12.0f, 12.0f };
     gs->cam.dir   = (Vec2f){ -1.0f, 0.0f };
     gs->cam.plane = (Vec2f){  0.0f, 0.66f };
+
+    gs->rc.pool = app->pool;
+    gs->rc.mode = RAYCAST_PACKET;
+    ray_cache_init(&gs->ray_cache);
+    gs->rc.cache = &gs->ray_cache;
+    gs->rc.rows = &gs->floor_rows;
+    minimap_init(&gs->minimap);
+    load_wall_textures(gs);
+    set_textures(gs, true);
+
+    dynres_init(&gs->dynres, NULL);
+    gs->dynres.enabled = GAME_SCENE_DYNRES;
+
+    LevelLoaderConfig lc = {
+        .chunk_min_cells  = GAME_SCENE_CHUNK_MIN_CELLS,
+        .dist_max_cells   = GAME_SCENE_DIST_MAX_CELLS,
+        .stream_min_cells = GAME_SCENE_STREAM_MIN_CELLS,
+        .verify           = GAME_SCENE_VERIFY_LEVELS,
+        .threaded         = GAME_SCENE_ASYNC_LOAD,
+    };
+    gs->loader = level_loader_create(&lc);
+    // a level queued before the scene was initialized
+    if (gs->loader && gs->pending_map_path) start_load(gs, gs->pending_map_path);
+    gs->pending_map_path = NULL;
 }
 
 static void gs_on_show(Scene* s) {
-    (void)s; // nothing to enable; we render into App->screen
+    GameScene* gs = (GameScene*)s;
+    gs->screen_stale = true;   // another scene drew into App->screen
 }
 
 static void gs_on_hide(Scene* s) {
     (void)s; // nothing to disable
 }
 
-static void load_map(GameScene* gs, const char* path) {
-    if (!path) return;
-    int* data = NULL; int w=0,h=0; char* err=NULL;
-    if (map_parse_cub3d_file(path, &data, &w, &h, &err) != 0) {
-        fprintf(stderr, "Failed to load map '%s': %s\n", path, err?err:"parse error");
-        free(err);
-        return;
-    }
-    // replace map
-    if (gs->map.data != NULL && gs->map.data != WORLD_DATA) free((void*)gs->map.data);
-    gs->map.data = data; gs->map.w = w; gs->map.h = h;
-    // resize minimap
-    canvas_destroy(&gs->minimap);
-    canvas_init(&gs->minimap, gs->base.app->mlx, gs->map.w * 6, gs->map.h * 6);
+// true once per press (edge), for toggles
+static bool key_pressed(mlx_t* mlx, keys_t key, bool* was_down) {
+    bool down = mlx_is_key_down(mlx, key);
+    bool edge = down && !*was_down;
+    *was_down = down;
+    return edge;
 }
 
 static void gs_on_update(Scene* s, double now, float dt) {
     GameScene* gs = (GameScene*)s;
     (void)now;
 
-    // late apply of pending map load when scene is active
-    if (gs->pending_map_path) {
-        load_map(gs, gs->pending_map_path);
-        gs->pending_map_path = NULL;
+    // swap in a finished load before anything reads the map this frame
+    poll_load(gs);
+    if (gs->loading) {
+        gs->load_time += dt;
+        if (mlx_is_key_down(gs->base.app->mlx, MLX_KEY_M))
+            sm_request_change(&gs->base.app->sm, SCN_MENU);
+        return;   // no input until the level is in
     }
 
     // input (WASD/LR) kept from your code:
@@ -95,6 +288,19 @@ static void gs_on_update(Scene* s, double now, float dt) {
         gs->cam.plane = (Vec2f){ p.x*cs - p.y*sn, p.x*sn + p.y*cs };
     }
 
+    if (key_pressed(mlx, MLX_KEY_P, &gs->mode_key_down)) {
+        gs->rc.mode = (gs->rc.mode == RAYCAST_PACKET) ? RAYCAST_SCALAR : RAYCAST_PACKET;
+    }
+
+    if (key_pressed(mlx, MLX_KEY_T, &gs->tex_key_down)) {
+        set_textures(gs, gs->rc.walls == NULL);
+    }
+
+    if (key_pressed(mlx, MLX_KEY_R, &gs->dynres_key_down)) {
+        gs->dynres.enabled = !gs->dynres.enabled;
+    }
+    dynres_update(&gs->dynres, dt);   // the scale shows in the stats overlay
+
     if (mlx_is_key_down(mlx, MLX_KEY_M)) {
         sm_request_change(&gs->base.app->sm, SCN_MENU);
     }
@@ -102,31 +308,73 @@ static void gs_on_update(Scene* s, double now, float dt) {
 
 static void gs_on_render(Scene* s) {
     GameScene* gs = (GameScene*)s;
-    // your existing renderers:
-    render_scene(&gs->scene, &gs->map, &gs->cam);
-    draw_minimap(&gs->minimap, &gs->map, &gs->cam, 6);
-
-    // composite into App screen
-    // for (int x=0;x<100;++x)
-    //     for (int y=0;y<100;++y)
-    //         canvas_put(&gs->minimap, x, y, rgba(255,100,100,255));
+    Canvas* screen = &s->app->screen;
+    // your existing renderers (at the dynamic resolution scale, if on):
+    int rw, rh;
+    dynres_size(&gs->dynres, screen->w, screen->h, &rw, &rh);
+    bool direct = GAME_SCENE_DIRECT && rw == screen->w && rh == screen->h;
+    if (!direct && !gs->scene.px) scene_buffer_init(gs, s->app->mlx, screen->w, screen->h);
+    if (!gs->scene.px) direct = true;   // no buffer: full resolution
+    if (gs->stream) {   // tiles near the camera
+        uint64_t gen = map_stream_update(gs->stream, &gs->cam);
+        if (gen != gs->stream_gen) ray_cache_forget_frame(&gs->ray_cache);   // blocks arrived or left
+        gs->stream_gen = gen;
+    }
+    if (direct) {
+        // a skipped frame keeps what is in App->screen: only our own pixels
+        if (gs->screen_stale) ray_cache_forget_frame(&gs->ray_cache);
+        render_scene(screen, &gs->map, &gs->cam, &gs->rc);
+    } else {
+        Canvas view = canvas_reuse(&gs->scene, rw, rh);
+        render_scene(&view, &gs->map, &gs->cam, &gs->rc);
+        if (gs->screen_stale) canvas_mark(&view, 0, 0, rw, rh);   // even if the frame was skipped
+        canvas_composite(screen, &view, &gs->scene_dirty, 0, 0, screen->w, screen->h);
+    }
 
-    canvas_copy(&s->app->screen, &gs->scene, 0, 0);
-    canvas_copy(&s->app->screen, &gs->minimap, 8, 8);
+    // HUD, drawn in place into App screen
+    Canvas mini = canvas_view(screen, GAME_SCENE_MINIMAP_X, GAME_SCENE_MINIMAP_Y,
+                              gs->map.w * GAME_SCENE_MINIMAP_SCALE, gs->map.h * GAME_SCENE_MINIMAP_SCALE);
+    bool covered = canvas_dirty_hits(&s->app->damage, mini.ox, mini.oy, mini.w, mini.h);   // scene drew over it
+    minimap_draw(&gs->minimap, &mini, &gs->map, &gs->cam, GAME_SCENE_MINIMAP_SCALE, covered);
+    if (gs->loading) draw_loading(gs, screen);
+    gs->screen_stale = gs->loading;
 }
 
 static void gs_on_resize(Scene* s, int w, int h) {
     GameScene* gs = (GameScene*)s;
     canvas_destroy(&gs->scene);
-    canvas_init(&gs->scene, s->app->mlx, w, h);
-    // minimap will be resized on map load; optional: keep scale here
+    if (!GAME_SCENE_DIRECT) scene_buffer_init(gs, s->app->mlx, w, h);
+    ray_cache_invalidate(&gs->ray_cache);   // the buffer may reuse the old address
+}
+
+static void gs_on_stats(Scene* s, char* buf, size_t n) {
+    GameScene* gs = (GameScene*)s;
+    int len = snprintf(buf, n, "%s DDA, render scale %.0f%% (dynamic resolution %s)",
+                       gs->rc.mode == RAYCAST_PACKET ? "packet" : "scalar",
+                       game_scene_render_scale(gs) * 100.0f, gs->dynres.enabled ? "on" : "off");
+    if (gs->stream && len >= 0 && (size_t)len < n) {
+        MapStreamStats st = map_stream_stats(gs->stream);
+        snprintf(buf + len, n - (size_t)len, ", stream %llu hit %llu miss %.0f%% pf %.0f MiB",
+                 (unsigned long long)st.hits, (unsigned long long)st.misses, st.prefetch_accuracy * 100.0,
+                 st.resident_bytes / 1048576.0);
+    }
 }
 
 static void gs_on_destroy(Scene* s) {
     GameScene* gs = (GameScene*)s;
-    if (gs->map.data && gs->map.data != WORLD_DATA) free((void*)gs->map.data);
-    canvas_destroy(&gs->minimap);
+    level_loader_destroy(gs->loader);   // cancels a load in flight
+    gs->loader = NULL;
+    level_watch_destroy(gs->watch);
+    gs->watch = NULL;
+    LoadedLevel cur = take_current(gs);
+    loaded_level_free(&cur);
     canvas_destroy(&gs->scene);
+    minimap_free(&gs->minimap);
+    wall_tex_set_free(&gs->walls);
+    ray_cache_free(&gs->ray_cache);
+    raycast_rows_free(&gs->floor_rows);
+    wall_tex_free(&gs->floor_tex);
+    wall_tex_free(&gs->ceil_tex);
 }
 
 void game_scene_init_instance(GameScene* gs) {
@@ -137,9 +385,15 @@ void game_scene_init_instance(GameScene* gs) {
     gs->base.on_update = gs_on_update;
     gs->base.on_render = gs_on_render;
     gs->base.on_resize = gs_on_resize;
+    gs->base.on_stats  = gs_on_stats;
     gs->base.on_destroy= gs_on_destroy;
 }
 
 void game_scene_queue_load(GameScene* gs, const char* map_path) {
-    gs->pending_map_path = map_path;
+    if (gs->loader) start_load(gs, map_path);   // supersedes a load in flight
+    else gs->pending_map_path = map_path;
+}
+
+float game_scene_render_scale(const GameScene* gs) {
+    return gs->dynres.enabled ? gs->dynres.scale : 1.0f;
 }
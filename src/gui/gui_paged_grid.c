@@ -52,6 +52,14 @@ static void pager_set_enabled(GuiPagedGrid* g, bool prev_enabled, bool next_enab
     g->btn_next.state = next_enabled ? GUI_BTN_NORMAL : GUI_BTN_DISABLED;
 }
 
+static void grid_drop_thumbs(GuiContext* ctx, GuiPagedGrid* g) {
+    if (!g->thumb_imgs) return;
+    for (size_t i = 0; i < g->per_page; ++i) {
+        if (g->thumb_imgs[i]) mlx_delete_image(ctx->mlx, g->thumb_imgs[i]);
+        g->thumb_imgs[i] = NULL;
+    }
+}
+
 static void grid_layout_buttons(GuiContext* ctx, GuiPagedGrid* g) {
     // Compute cell sizes
     int cols = g->cfg.cols, rows = g->cfg.rows, gap = g->cfg.gap;
@@ -71,6 +79,11 @@ static void grid_layout_buttons(GuiContext* ctx, GuiPagedGrid* g) {
     if (!g->item_btns) {
         g->item_btns = (GuiButton*)calloc(g->per_page, sizeof(GuiButton));
     }
+    // Thumbnails belong to the previous layout
+    grid_drop_thumbs(ctx, g);
+    if (g->cfg.thumb_h > 0 && !g->thumb_imgs)
+        g->thumb_imgs = (mlx_image_t**)calloc(g->per_page, sizeof(mlx_image_t*));
+    g->layout_serial++;
 
     // Build/rebuild visible buttons for the current page
     size_t start = g->page * g->per_page;
@@ -96,6 +109,11 @@ static void grid_layout_buttons(GuiContext* ctx, GuiPagedGrid* g) {
             }
             if (!gui_button_init(ctx, b, bx, by, bw, bh, g->cfg.item_skin_tex, g->cfg.item_skin_cfg, g->items[idx].label))
                 continue;
+            // Label under the thumbnail
+            if (g->cfg.thumb_h > 0 && b->label_img && b->label_img->count > 0) {
+                b->label_dy = bh - (int)b->label_img->height - 6;
+                b->label_img->instances[b->label_img->count - 1].y = b->y + b->label_dy;
+            }
             // Connect callback
             b->on_click = g->items[idx].on_click;
             b->userdata = g->items[idx].userdata;
@@ -266,6 +284,10 @@ void gui_paged_grid_free(GuiContext* ctx, GuiPagedGrid* g) {
         g->item_btns = NULL;
     }
 
+    grid_drop_thumbs(ctx, g);
+    free(g->thumb_imgs);
+    g->thumb_imgs = NULL;
+
     // Pager UI
     gui_button_free(ctx->mlx, &g->btn_prev);
     gui_button_free(ctx->mlx, &g->btn_next);
@@ -301,6 +323,7 @@ void gui_paged_grid_set_enabled(GuiPagedGrid* g, bool en) {
             GuiButton* b = &g->item_btns[i];
             pg_img_set_enabled(b->skin_img,  en);
             pg_img_set_enabled(b->label_img, en);
+            if (g->thumb_imgs) pg_img_set_enabled(g->thumb_imgs[i], en);
         }
     }
 
@@ -313,3 +336,41 @@ void gui_paged_grid_set_enabled(GuiPagedGrid* g, bool en) {
     // Pager label ("1 / N")
     pg_img_set_enabled(g->page_label_img, en);
 }
+
+size_t gui_paged_grid_page_items(const GuiPagedGrid* g, size_t* first) {
+    size_t start = g->page * g->per_page;
+    *first = start;
+    if (start >= g->items_len) return 0;
+    return (g->items_len - start < g->per_page) ? g->items_len - start : g->per_page;
+}
+
+bool gui_paged_grid_set_thumbnail(GuiContext* ctx, GuiPagedGrid* g, size_t item,
+                                  const uint32_t* px, int w, int h) {
+    size_t first;
+    size_t n = gui_paged_grid_page_items(g, &first);
+    if (!g->thumb_imgs || item < first || item >= first + n || w <= 0 || h <= 0) return false;
+    size_t slot = item - first;
+    GuiButton* b = &g->item_btns[slot];
+    if (!b->skin_img) return false;
+
+    // whole multiples of the source when it is small, else its own size
+    int box = g->cfg.thumb_h < b->w - 16 ? g->cfg.thumb_h : b->w - 16;
+    int scale = (w < box && h < box) ? box / (w > h ? w : h) : 1;
+    if (scale < 1) scale = 1;
+    int iw = w * scale, ih = h * scale;
+    mlx_image_t* img = mlx_new_image(ctx->mlx, (uint32_t)iw, (uint32_t)ih);
+    if (!img) return false;
+    uint32_t* dst = (uint32_t*)img->pixels;
+    for (int y = 0; y < ih; ++y)
+        for (int x = 0; x < iw; ++x)
+            dst[(size_t)y * (size_t)iw + (size_t)x] = px[(size_t)(y / scale) * (size_t)w + (size_t)(x / scale)];
+
+    if (g->thumb_imgs[slot]) mlx_delete_image(ctx->mlx, g->thumb_imgs[slot]);
+    g->thumb_imgs[slot] = img;
+    int32_t ii = mlx_image_to_window(ctx->mlx, img, b->x + (b->w - iw) / 2, b->y + 8 + (box - ih) / 2);
+    if (ii >= 0) {
+        img->instances[ii].z = b->skin_img->count ? b->skin_img->instances[b->skin_img->count - 1].z + 1 : 2;
+        img->instances[ii].enabled = b->skin_img->count ? b->skin_img->instances[b->skin_img->count - 1].enabled : true;
+    }
+    return true;
+}
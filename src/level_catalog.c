@@ -0,0 +1,256 @@
+#include "level_catalog.h"
+#include "map.h"
+#include "map_bin.h"
+#include "util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct CatalogHeader {
+    char     magic[8];       // LEVEL_CATALOG_MAGIC, no terminator
+    uint32_t version;        // LEVEL_CATALOG_VERSION
+    uint32_t count;
+    int64_t  dir_mtime_ns;
+    uint64_t names_bytes;
+    uint64_t hash;           // map_bin_hash() of the entries and names
+} CatalogHeader;
+
+typedef struct CatalogEntry {
+    int64_t  mtime_ns;
+    uint64_t size;
+    uint64_t hash;
+    int32_t  w, h;
+    uint32_t name_offset;    // into the names
+    uint32_t name_bytes;
+} CatalogEntry;
+
+// Length of 'dir' without trailing slashes (at least one character).
+static size_t dir_len(const char* dir) {
+    size_t n = strlen(dir);
+    while (n > 1 && dir[n - 1] == '/') --n;
+    return n;
+}
+
+static char* join(const char* dir, const char* name, size_t name_len) {
+    size_t ld = dir_len(dir);
+    char* p = (char*)malloc(ld + 1 + name_len + 1);
+    if (!p) return NULL;
+    memcpy(p, dir, ld);
+    p[ld] = '/';
+    memcpy(p + ld + 1, name, name_len);
+    p[ld + 1 + name_len] = '\0';
+    return p;
+}
+
+static const char* name_of(const LevelCatalog* c, const LevelInfo* li) {
+    return li->path + dir_len(c->dir) + 1;
+}
+
+static int cmp_level(const void* a, const void* b) {
+    return strcmp(((const LevelInfo*)a)->path, ((const LevelInfo*)b)->path);
+}
+
+char* level_catalog_path_for(const char* dir) {
+    size_t n = dir_len(dir);
+    char* p = (char*)malloc(n + sizeof(LEVEL_CATALOG_EXT));
+    if (!p) return NULL;
+    memcpy(p, dir, n);
+    memcpy(p + n, LEVEL_CATALOG_EXT, sizeof(LEVEL_CATALOG_EXT));
+    return p;
+}
+
+void level_catalog_free(LevelCatalog* c) {
+    for (size_t i = 0; i < c->count; ++i) free(c->levels[i].path);
+    free(c->levels);
+    free(c->dir);
+    memset(c, 0, sizeof(*c));
+}
+
+static void* read_file(const char* path, size_t* out_len) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    char* buf = NULL;
+    size_t got = 0;
+    if (fstat(fd, &st) == 0 && (buf = (char*)malloc(st.st_size > 0 ? (size_t)st.st_size : 1))) {
+        while (got < (size_t)st.st_size) {
+            ssize_t r = read(fd, buf + got, (size_t)st.st_size - got);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) break;
+            got += (size_t)r;
+        }
+    }
+    close(fd);
+    *out_len = got;
+    return buf;
+}
+
+int level_catalog_load(LevelCatalog* c, const char* dir, const char* index_path) {
+    memset(c, 0, sizeof(*c));
+    if (!(c->dir = strdup(dir))) return -1;
+    size_t len = 0;
+    unsigned char* img = index_path ? (unsigned char*)read_file(index_path, &len) : NULL;
+    if (!img) return 0;
+
+    const CatalogHeader* hd = (const CatalogHeader*)img;
+    const CatalogEntry* ent = (const CatalogEntry*)(img + sizeof(CatalogHeader));
+    size_t table = len >= sizeof(CatalogHeader) ? (size_t)hd->count * sizeof(CatalogEntry) : 0;
+    bool ok = len >= sizeof(CatalogHeader)
+           && memcmp(hd->magic, LEVEL_CATALOG_MAGIC, 8) == 0 && hd->version == LEVEL_CATALOG_VERSION
+           && len - sizeof(CatalogHeader) >= table
+           && len - sizeof(CatalogHeader) - table == hd->names_bytes
+           && hd->hash == map_bin_hash(ent, len - sizeof(CatalogHeader));
+    const char* names = (const char*)ent + table;
+    if (ok && hd->count && !(c->levels = (LevelInfo*)calloc(hd->count, sizeof(LevelInfo)))) ok = false;
+    for (uint32_t i = 0; ok && i < hd->count; ++i) {
+        const CatalogEntry* e = &ent[i];
+        if ((uint64_t)e->name_offset + e->name_bytes > hd->names_bytes || e->name_bytes == 0) { ok = false; break; }
+        LevelInfo* li = &c->levels[c->count];
+        if (!(li->path = join(dir, names + e->name_offset, e->name_bytes))) { ok = false; break; }
+        li->mtime_ns = e->mtime_ns;
+        li->size = e->size;
+        li->hash = e->hash;
+        li->w = e->w;
+        li->h = e->h;
+        c->count++;
+    }
+    if (ok) {
+        c->dir_mtime_ns = hd->dir_mtime_ns;
+        qsort(c->levels, c->count, sizeof(LevelInfo), cmp_level);
+    } else {
+        // not an index of ours (or damaged): start over
+        for (size_t i = 0; i < c->count; ++i) free(c->levels[i].path);
+        free(c->levels);
+        c->levels = NULL;
+        c->count = 0;
+    }
+    free(img);
+    return 0;
+}
+
+// Read a new or changed level: hash and dimensions.
+static void scan_level(LevelInfo* li, const struct stat* st) {
+    size_t len = 0;
+    char* text = (char*)read_file(li->path, &len);
+    li->mtime_ns = ST_MTIME_NS(*st);
+    li->size = (uint64_t)st->st_size;
+    li->hash = text ? map_bin_hash(text, len) : 0;
+    li->w = li->h = 0;
+    uint8_t* data = NULL;
+    if (text && map_parse_cub3d(text, len, &data, &li->w, &li->h, NULL) != 0) li->w = li->h = 0;
+    free(data);
+    free(text);
+}
+
+// Entries for a fresh listing: kept ones move over (their paths too), the
+// rest are freed. Returns the number of levels dropped, or -1.
+static int relist(LevelCatalog* c, char** err) {
+    char** paths = NULL; size_t n = 0;
+    if (map_list_levels(c->dir, &paths, &n) != 0)
+        return util_error(err, "cannot read '%s': %s", c->dir, strerror(errno));
+    LevelInfo* next = n ? (LevelInfo*)calloc(n, sizeof(LevelInfo)) : NULL;
+    if (n && !next) { map_free_paths(paths, n); return util_error(err, "out of memory"); }
+    int changes = 0;
+    for (size_t i = 0; i < n; ++i) {
+        LevelInfo key = { .path = paths[i] };
+        LevelInfo* old = c->count ? (LevelInfo*)bsearch(&key, c->levels, c->count, sizeof(LevelInfo), cmp_level) : NULL;
+        if (old) {
+            next[i] = *old;
+            old->mtime_ns = -1;             // moved
+            free(paths[i]);
+        } else {
+            next[i].path = paths[i];        // mtime 0: scanned (and counted) below
+        }
+    }
+    for (size_t i = 0; i < c->count; ++i) {
+        if (c->levels[i].mtime_ns == -1) continue;
+        free(c->levels[i].path);
+        ++changes;
+    }
+    free(paths);
+    free(c->levels);
+    c->levels = next;
+    c->count = n;
+    qsort(c->levels, c->count, sizeof(LevelInfo), cmp_level);
+    return changes;
+}
+
+int level_catalog_refresh(LevelCatalog* c, char** err) {
+    if (err) *err = NULL;
+    struct stat st;
+    if (stat(c->dir, &st) != 0) return util_error(err, "cannot open '%s': %s", c->dir, strerror(errno));
+    int changes = 0;
+    int64_t dir_mtime = ST_MTIME_NS(st);
+    if (dir_mtime != c->dir_mtime_ns) {
+        // names changed: list again, keeping what is known
+        int r = relist(c, err);
+        if (r < 0) return -1;
+        changes = r + 1;
+        c->dir_mtime_ns = dir_mtime;
+    }
+    // in-place edits do not touch the directory
+    size_t keep = 0;
+    for (size_t i = 0; i < c->count; ++i) {
+        LevelInfo* li = &c->levels[i];
+        if (stat(li->path, &st) != 0 || !S_ISREG(st.st_mode)) { free(li->path); ++changes; continue; }
+        if (li->mtime_ns != ST_MTIME_NS(st) || li->size != (uint64_t)st.st_size) {
+            scan_level(li, &st);
+            ++changes;
+        }
+        c->levels[keep++] = *li;
+    }
+    c->count = keep;
+    return changes;
+}
+
+int level_catalog_save(const LevelCatalog* c, const char* index_path, char** err) {
+    if (err) *err = NULL;
+    size_t names = 0;
+    for (size_t i = 0; i < c->count; ++i) names += strlen(name_of(c, &c->levels[i]));
+    size_t table = c->count * sizeof(CatalogEntry);
+    size_t len = sizeof(CatalogHeader) + table + names;
+    unsigned char* img = (unsigned char*)calloc(1, len);
+    if (!img) return util_error(err, "out of memory");
+
+    CatalogHeader* hd = (CatalogHeader*)img;
+    CatalogEntry* ent = (CatalogEntry*)(img + sizeof(CatalogHeader));
+    char* name_at = (char*)ent + table;
+    size_t off = 0;
+    for (size_t i = 0; i < c->count; ++i) {
+        const LevelInfo* li = &c->levels[i];
+        const char* name = name_of(c, li);
+        size_t nl = strlen(name);
+        ent[i] = (CatalogEntry){ li->mtime_ns, li->size, li->hash, li->w, li->h, (uint32_t)off, (uint32_t)nl };
+        memcpy(name_at + off, name, nl);
+        off += nl;
+    }
+    memcpy(hd->magic, LEVEL_CATALOG_MAGIC, 8);
+    hd->version = LEVEL_CATALOG_VERSION;
+    hd->count = (uint32_t)c->count;
+    hd->dir_mtime_ns = c->dir_mtime_ns;
+    hd->names_bytes = names;
+    hd->hash = map_bin_hash(ent, table + names);
+
+    // write next to the target and rename, so readers never see half a file
+    size_t tl = strlen(index_path) + 5;
+    char* tmp = (char*)malloc(tl);
+    if (!tmp) { free(img); return util_error(err, "out of memory"); }
+    snprintf(tmp, tl, "%s.tmp", index_path);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) { int e = errno; free(img); free(tmp); return util_error(err, "cannot create '%s': %s", index_path, strerror(e)); }
+    bool ok = fwrite(img, 1, len, f) == len;
+    ok = (fclose(f) == 0) && ok;
+    free(img);
+    if (!ok || rename(tmp, index_path) != 0) {
+        int e = errno;
+        remove(tmp);
+        free(tmp);
+        return util_error(err, "cannot write '%s': %s", index_path, strerror(e));
+    }
+    free(tmp);
+    return 0;
+}
@@ -0,0 +1,358 @@
+#include "level_loader.h"
+#include "util.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct LevelLoader {
+    LevelLoaderConfig cfg;
+    pthread_t       thread;
+    bool            started;     // false: work runs inline in level_loader_poll()
+
+    pthread_mutex_t mtx;
+    pthread_cond_t  work_cv;     // a request or garbage was queued, or quit
+
+    // guarded by mtx
+    char*           path;        // queued request (NULL = none)
+    bool            reload;      // ... a reload against 'current'
+    GridMap         current;
+    bool            in_flight;   // the thread is loading a request
+    bool            has_ready;
+    bool            failed;
+    LoadedLevel     ready;
+    LoadedLevel*    garbage;     // levels to free
+    int             garbage_count, garbage_cap;
+    bool            quit;
+
+    unsigned        generation;  // bumped per request; read unlocked to cancel
+};
+
+// True when a newer request superseded load 'gen'.
+static bool stale(const LevelLoader* l, unsigned gen) {
+    return __atomic_load_n(&l->generation, __ATOMIC_RELAXED) != gen;
+}
+
+void loaded_level_fix(LoadedLevel* lvl) {
+    if (lvl->map.occ && !lvl->stream)   // a stream's occupancy does not move
+        lvl->map.occ = (lvl->level.base && lvl->level.map.occ) ? &lvl->level.occ : &lvl->occ;
+}
+
+void loaded_level_free(LoadedLevel* lvl) {
+    if (lvl->level.base) map_bin_close(&lvl->level);
+    map_stream_close(lvl->stream);
+    free(lvl->tiles);
+    free(lvl->path);
+    free(lvl->edits);
+    map_dist_free(&lvl->dist);
+    map_occ_free(&lvl->occ);
+    memset(lvl, 0, sizeof(*lvl));
+}
+
+// Stream compiled level 'bin' when it has at least stream_min_cells (only
+// the header is read). False when it is smaller or cannot be streamed.
+static bool open_stream(const LevelLoaderConfig* cfg, LoadedLevel* lvl, const char* bin) {
+    MapBinHeader hd;
+    MapBinSection table[MAP_BIN_MAX_SECTIONS];
+    if (!cfg->stream_min_cells) return false;
+    int fd = map_bin_read_table(bin, &hd, table, NULL);
+    if (fd < 0) return false;
+    close(fd);
+    if ((size_t)hd.w * (size_t)hd.h < cfg->stream_min_cells) return false;
+    char* err = NULL;
+    lvl->stream = map_stream_open(bin, NULL, &err);
+    if (!lvl->stream) {
+        fprintf(stderr, "Mapping the whole level: %s\n", err ? err : "out of memory");
+        free(err);
+        return false;
+    }
+    lvl->map = map_stream_map(lvl->stream);
+    return true;
+}
+
+// Map (or stream) an up-to-date compiled level next to 'path'. False when
+// there is none or it is stale or damaged.
+static bool open_compiled(const LevelLoaderConfig* cfg, LoadedLevel* lvl, const char* path) {
+    char* bin = map_bin_path_for(path);
+    char* err = NULL;
+    bool ok = bin && map_bin_is_fresh(bin, path)
+           && (open_stream(cfg, lvl, bin) || map_bin_open(&lvl->level, bin, cfg->verify, &err) == 0);
+    if (err) fprintf(stderr, "Ignoring compiled level: %s\n", err);
+    free(err);
+    free(bin);
+    if (!ok) return false;
+    if (!lvl->stream) lvl->map = lvl->level.map;
+    lvl->compiled = true;
+    return true;
+}
+
+// Parse the .cub3d source at 'path' into row-major tiles. False (reported)
+// when it does not parse.
+static bool parse_file(const char* path, uint8_t** tiles, int* w, int* h) {
+    char* err = NULL;
+    if (map_parse_cub3d_file(path, tiles, w, h, &err) == 0) return true;
+    fprintf(stderr, "Failed to load map '%s': %s\n", path, err ? err : "parse error");
+    free(err);
+    return false;
+}
+
+// Make parsed tiles the level's (chunked when big).
+static void adopt_tiles(const LevelLoaderConfig* cfg, LoadedLevel* lvl, uint8_t* tiles, int w, int h) {
+    lvl->tiles = tiles;
+    MapLayout layout = MAP_LAYOUT_ROWS;
+    if ((size_t)w * (size_t)h >= cfg->chunk_min_cells) {
+        uint8_t* chunked = map_convert_layout(lvl->tiles, MAP_LAYOUT_ROWS, MAP_LAYOUT_CHUNKED, w, h);
+        if (chunked) { free(lvl->tiles); lvl->tiles = chunked; layout = MAP_LAYOUT_CHUNKED; }
+    }
+    lvl->map = (GridMap){ .w = w, .h = h, .layout = layout, .data = lvl->tiles };
+}
+
+// Diff state: the edits so far and how many a patch may hold.
+typedef struct TileDiff {
+    LoadedLevel* lvl;
+    size_t       cap, max;
+    uint16_t     spread[MAP_CHUNK];   // in-chunk offset of x (Morton, even bits)
+} TileDiff;
+
+// Record that (x, y) is now 'tile'. False when the patch is full.
+static bool add_edit(TileDiff* d, int x, int y, uint8_t tile) {
+    LoadedLevel* lvl = d->lvl;
+    if (lvl->edit_count == d->max) return false;
+    if (lvl->edit_count == d->cap) {
+        size_t cap = d->cap ? d->cap * 2 : 64;
+        TileEdit* e = (TileEdit*)realloc(lvl->edits, cap * sizeof(TileEdit));
+        if (!e) return false;
+        lvl->edits = e;
+        d->cap = cap;
+    }
+    lvl->edits[lvl->edit_count++] = (TileEdit){ x, y, tile };
+    return true;
+}
+
+// Compare row 'y' of 'rows' with 'cur' over [x0, x1).
+static bool diff_row(TileDiff* d, const uint8_t* rows, const GridMap* cur, int y, int x0, int x1) {
+    const uint8_t* next = rows + (size_t)y * (size_t)cur->w;
+    if (cur->layout == MAP_LAYOUT_ROWS) {
+        const uint8_t* now = cur->data + (size_t)y * (size_t)cur->w;
+        for (int x = x0; x < x1; x += 64) {
+            int len = x1 - x < 64 ? x1 - x : 64;
+            if (memcmp(next + x, now + x, (size_t)len) == 0) continue;
+            for (int i = x; i < x + len; ++i)
+                if (next[i] != now[i] && !add_edit(d, i, y, next[i])) return false;
+        }
+        return true;
+    }
+    // one chunk row: its cells are spread over the chunk in Morton order
+    const uint8_t* now = cur->data + map_index(cur, x0, y);
+    uint8_t diff = 0;
+    for (int x = x0; x < x1; ++x) diff |= next[x] ^ now[d->spread[x - x0]];
+    if (!diff) return true;
+    for (int x = x0; x < x1; ++x)
+        if (next[x] != cur->data[map_index(cur, x, y)] && !add_edit(d, x, y, next[x])) return false;
+    return true;
+}
+
+// The tiles of 'rows' (row-major, cur's size) that differ from 'cur', as
+// lvl's edits. False when there are too many for a patch.
+static bool diff_tiles(LoadedLevel* lvl, const uint8_t* rows, const GridMap* cur) {
+    TileDiff d = { lvl, 0, (size_t)cur->w * (size_t)cur->h / LEVEL_LOADER_PATCH_SHARE, { 0 } };
+    for (int i = 0; i < MAP_CHUNK; ++i) d.spread[i] = (uint16_t)map_morton_spread((uint32_t)i);
+    int step = cur->layout == MAP_LAYOUT_ROWS ? cur->w : MAP_CHUNK;
+    bool ok = true;
+    for (int y = 0; ok && y < cur->h; ++y)
+        for (int x = 0; ok && x < cur->w; x += step)
+            ok = diff_row(&d, rows, cur, y, x, x + step < cur->w ? x + step : cur->w);
+    if (!ok) {
+        free(lvl->edits);
+        lvl->edits = NULL;
+        lvl->edit_count = 0;
+    }
+    return ok;
+}
+
+// Build the traversal structures the level does not bring. Returns as
+// load_level().
+static int finish_level(LevelLoader* l, unsigned gen, LoadedLevel* lvl, double t0) {
+    if (stale(l, gen)) { loaded_level_free(lvl); return 1; }
+    if (!lvl->map.occ && map_occ_build(&lvl->occ, &lvl->map) == 0) lvl->map.occ = &lvl->occ;
+    if (stale(l, gen)) { loaded_level_free(lvl); return 1; }
+    if (!lvl->map.dist && !lvl->stream && (size_t)lvl->map.w * (size_t)lvl->map.h <= l->cfg.dist_max_cells
+        && map_dist_build(&lvl->dist, &lvl->map) == 0)
+        lvl->map.dist = lvl->dist.d;
+    lvl->ms = util_now_ms() - t0;
+    return 0;
+}
+
+// Load 'path' for request 'gen'. Returns 0, -1 when it does not load, or 1
+// when superseded between stages; lvl is left empty unless 0.
+static int load_level(LevelLoader* l, unsigned gen, const char* path, LoadedLevel* lvl) {
+    double t0 = util_now_ms();
+    memset(lvl, 0, sizeof(*lvl));
+    if (!open_compiled(&l->cfg, lvl, path)) {
+        uint8_t* tiles = NULL; int w = 0, h = 0;
+        if (!parse_file(path, &tiles, &w, &h)) return -1;
+        adopt_tiles(&l->cfg, lvl, tiles, w, h);
+    }
+    return finish_level(l, gen, lvl, t0);
+}
+
+// Reload 'path' for request 'gen' against 'cur': a patch when few tiles
+// changed, else the whole level (the source: a compiled level is older
+// than the edit). Returns as load_level().
+static int reload_level(LevelLoader* l, unsigned gen, const char* path, const GridMap* cur, LoadedLevel* lvl) {
+    double t0 = util_now_ms();
+    memset(lvl, 0, sizeof(*lvl));
+    uint8_t* tiles = NULL; int w = 0, h = 0;
+    if (!parse_file(path, &tiles, &w, &h)) return -1;
+    if (stale(l, gen)) { free(tiles); return 1; }
+    if (w == cur->w && h == cur->h && diff_tiles(lvl, tiles, cur)) {
+        free(tiles);
+        lvl->patch = true;
+        lvl->ms = util_now_ms() - t0;
+        return 0;
+    }
+    adopt_tiles(&l->cfg, lvl, tiles, w, h);
+    return finish_level(l, gen, lvl, t0);
+}
+
+// Queue 'lvl' for freeing (or free it here when the list cannot grow).
+// Called with mtx held.
+static void push_garbage(LevelLoader* l, LoadedLevel* lvl) {
+    if (l->garbage_count == l->garbage_cap) {
+        int cap = l->garbage_cap ? l->garbage_cap * 2 : 4;
+        LoadedLevel* g = (LoadedLevel*)realloc(l->garbage, sizeof(*g) * (size_t)cap);
+        if (!g) { loaded_level_free(lvl); return; }
+        l->garbage = g;
+        l->garbage_cap = cap;
+    }
+    l->garbage[l->garbage_count++] = *lvl;
+    memset(lvl, 0, sizeof(*lvl));
+}
+
+// Free the queued garbage, then load the queued request. Called with mtx
+// held; it is released around the work.
+static void do_work(LevelLoader* l) {
+    while (l->garbage_count > 0) {
+        LoadedLevel old = l->garbage[--l->garbage_count];
+        pthread_mutex_unlock(&l->mtx);
+        loaded_level_free(&old);
+        pthread_mutex_lock(&l->mtx);
+    }
+    if (!l->path || l->quit) return;
+    char* path = l->path;
+    unsigned gen = l->generation;
+    bool reload = l->reload;
+    GridMap cur = l->current;
+    l->path = NULL;
+    l->in_flight = true;
+    pthread_mutex_unlock(&l->mtx);
+
+    LoadedLevel lvl;
+    int rc = reload ? reload_level(l, gen, path, &cur, &lvl) : load_level(l, gen, path, &lvl);
+    if (rc == 0) lvl.path = path;
+    else free(path);
+
+    pthread_mutex_lock(&l->mtx);
+    l->in_flight = false;
+    if (rc == 0 && gen == l->generation) {
+        l->ready = lvl;
+        l->has_ready = true;
+    } else if (rc == 0) {
+        push_garbage(l, &lvl);             // superseded after the last check
+    } else if (rc < 0 && gen == l->generation) {
+        l->failed = true;
+    }
+}
+
+static void* loader_main(void* param) {
+    LevelLoader* l = (LevelLoader*)param;
+    pthread_mutex_lock(&l->mtx);
+    for (;;) {
+        while (!l->quit && !l->path && l->garbage_count == 0)
+            pthread_cond_wait(&l->work_cv, &l->mtx);
+        if (l->quit) break;
+        do_work(l);
+    }
+    pthread_mutex_unlock(&l->mtx);
+    return NULL;
+}
+
+LevelLoader* level_loader_create(const LevelLoaderConfig* cfg) {
+    LevelLoader* l = (LevelLoader*)calloc(1, sizeof(*l));
+    if (!l) return NULL;
+    l->cfg = *cfg;
+    pthread_mutex_init(&l->mtx, NULL);
+    pthread_cond_init(&l->work_cv, NULL);
+    l->started = cfg->threaded && pthread_create(&l->thread, NULL, loader_main, l) == 0;
+    return l;
+}
+
+void level_loader_destroy(LevelLoader* l) {
+    if (!l) return;
+    pthread_mutex_lock(&l->mtx);
+    l->quit = true;
+    __atomic_add_fetch(&l->generation, 1, __ATOMIC_RELAXED);   // cancel the load in flight
+    pthread_cond_signal(&l->work_cv);
+    pthread_mutex_unlock(&l->mtx);
+    if (l->started) pthread_join(l->thread, NULL);
+
+    while (l->garbage_count > 0) loaded_level_free(&l->garbage[--l->garbage_count]);
+    if (l->has_ready) loaded_level_free(&l->ready);
+    free(l->garbage);
+    free(l->path);
+    pthread_cond_destroy(&l->work_cv);
+    pthread_mutex_destroy(&l->mtx);
+    free(l);
+}
+
+// Queue a request (a reload when 'current' is set).
+static void request(LevelLoader* l, const char* path, const GridMap* current) {
+    char* copy = strdup(path);
+    pthread_mutex_lock(&l->mtx);
+    free(l->path);
+    l->path = copy;
+    l->reload = current != NULL;
+    if (current) l->current = *current;
+    __atomic_add_fetch(&l->generation, 1, __ATOMIC_RELAXED);
+    if (l->has_ready) { push_garbage(l, &l->ready); l->has_ready = false; }
+    l->failed = !copy;
+    pthread_cond_signal(&l->work_cv);
+    pthread_mutex_unlock(&l->mtx);
+}
+
+void level_loader_request(LevelLoader* l, const char* path) {
+    request(l, path, NULL);
+}
+
+void level_loader_reload(LevelLoader* l, const char* path, const GridMap* current) {
+    request(l, path, current);
+}
+
+LevelLoadStatus level_loader_poll(LevelLoader* l, LoadedLevel* out) {
+    LevelLoadStatus st = LEVEL_LOAD_IDLE;
+    pthread_mutex_lock(&l->mtx);
+    if (!l->started) do_work(l);
+    if (l->has_ready) {
+        *out = l->ready;
+        loaded_level_fix(out);
+        memset(&l->ready, 0, sizeof(l->ready));
+        l->has_ready = false;
+        st = LEVEL_LOAD_READY;
+    } else if (l->failed) {
+        l->failed = false;
+        st = LEVEL_LOAD_FAILED;
+    } else if (l->path || l->in_flight) {
+        st = LEVEL_LOAD_BUSY;
+    }
+    pthread_mutex_unlock(&l->mtx);
+    return st;
+}
+
+void level_loader_release(LevelLoader* l, LoadedLevel* lvl) {
+    pthread_mutex_lock(&l->mtx);
+    push_garbage(l, lvl);
+    if (!l->started) do_work(l);
+    pthread_cond_signal(&l->work_cv);
+    pthread_mutex_unlock(&l->mtx);
+}
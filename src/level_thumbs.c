@@ -0,0 +1,288 @@
+#include "level_thumbs.h"
+#include "map_bin.h"
+#include "types.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct ThumbHeader {
+    char     magic[8];     // LEVEL_THUMB_MAGIC, no terminator
+    uint32_t version;      // LEVEL_THUMB_VERSION
+    int32_t  w, h;
+    uint32_t reserved;
+    uint64_t hash;         // content hash of the level
+} ThumbHeader;
+
+typedef struct Job {
+    size_t   item;
+    char*    path;
+    uint64_t hash;
+} Job;
+
+typedef struct JobQueue {
+    Job*   jobs;
+    size_t count, next, cap;
+} JobQueue;
+
+struct LevelThumbs {
+    char*           dir;
+    int             size;
+    pthread_t*      threads;
+    int             nthreads;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t  work_cv;   // jobs were queued, or quit
+
+    // guarded by mtx
+    JobQueue        shown;     // current request, before anything else
+    JobQueue        warm;      // cache only
+    LevelThumb*     done;      // finished thumbnails of the current request
+    size_t          done_count, done_cap;
+    unsigned        generation; // bumped per request
+    unsigned        tmp_serial; // temporary file names
+    bool            quit;
+};
+
+static void queue_clear(JobQueue* q) {
+    for (size_t i = q->next; i < q->count; ++i) free(q->jobs[i].path);
+    q->count = q->next = 0;
+}
+
+static void queue_free(JobQueue* q) {
+    queue_clear(q);
+    free(q->jobs);
+    memset(q, 0, sizeof(*q));
+}
+
+// Append copies of 'jobs'. Jobs that do not fit (out of memory) are left out.
+static void queue_add(JobQueue* q, const LevelThumbJob* jobs, size_t n) {
+    if (q->next == q->count) q->count = q->next = 0;
+    if (q->count + n > q->cap) {
+        size_t cap = q->cap ? q->cap : 16;
+        while (cap < q->count + n) cap *= 2;
+        Job* j = (Job*)realloc(q->jobs, cap * sizeof(Job));
+        if (!j) return;
+        q->jobs = j;
+        q->cap = cap;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        char* p = strdup(jobs[i].path);
+        if (!p) continue;
+        q->jobs[q->count++] = (Job){ jobs[i].item, p, jobs[i].hash };
+    }
+}
+
+static void drop_done(LevelThumbs* t) {
+    for (size_t i = 0; i < t->done_count; ++i) free(t->done[i].px);
+    t->done_count = 0;
+}
+
+void level_thumb_render(const GridMap* m, int size, uint32_t* px, int* out_w, int* out_h) {
+    // the minimap's colors, blended by how much of a pixel's cells are walls
+    const Color floor = rgba(30, 30, 30, 255), wall = rgba(220, 220, 220, 255);
+    int big = m->w > m->h ? m->w : m->h;
+    int tw = (int)((int64_t)size * m->w / big), th = (int)((int64_t)size * m->h / big);
+    if (tw < 1) tw = 1;
+    if (th < 1) th = 1;
+    for (int ty = 0; ty < th; ++ty) {
+        int y0 = (int)((int64_t)ty * m->h / th), y1 = (int)((int64_t)(ty + 1) * m->h / th);
+        if (y1 <= y0) y1 = y0 + 1;
+        for (int tx = 0; tx < tw; ++tx) {
+            int x0 = (int)((int64_t)tx * m->w / tw), x1 = (int)((int64_t)(tx + 1) * m->w / tw);
+            if (x1 <= x0) x1 = x0 + 1;
+            int64_t walls = 0, cells = (int64_t)(x1 - x0) * (y1 - y0);
+            for (int y = y0; y < y1; ++y)
+                for (int x = x0; x < x1; ++x)
+                    walls += map_at(m, x, y) != 0;
+            int f = (int)(walls * 255 / cells);
+            Color c = rgba((uint8_t)(floor.r + (wall.r - floor.r) * f / 255),
+                           (uint8_t)(floor.g + (wall.g - floor.g) * f / 255),
+                           (uint8_t)(floor.b + (wall.b - floor.b) * f / 255), 255);
+            px[(size_t)ty * (size_t)tw + (size_t)tx] = color_to_u32(c);
+        }
+    }
+    *out_w = tw;
+    *out_h = th;
+}
+
+static char* cache_path(const LevelThumbs* t, uint64_t hash) {
+    size_t n = strlen(t->dir) + 1 + 16 + sizeof(LEVEL_THUMB_EXT);
+    char* p = (char*)malloc(n);
+    if (p) snprintf(p, n, "%s/%016llx%s", t->dir, (unsigned long long)hash, LEVEL_THUMB_EXT);
+    return p;
+}
+
+static bool read_cached(const LevelThumbs* t, const char* path, uint64_t hash, LevelThumb* out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    ThumbHeader hd;
+    bool ok = fread(&hd, sizeof(hd), 1, f) == 1 && memcmp(hd.magic, LEVEL_THUMB_MAGIC, 8) == 0
+           && hd.version == LEVEL_THUMB_VERSION && hd.hash == hash
+           && hd.w > 0 && hd.h > 0 && hd.w <= t->size && hd.h <= t->size
+           && (hd.w == t->size || hd.h == t->size);   // made for another size: redo
+    size_t n = ok ? (size_t)hd.w * (size_t)hd.h : 0;
+    uint32_t* px = ok ? (uint32_t*)malloc(n * sizeof(uint32_t)) : NULL;
+    ok = px && fread(px, sizeof(uint32_t), n, f) == n;
+    fclose(f);
+    if (!ok) { free(px); return false; }
+    out->w = hd.w;
+    out->h = hd.h;
+    out->px = px;
+    return true;
+}
+
+// Through a temporary file renamed into place; failures only cost a rerender.
+static void write_cached(LevelThumbs* t, const char* path, uint64_t hash, const LevelThumb* th) {
+    unsigned serial = __atomic_fetch_add(&t->tmp_serial, 1, __ATOMIC_RELAXED);
+    size_t tl = strlen(path) + 16;
+    char* tmp = (char*)malloc(tl);
+    if (!tmp) return;
+    snprintf(tmp, tl, "%s.%u.tmp", path, serial);
+    FILE* f = fopen(tmp, "wb");
+    if (f) {
+        ThumbHeader hd = { .version = LEVEL_THUMB_VERSION, .w = th->w, .h = th->h, .hash = hash };
+        memcpy(hd.magic, LEVEL_THUMB_MAGIC, 8);
+        size_t n = (size_t)th->w * (size_t)th->h;
+        bool ok = fwrite(&hd, sizeof(hd), 1, f) == 1 && fwrite(th->px, sizeof(uint32_t), n, f) == n;
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp, path) != 0) remove(tmp);
+    }
+    free(tmp);
+}
+
+// Read the level (its compiled form when up to date) and render it.
+static bool render_level(const LevelThumbs* t, const char* path, LevelThumb* out) {
+    GridMap m = { 0 };
+    MapBin bin = { 0 };
+    uint8_t* data = NULL;
+    char* binp = map_bin_path_for(path);
+    if (binp && map_bin_is_fresh(binp, path) && map_bin_open(&bin, binp, false, NULL) == 0) {
+        m = bin.map;
+    } else if (map_parse_cub3d_file(path, &data, &m.w, &m.h, NULL) == 0) {
+        m.data = data;
+    }
+    free(binp);
+    bool ok = m.data && (out->px = (uint32_t*)malloc((size_t)t->size * (size_t)t->size * sizeof(uint32_t)));
+    if (ok) level_thumb_render(&m, t->size, out->px, &out->w, &out->h);
+    map_bin_close(&bin);
+    free(data);
+    return ok;
+}
+
+// A thumbnail for 'job': from the cache, else rendered and cached. With
+// 'want' false only makes sure the cache has it.
+static bool produce(LevelThumbs* t, const Job* job, bool want, LevelThumb* out) {
+    memset(out, 0, sizeof(*out));
+    out->item = job->item;
+    char* cp = cache_path(t, job->hash);
+    if (!cp) return false;
+    bool ok;
+    if (!want && access(cp, F_OK) == 0) ok = true;
+    else if (want && read_cached(t, cp, job->hash, out)) ok = true;
+    else if ((ok = render_level(t, job->path, out))) write_cached(t, cp, job->hash, out);
+    free(cp);
+    return ok;
+}
+
+static void* thumbs_main(void* param) {
+    LevelThumbs* t = (LevelThumbs*)param;
+    pthread_mutex_lock(&t->mtx);
+    for (;;) {
+        while (!t->quit && t->shown.next == t->shown.count && t->warm.next == t->warm.count)
+            pthread_cond_wait(&t->work_cv, &t->mtx);
+        if (t->quit) break;
+        bool want = t->shown.next < t->shown.count;
+        Job job = want ? t->shown.jobs[t->shown.next++] : t->warm.jobs[t->warm.next++];
+        unsigned gen = t->generation;
+        pthread_mutex_unlock(&t->mtx);
+
+        LevelThumb th;
+        bool ok = produce(t, &job, want, &th);
+        free(job.path);
+
+        pthread_mutex_lock(&t->mtx);
+        if (ok && want && gen == t->generation) {
+            if (t->done_count == t->done_cap) {
+                size_t cap = t->done_cap ? t->done_cap * 2 : 8;
+                LevelThumb* d = (LevelThumb*)realloc(t->done, cap * sizeof(LevelThumb));
+                if (d) { t->done = d; t->done_cap = cap; }
+            }
+            if (t->done_count < t->done_cap) { t->done[t->done_count++] = th; th.px = NULL; }
+        }
+        free(th.px);
+    }
+    pthread_mutex_unlock(&t->mtx);
+    return NULL;
+}
+
+LevelThumbs* level_thumbs_create(const char* cache_dir, int size, int threads) {
+    LevelThumbs* t = (LevelThumbs*)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    if (threads <= 0) threads = 2;
+    t->dir = strdup(cache_dir);
+    t->size = size > 0 ? size : 1;
+    t->threads = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (!t->dir || !t->threads) { free(t->dir); free(t->threads); free(t); return NULL; }
+    if (mkdir(cache_dir, 0755) != 0 && errno != EEXIST)
+        fprintf(stderr, "thumbnail cache '%s': %s\n", cache_dir, strerror(errno));
+    pthread_mutex_init(&t->mtx, NULL);
+    pthread_cond_init(&t->work_cv, NULL);
+    for (int i = 0; i < threads; ++i) {
+        if (pthread_create(&t->threads[t->nthreads], NULL, thumbs_main, t) != 0) break;
+        t->nthreads++;
+    }
+    if (t->nthreads == 0) { level_thumbs_destroy(t); return NULL; }
+    return t;
+}
+
+void level_thumbs_destroy(LevelThumbs* t) {
+    if (!t) return;
+    pthread_mutex_lock(&t->mtx);
+    t->quit = true;
+    pthread_cond_broadcast(&t->work_cv);
+    pthread_mutex_unlock(&t->mtx);
+    for (int i = 0; i < t->nthreads; ++i) pthread_join(t->threads[i], NULL);
+
+    queue_free(&t->shown);
+    queue_free(&t->warm);
+    drop_done(t);
+    free(t->done);
+    free(t->threads);
+    free(t->dir);
+    pthread_cond_destroy(&t->work_cv);
+    pthread_mutex_destroy(&t->mtx);
+    free(t);
+}
+
+void level_thumbs_request(LevelThumbs* t, const LevelThumbJob* jobs, size_t n) {
+    pthread_mutex_lock(&t->mtx);
+    t->generation++;
+    queue_clear(&t->shown);
+    drop_done(t);
+    queue_add(&t->shown, jobs, n);
+    pthread_cond_broadcast(&t->work_cv);
+    pthread_mutex_unlock(&t->mtx);
+}
+
+void level_thumbs_warm(LevelThumbs* t, const LevelThumbJob* jobs, size_t n) {
+    pthread_mutex_lock(&t->mtx);
+    queue_add(&t->warm, jobs, n);
+    pthread_cond_broadcast(&t->work_cv);
+    pthread_mutex_unlock(&t->mtx);
+}
+
+bool level_thumbs_take(LevelThumbs* t, LevelThumb* out) {
+    pthread_mutex_lock(&t->mtx);
+    bool got = t->done_count > 0;
+    if (got) {
+        *out = t->done[0];
+        memmove(t->done, t->done + 1, (t->done_count - 1) * sizeof(LevelThumb));
+        t->done_count--;
+    }
+    pthread_mutex_unlock(&t->mtx);
+    return got;
+}
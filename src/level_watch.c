@@ -0,0 +1,110 @@
+#include "level_watch.h"
+#include "util.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/inotify.h>
+#endif
+
+struct LevelWatch {
+    char*       path;
+    const char* name;        // file name part of 'path'
+    int         fd;          // inotify instance (-1 = polling)
+    int64_t     mtime_ns;    // polling: last seen
+    int64_t     size;
+    double      next_ms;     // polling: next stat
+};
+
+static void stat_file(LevelWatch* w, int64_t* mtime_ns, int64_t* size) {
+    struct stat st;
+    if (stat(w->path, &st) != 0) { *mtime_ns = -1; *size = -1; return; }
+    *mtime_ns = ST_MTIME_NS(st);
+    *size = (int64_t)st.st_size;
+}
+
+#ifdef __linux__
+// inotify on the directory: writes finished in place, or a new file renamed
+// over the old one.
+static int watch_dir(const LevelWatch* w) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return -1;
+    // the path up to the name, without its last slash unless that is the
+    // root ("/x.cub3d" -> "/"); "." when there is no slash
+    size_t dl = (size_t)(w->name - w->path);
+    if (dl > 1) --dl;
+    char* dir = (char*)malloc(dl + 2);
+    if (dir) {
+        if (dl) { memcpy(dir, w->path, dl); dir[dl] = '\0'; }
+        else strcpy(dir, ".");
+    }
+    if (!dir || inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) { close(fd); fd = -1; }
+    free(dir);
+    return fd;
+}
+
+// Drain the queued events; true when one was about the file.
+static bool read_events(LevelWatch* w) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool hit = false;
+    for (;;) {
+        ssize_t n = read(w->fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        for (ssize_t off = 0; off < n;) {
+            const struct inotify_event* ev = (const struct inotify_event*)(buf + off);
+            if (ev->len && strcmp(ev->name, w->name) == 0) hit = true;
+            if (ev->mask & IN_Q_OVERFLOW) hit = true;   // events were lost
+            off += (ssize_t)sizeof(*ev) + ev->len;
+        }
+    }
+    return hit;
+}
+#endif
+
+LevelWatch* level_watch_create(const char* path) {
+    LevelWatch* w = (LevelWatch*)calloc(1, sizeof(*w));
+    if (!w || !(w->path = strdup(path))) { free(w); return NULL; }
+    const char* slash = strrchr(w->path, '/');
+    w->name = slash ? slash + 1 : w->path;
+    w->fd = -1;
+#ifdef __linux__
+    w->fd = watch_dir(w);
+#endif
+    if (w->fd < 0) {
+        stat_file(w, &w->mtime_ns, &w->size);
+        w->next_ms = util_now_ms() + LEVEL_WATCH_POLL_MS;
+    }
+    return w;
+}
+
+void level_watch_destroy(LevelWatch* w) {
+    if (!w) return;
+    if (w->fd >= 0) close(w->fd);
+    free(w->path);
+    free(w);
+}
+
+bool level_watch_changed(LevelWatch* w) {
+#ifdef __linux__
+    if (w->fd >= 0) return read_events(w);
+#endif
+    double now = util_now_ms();
+    if (now < w->next_ms) return false;
+    w->next_ms = now + LEVEL_WATCH_POLL_MS;
+    int64_t mtime_ns, size;
+    stat_file(w, &mtime_ns, &size);
+    if (mtime_ns == w->mtime_ns && size == w->size) return false;
+    w->mtime_ns = mtime_ns;
+    w->size = size;
+    return mtime_ns >= 0;   // a missing file is not a change to load
+}
+
+const char* level_watch_path(const LevelWatch* w) {
+    return w->path;
+}
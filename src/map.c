@@ -1,16 +1,26 @@
 #include "map.h"
+#include "map_occ.h"
+#include "util.h"
 #include <dirent.h>
 #include <sys/stat.h>
 #include <ctype.h>
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 const int WORLD_W = 24;
 const int WORLD_H = 24;
 
 /* 0 = empty, >0 = wall type */
-const int WORLD_DATA[] = {
+const uint8_t WORLD_DATA[24 * 24 + MAP_PAD] = {
 /* A tiny Wolf3D-like test map */
 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,
@@ -40,13 +50,53 @@ const int WORLD_DATA[] = {
 
 int map_at(const GridMap* m, int x, int y) {
     if ((unsigned)x >= (unsigned)m->w || (unsigned)y >= (unsigned)m->h) return 1; /* treat out-of-bounds as wall */
-    return m->data[y * m->w + x];
+    return m->data[map_index(m, x, y)];
 }
 
 int map_is_wall(const GridMap* m, int x, int y) {
     return map_at(m, x, y) > 0;
 }
 
+int map_plane_at(const GridMap* m, MapPlane p, int x, int y) {
+    if ((unsigned)p >= MAP_PLANE_COUNT || !m->plane[p]) return 0;
+    if ((unsigned)x >= (unsigned)m->w || (unsigned)y >= (unsigned)m->h) return 0;
+    return m->plane[p][map_index(m, x, y)];
+}
+
+MapMemory map_memory(const GridMap* m) {
+    MapMemory r;
+    memset(&r, 0, sizeof(r));
+    size_t cells = map_layout_bytes(m->layout, m->w, m->h);
+    r.tiles = cells;
+    for (int p = 0; p < MAP_PLANE_COUNT; ++p)
+        if (m->plane[p]) r.planes += cells;
+    if (m->dist) r.dist = cells;
+    if (m->occ)  r.occ = map_occ_bytes(m->occ);
+    r.total = r.tiles + r.planes + r.dist + r.occ;
+    r.int_tiles = (size_t)m->w * (size_t)m->h * sizeof(int);
+    return r;
+}
+
+size_t map_layout_bytes(MapLayout layout, int w, int h) {
+    if (w <= 0 || h <= 0) return 0;
+    if (layout == MAP_LAYOUT_ROWS) return (size_t)w * (size_t)h;
+    size_t cw = (size_t)((w + MAP_CHUNK - 1) >> MAP_CHUNK_LOG2);
+    size_t ch = (size_t)((h + MAP_CHUNK - 1) >> MAP_CHUNK_LOG2);
+    return (cw * ch) << (2 * MAP_CHUNK_LOG2);
+}
+
+uint8_t* map_convert_layout(const uint8_t* src, MapLayout from, MapLayout to, int w, int h) {
+    size_t n = map_layout_bytes(to, w, h);
+    if (!src || n == 0) return NULL;
+    /* chunk cells past the map edge stay 0 and are never addressed */
+    uint8_t* dst = (uint8_t*)calloc(n + MAP_PAD, 1);
+    if (!dst) return NULL;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            dst[map_index_in(to, w, x, y)] = src[map_index_in(from, w, x, y)];
+    return dst;
+}
+
 static int has_ext_cub3d(const char* name) {
     if (!name) return 0;
     const char* dot = strrchr(name, '.');
@@ -124,115 +174,183 @@ void map_free_paths(char** paths, size_t count) {
     free(paths);
 }
 
-// Very lenient integer parser for a line (digits + optional spaces).
-// Appends parsed ints to a growing buffer (realloc).
-static int parse_line_ints(const char* line, int** buf, size_t* len, size_t* cap) {
-    const char* p = line;
-    while (*p) {
-        while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
-        if (*p == '\0' || *p == '\n') break;
-        if (*p == '#') break; // rest of line is comment
-        // read an integer (single digit 0-9 or multi-digit)
-        int neg = 0;
-        if (*p == '+') { ++p; }
-        else if (*p == '-') { neg = 1; ++p; }
-        if (!isdigit((unsigned char)*p)) {
-            // invalid token: bail out
-            return -1;
-        }
-        long v = 0;
-        while (isdigit((unsigned char)*p)) { v = v*10 + (*p - '0'); ++p; }
-        if (neg) v = -v;
-
-        if (*len == *cap) {
-            size_t nc = (*cap ? *cap * 2 : 64);
-            int* nb = (int*)realloc(*buf, nc * sizeof(int));
-            if (!nb) return -1;
-            *buf = nb; *cap = nc;
-        }
-        (*buf)[(*len)++] = (int)v;
+#ifndef MAP_PARSE_MMAP_MIN
+#define MAP_PARSE_MMAP_MIN (64 * 1024)   // smaller level files are read()
+#endif
 
-        while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
-        if (*p == ',' ) ++p; // optional comma separator
-    }
-    return 0;
+static inline int is_blank(unsigned char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+#if defined(__SSE2__)
+// Fast path for the bulk of most maps: 16 bytes of one-digit tiles each
+// followed by ',' or ' ' ("1,0,0,2,..."), stored as 8 tiles at once.
+// Anything else (wider ids, signs, tabs, comments) takes the scalar path.
+static inline int digits8_sse2(const char* q, uint8_t* out) {
+    __m128i x = _mm_loadu_si128((const __m128i*)q);
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+    __m128i sep = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(',')), _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+    if (_mm_movemask_epi8(digit) != 0x5555 || _mm_movemask_epi8(sep) != 0xAAAA) return 0;
+    __m128i v = _mm_and_si128(d, _mm_set1_epi16(0x00FF));
+    _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(v, v));
+    return 1;
 }
+#endif
 
-int map_parse_cub3d_file(const char* path, int** out_data, int* out_w, int* out_h, char** out_err) {
+// Single pass over the text, row by row (memchr finds each line end, so
+// rows can be any length). Tokens: optional sign, digits, then optional
+// blanks and one ','; '#' starts a comment. The first row sizes the buffer
+// for every line left, later rows write straight into it and fail as soon
+// as they run longer than the first.
+int map_parse_cub3d(const char* text, size_t len, uint8_t** out_data, int* out_w, int* out_h, char** out_err) {
     if (out_err) *out_err = NULL;
-    if (!out_data || !out_w || !out_h || !path) return -1;
+    if (!out_data || !out_w || !out_h || (!text && len)) return -1;
+    const char* end = text + len;
 
-    FILE* f = fopen(path, "rb");
-    if (!f) {
-        if (out_err) {
-            size_t n = strlen(strerror(errno)) + 64 + strlen(path);
-            *out_err = (char*)malloc(n);
-            if (*out_err) snprintf(*out_err, n, "cannot open '%s': %s", path, strerror(errno));
-        }
-        return -1;
-    }
+    size_t lines = 1;
+    for (const char* q = text; q < end && (q = (const char*)memchr(q, '\n', (size_t)(end - q))); ++q) ++lines;
 
-    int* buf = NULL; size_t len = 0, cap = 0;
-    int width = -1, height = 0;
-    char line[4096];
-
-    while (fgets(line, sizeof(line), f)) {
-        const char* p = line;
-        // skip comments/empty
-        while (*p == ' ' || *p == '\t') ++p;
-        if (*p == '#' || *p == '\n' || *p == '\0') continue;
-
-        // Remember length before parsing this row
-        size_t len_before = len;
-        if (parse_line_ints(line, &buf, &len, &cap) != 0) {
-            if (out_err) {
-                const char* msg = "invalid token in map line";
-                *out_err = (char*)malloc(strlen(msg)+1);
-                if (*out_err) strcpy(*out_err, msg);
+    uint8_t* buf = NULL;
+    size_t n = 0, cap = 0;
+    long width = -1;
+    int height = 0, line_no = 0;
+    const char* p = text;
+    while (p < end) {
+        const char* ls = p;
+        const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char* le = nl ? nl : end;
+        ++line_no;
+        p = nl ? nl + 1 : end;
+
+        const char* q = ls;
+        while (q < le && (*q == ' ' || *q == '\t')) ++q;
+        if (q == le || *q == '#') continue;
+
+        size_t row_start = n;
+        while (q < le) {
+#if defined(__SSE2__)
+            // needs room: the reservation (first row: the buffer) and the row width
+            if (le - q >= 16 && (width < 0 ? n + 8 + MAP_PAD < cap : (long)(n - row_start) + 8 <= width)
+                && digits8_sse2(q, buf + n)) {
+                n += 8;
+                q += 15;   // the last separator: a blank may still be followed by ','
+                while (q < le && is_blank((unsigned char)*q)) ++q;
+                if (q < le && *q == ',') ++q;
+                continue;
             }
-            fclose(f);
-            free(buf);
-            return -1;
+#endif
+            unsigned char c = (unsigned char)*q;
+            if (is_blank(c)) { ++q; continue; }
+            if (c == '#') break; // rest of line is comment
+            const char* tok = q;
+            int neg = c == '-';
+            if ((c == '+' || c == '-') && ++q < le) c = (unsigned char)*q;
+            unsigned v = (unsigned)c - '0';
+            if (q == le || v > 9) {
+                free(buf);
+                return util_error(out_err, "line %d, column %d: invalid token in map line", line_no, (int)(q - ls) + 1);
+            }
+            for (unsigned d; ++q < le && (d = (unsigned)(unsigned char)*q - '0') <= 9; )
+                v = v * 10 + d > 255 ? 256 : v * 10 + d;
+            if (v > 255 || (neg && v)) {
+                free(buf);
+                return util_error(out_err, "line %d, column %d: tile id out of range (0-255)", line_no, (int)(tok - ls) + 1);
+            }
+            if (width >= 0 && (long)(n - row_start) == width) {
+                free(buf);
+                return util_error(out_err, "line %d, column %d: non-rectangular map (more than %ld tiles in a row)",
+                                  line_no, (int)(tok - ls) + 1, width);
+            }
+            if (n + MAP_PAD >= cap) {   // first row only: later rows fit the reservation
+                size_t nc = cap ? cap * 2 : 64;
+                uint8_t* nb = (uint8_t*)realloc(buf, nc);
+                if (!nb) { free(buf); return util_error(out_err, "out of memory"); }
+                buf = nb; cap = nc;
+            }
+            buf[n++] = (uint8_t)v;
+            while (q < le && is_blank((unsigned char)*q)) ++q;
+            if (q < le && *q == ',') ++q; // optional comma separator
         }
-        size_t row_w = len - len_before;
+
+        size_t row_w = n - row_start;
         if (row_w == 0) continue; // empty row after filters
-        if (width < 0) width = (int)row_w;
-        else if ((int)row_w != width) {
-            if (out_err) {
-                const char* msg = "non-rectangular map (rows have different widths)";
-                *out_err = (char*)malloc(strlen(msg)+1);
-                if (*out_err) strcpy(*out_err, msg);
+        if (width < 0) {
+            width = (long)row_w;
+            if (width > INT_MAX) { free(buf); return util_error(out_err, "line %d: row too long", line_no); }
+            // at most one row per line left
+            size_t rows = lines - (size_t)line_no + 1;
+            if (rows > (SIZE_MAX - MAP_PAD) / row_w) { free(buf); return util_error(out_err, "map too large"); }
+            size_t want = row_w * rows + MAP_PAD;
+            if (want > cap) {
+                uint8_t* nb = (uint8_t*)realloc(buf, want);
+                if (!nb) { free(buf); return util_error(out_err, "out of memory"); }
+                buf = nb; cap = want;
             }
-            fclose(f);
+        } else if ((long)row_w != width) {
             free(buf);
-            return -1;
+            return util_error(out_err, "line %d: non-rectangular map (%zu tiles, expected %ld)", line_no, row_w, width);
         }
+        if (height == INT_MAX) { free(buf); return util_error(out_err, "map too large"); }
         height++;
     }
-    fclose(f);
 
     if (width <= 0 || height <= 0) {
-        if (out_err) {
-            const char* msg = "empty or invalid map";
-            *out_err = (char*)malloc(strlen(msg)+1);
-            if (*out_err) strcpy(*out_err, msg);
-        }
-        free(buf);
-        return -1;
-    }
-    if ((size_t)(width * height) != len) {
-        // Shouldn't happen if we enforced rectangularity
-        if (out_err) {
-            const char* msg = "internal size mismatch";
-            *out_err = (char*)malloc(strlen(msg)+1);
-            if (*out_err) strcpy(*out_err, msg);
-        }
         free(buf);
-        return -1;
+        return util_error(out_err, "empty or invalid map");
     }
-
+    memset(buf + n, 0, MAP_PAD);
     *out_data = buf;
-    *out_w = width;
+    *out_w = (int)width;
     *out_h = height;
     return 0;
 }
+
+int map_parse_cub3d_file(const char* path, uint8_t** out_data, int* out_w, int* out_h, char** out_err) {
+    if (out_err) *out_err = NULL;
+    if (!out_data || !out_w || !out_h || !path) return -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return util_error(out_err, "cannot open '%s': %s", path, strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int e = errno;
+        close(fd);
+        return util_error(out_err, "cannot read '%s': %s", path, strerror(e));
+    }
+    // big regular files are mapped; small ones (where setting up the mapping
+    // costs more than copying), other files and failed maps are read
+    size_t len = S_ISREG(st.st_mode) ? (size_t)st.st_size : 0;
+    void* map = len >= MAP_PARSE_MMAP_MIN ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    char* text = NULL;
+    if (map != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+        madvise(map, len, MADV_SEQUENTIAL);
+#endif
+    } else {
+        size_t cap = len ? len + 1 : 65536;   // + 1: EOF without another grow
+        len = 0;
+        text = (char*)malloc(cap);
+        for (ssize_t r = 1; text && r > 0; ) {
+            if (len == cap) {
+                char* nt = (char*)realloc(text, cap * 2);
+                if (!nt) { free(text); text = NULL; break; }
+                text = nt; cap *= 2;
+            }
+            r = read(fd, text + len, cap - len);
+            if (r > 0) len += (size_t)r;
+            else if (r < 0 && errno == EINTR) r = 1;
+            else if (r < 0) {
+                int e = errno;
+                free(text);
+                close(fd);
+                return util_error(out_err, "cannot read '%s': %s", path, strerror(e));
+            }
+        }
+        if (!text) { close(fd); return util_error(out_err, "out of memory"); }
+    }
+    close(fd);
+
+    int rc = map_parse_cub3d(map != MAP_FAILED ? (const char*)map : text, len, out_data, out_w, out_h, out_err);
+    if (map != MAP_FAILED) munmap(map, len);
+    free(text);
+    return rc;
+}
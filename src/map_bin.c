@@ -0,0 +1,262 @@
+#include "map_bin.h"
+#include "util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline uint64_t align_up(uint64_t v) {
+    return (v + MAP_BIN_ALIGN - 1) & ~(uint64_t)(MAP_BIN_ALIGN - 1);
+}
+
+static inline uint64_t data_offset(uint32_t sections) {
+    return align_up(sizeof(MapBinHeader) + (uint64_t)sections * sizeof(MapBinSection));
+}
+
+// FNV-1a style multiply-xor over 64-bit words in four independent lanes
+// (one multiply chain is latency bound), then the tail bytes.
+uint64_t map_bin_hash(const void* p, size_t n) {
+    const uint64_t prime = 0x100000001b3ull;
+    uint64_t h[4] = { 0xcbf29ce484222325ull, 0x84222325cbf29ce4ull, 0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full };
+    const unsigned char* s = (const unsigned char*)p;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+        for (int k = 0; k < 4; ++k) {
+            uint64_t w;
+            memcpy(&w, s + i + 8 * k, 8);
+            h[k] = (h[k] ^ w) * prime;
+        }
+    uint64_t r = (uint64_t)n;
+    for (int k = 0; k < 4; ++k) r = (r ^ h[k]) * prime;
+    for (; i < n; ++i) r = (r ^ s[i]) * prime;
+    return r ^ (r >> 29);
+}
+
+static uint64_t header_hash(const MapBinHeader* hd, const MapBinSection* table) {
+    MapBinHeader tmp = *hd;
+    tmp.header_hash = 0;
+    uint64_t a = map_bin_hash(&tmp, sizeof(tmp));
+    return a ^ (map_bin_hash(table, (size_t)hd->section_count * sizeof(MapBinSection)) * 0x9e3779b97f4a7c15ull);
+}
+
+static bool is_byte_section(uint32_t kind) {
+    return kind == MAP_BIN_TILES || kind == MAP_BIN_DIST
+        || (kind >= MAP_BIN_PLANE0 && kind < MAP_BIN_PLANE0 + MAP_PLANE_COUNT);
+}
+
+// What is wrong with the header fields read before the table, or NULL.
+static const char* table_problem(const MapBinHeader* hd, size_t size) {
+    if (memcmp(hd->magic, MAP_BIN_MAGIC, 8) != 0) return "not a compiled level";
+    if (hd->version != MAP_BIN_VERSION) return "unsupported version";
+    if (hd->section_count == 0 || hd->section_count > MAP_BIN_MAX_SECTIONS
+        || data_offset(hd->section_count) > size) return "bad section table";
+    return NULL;
+}
+
+// ... and with the rest of the header, once the table is there.
+static const char* header_problem(const MapBinHeader* hd, const MapBinSection* table, size_t size) {
+    if (hd->header_hash != header_hash(hd, table)) return "header checksum mismatch";
+    if (hd->file_bytes != size) return "truncated file";
+    if (hd->w <= 0 || hd->h <= 0 || hd->tile_bytes != 1) return "bad dimensions";
+    if (hd->layout > MAP_LAYOUT_CHUNKED
+        || (hd->layout == MAP_LAYOUT_CHUNKED && hd->chunk_log2 != MAP_CHUNK_LOG2)) return "unsupported tile layout";
+    return NULL;
+}
+
+int map_bin_read_table(const char* path, MapBinHeader* hd, MapBinSection* table, char** err) {
+    if (err) *err = NULL;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return util_error(err, "cannot open '%s': %s", path, strerror(errno));
+    struct stat st;
+    const char* why = NULL;
+    if (fstat(fd, &st) != 0) why = "cannot stat";
+    else if (pread(fd, hd, sizeof(*hd), 0) != (ssize_t)sizeof(*hd)) why = "too small for a compiled level";
+    else why = table_problem(hd, (size_t)st.st_size);
+    size_t table_bytes = why ? 0 : hd->section_count * sizeof(MapBinSection);
+    if (!why && pread(fd, table, table_bytes, sizeof(*hd)) != (ssize_t)table_bytes) why = "truncated file";
+    if (!why) why = header_problem(hd, table, (size_t)st.st_size);
+    for (uint32_t i = 0; !why && i < hd->section_count; ++i)
+        if (table[i].offset > (uint64_t)st.st_size || table[i].bytes > (uint64_t)st.st_size - table[i].offset)
+            why = "section out of bounds";
+    if (why) { close(fd); return util_error(err, "'%s': %s", path, why); }
+    return fd;
+}
+
+int map_bin_open(MapBin* b, const char* path, bool verify, char** err) {
+    if (err) *err = NULL;
+    memset(b, 0, sizeof(*b));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return util_error(err, "cannot open '%s': %s", path, strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0) { int e = errno; close(fd); return util_error(err, "cannot stat '%s': %s", path, strerror(e)); }
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(MapBinHeader)) { close(fd); return util_error(err, "'%s': too small for a compiled level", path); }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    int e = errno;
+    close(fd);
+    if (base == MAP_FAILED) return util_error(err, "cannot map '%s': %s", path, strerror(e));
+    const unsigned char* bytes = (const unsigned char*)base;
+
+    const MapBinHeader* hd = (const MapBinHeader*)base;
+    const char* why = table_problem(hd, size);
+    if (why) { munmap(base, size); return util_error(err, "'%s': %s", path, why); }
+
+    const MapBinSection* table = (const MapBinSection*)(bytes + sizeof(MapBinHeader));
+    why = header_problem(hd, table, size);
+    if (!why && verify && hd->payload_hash != map_bin_hash(bytes + data_offset(hd->section_count),
+                                                        size - data_offset(hd->section_count)))
+        why = "payload checksum mismatch";
+    if (why) { munmap(base, size); return util_error(err, "'%s': %s", path, why); }
+
+    size_t cells = map_layout_bytes((MapLayout)hd->layout, hd->w, hd->h);
+    b->map.w = hd->w;
+    b->map.h = hd->h;
+    b->map.layout = (MapLayout)hd->layout;
+    for (uint32_t i = 0; i < hd->section_count && !why; ++i) {
+        const MapBinSection* sc = &table[i];
+        uint64_t tail = is_byte_section(sc->kind) ? MAP_PAD : 0;
+        if (sc->offset % MAP_BIN_ALIGN || sc->offset < data_offset(hd->section_count)
+            || sc->offset > size || sc->bytes > size - sc->offset || tail > size - sc->offset - sc->bytes) {
+            why = "section out of bounds";
+            break;
+        }
+        unsigned char* at = (unsigned char*)base + sc->offset;
+        if (is_byte_section(sc->kind) && sc->bytes != cells) { why = "section size mismatch"; break; }
+        if (sc->kind == MAP_BIN_TILES) {
+            b->map.data = at;
+        } else if (sc->kind == MAP_BIN_DIST) {
+            b->dist.w = hd->w; b->dist.h = hd->h;
+            b->dist.layout = (MapLayout)hd->layout;
+            b->dist.d = at;
+            b->dist.max = (int)hd->dist_max;
+            b->dist.external = true;
+        } else if (sc->kind == MAP_BIN_OCC) {
+            // occupancy from a build with other level counts is dropped
+            if (hd->occ_levels == MAP_OCC_LEVELS
+                && map_occ_view(&b->occ, hd->w, hd->h, (uint64_t*)at, (size_t)sc->bytes) != 0)
+                why = "occupancy size mismatch";
+        } else if (sc->kind >= MAP_BIN_PLANE0 && sc->kind < MAP_BIN_PLANE0 + MAP_PLANE_COUNT) {
+            b->map.plane[sc->kind - MAP_BIN_PLANE0] = at;
+        }
+    }
+    if (!why && !b->map.data) why = "no tile section";
+    if (why) { munmap(base, size); memset(b, 0, sizeof(*b)); return util_error(err, "'%s': %s", path, why); }
+
+    b->map.dist = b->dist.d;
+    b->map.occ = b->occ.level[0] ? &b->occ : NULL;
+    b->base = base;
+    b->bytes = size;
+    return 0;
+}
+
+void map_bin_close(MapBin* b) {
+    if (b->base) munmap(b->base, b->bytes);
+    memset(b, 0, sizeof(*b));
+}
+
+typedef struct Part {
+    uint32_t    kind;
+    const void* src[MAP_OCC_LEVELS];   // pieces written back to back
+    size_t      len[MAP_OCC_LEVELS];
+} Part;
+
+int map_bin_write(const char* path, const GridMap* m, const MapDist* dist, const MapOcc* occ, char** err) {
+    if (err) *err = NULL;
+    if (!m->data || m->w <= 0 || m->h <= 0) return util_error(err, "empty map");
+    size_t cells = map_layout_bytes(m->layout, m->w, m->h);
+
+    Part parts[MAP_BIN_MAX_SECTIONS];
+    uint32_t n = 0;
+    memset(parts, 0, sizeof(parts));
+    parts[n].kind = MAP_BIN_TILES; parts[n].src[0] = m->data; parts[n++].len[0] = cells;
+    for (int p = 0; p < MAP_PLANE_COUNT; ++p)
+        if (m->plane[p]) { parts[n].kind = MAP_BIN_PLANE0 + p; parts[n].src[0] = m->plane[p]; parts[n++].len[0] = cells; }
+    bool has_dist = dist && dist->d && dist->w == m->w && dist->h == m->h && dist->layout == m->layout;
+    if (has_dist) { parts[n].kind = MAP_BIN_DIST; parts[n].src[0] = dist->d; parts[n++].len[0] = cells; }
+    if (occ && occ->level[0] && occ->w == m->w && occ->h == m->h) {
+        parts[n].kind = MAP_BIN_OCC;
+        for (int k = 0; k < MAP_OCC_LEVELS; ++k) {
+            parts[n].src[k] = occ->level[k];
+            parts[n].len[k] = (size_t)occ->words_w[k] * (size_t)occ->words_h[k] * sizeof(uint64_t);
+        }
+        n++;
+    }
+
+    MapBinSection table[MAP_BIN_MAX_SECTIONS];
+    memset(table, 0, sizeof(table));
+    uint64_t off = data_offset(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        table[i].kind = parts[i].kind;
+        table[i].offset = off;
+        for (int k = 0; k < MAP_OCC_LEVELS; ++k) table[i].bytes += parts[i].len[k];
+        off = align_up(off + table[i].bytes + (is_byte_section(parts[i].kind) ? MAP_PAD : 0));
+    }
+
+    unsigned char* img = (unsigned char*)calloc(1, (size_t)off);
+    if (!img) return util_error(err, "out of memory");
+    for (uint32_t i = 0; i < n; ++i) {
+        unsigned char* at = img + table[i].offset;
+        for (int k = 0; k < MAP_OCC_LEVELS; ++k)
+            if (parts[i].len[k]) { memcpy(at, parts[i].src[k], parts[i].len[k]); at += parts[i].len[k]; }
+    }
+    MapBinHeader hd;
+    memset(&hd, 0, sizeof(hd));
+    memcpy(hd.magic, MAP_BIN_MAGIC, 8);
+    hd.version = MAP_BIN_VERSION;
+    hd.section_count = n;
+    hd.w = m->w; hd.h = m->h;
+    hd.tile_bytes = 1;
+    hd.layout = (uint8_t)m->layout;
+    hd.chunk_log2 = m->layout == MAP_LAYOUT_CHUNKED ? MAP_CHUNK_LOG2 : 0;
+    hd.occ_levels = MAP_OCC_LEVELS;
+    hd.dist_max = has_dist ? (uint32_t)dist->max : 0;
+    hd.file_bytes = off;
+    hd.payload_hash = map_bin_hash(img + data_offset(n), (size_t)(off - data_offset(n)));
+    hd.header_hash = header_hash(&hd, table);
+    memcpy(img, &hd, sizeof(hd));
+    memcpy(img + sizeof(hd), table, n * sizeof(MapBinSection));
+
+    // write next to the target and rename, so readers never see half a file
+    size_t tl = strlen(path) + 5;
+    char* tmp = (char*)malloc(tl);
+    if (!tmp) { free(img); return util_error(err, "out of memory"); }
+    snprintf(tmp, tl, "%s.tmp", path);
+    FILE* f = fopen(tmp, "wb");
+    if (!f) { int e = errno; free(img); free(tmp); return util_error(err, "cannot create '%s': %s", path, strerror(e)); }
+    bool ok = fwrite(img, 1, (size_t)off, f) == (size_t)off;
+    ok = (fclose(f) == 0) && ok;
+    free(img);
+    if (!ok || rename(tmp, path) != 0) {
+        int e = errno;
+        remove(tmp);
+        free(tmp);
+        return util_error(err, "cannot write '%s': %s", path, strerror(e));
+    }
+    free(tmp);
+    return 0;
+}
+
+char* map_bin_path_for(const char* src) {
+    size_t n = strlen(src), le = strlen(MAP_BIN_EXT);
+    if (n >= le && strcasecmp(src + n - le, MAP_BIN_EXT) == 0) return strdup(src);
+    // "x.cub3d" gains a 'b', anything else the whole extension
+    bool source = n >= le - 1 && strcasecmp(src + n - (le - 1), ".cub3d") == 0;
+    size_t extra = source ? 1 : le;
+    char* out = (char*)malloc(n + extra + 1);
+    if (!out) return NULL;
+    memcpy(out, src, n);
+    memcpy(out + n, source ? "b" : MAP_BIN_EXT, extra + 1);
+    return out;
+}
+
+bool map_bin_is_fresh(const char* bin, const char* src) {
+    struct stat sb, ss;
+    if (stat(bin, &sb) != 0) return false;
+    if (stat(src, &ss) != 0) return true;
+    return ST_MTIME_NS(sb) >= ST_MTIME_NS(ss);
+}
@@ -0,0 +1,135 @@
+#include "map_dist.h"
+#include <stdlib.h>
+
+#define DIST_CAP 255
+
+static inline size_t cell(const MapDist* f, int x, int y) {
+    return map_index_in(f->layout, f->w, x, y);
+}
+
+// Distance to the ring of out-of-map walls: an upper bound for empty cells.
+static inline int border_dist(int w, int h, int x, int y) {
+    int v = x + 1;
+    if (y + 1 < v) v = y + 1;
+    if (w - x < v) v = w - x;
+    if (h - y < v) v = h - y;
+    return v < DIST_CAP ? v : DIST_CAP;
+}
+
+// *v = min(*v, d(nx, ny) + 1) for an in-map neighbour.
+static inline void relax_cell(const MapDist* f, int* v, int nx, int ny) {
+    if ((unsigned)nx >= (unsigned)f->w || (unsigned)ny >= (unsigned)f->h) return;
+    int c = f->d[cell(f, nx, ny)] + 1;
+    if (c < *v) *v = c;
+}
+
+// Two-pass chamfer (forward: W, NW, N, NE; backward: E, SE, S, SW) over the
+// cells [x0, x1) x [y0, y1); neighbours outside the window are read as they
+// are. Exact for the whole map in one call. Returns true if a cell changed.
+static bool relax(MapDist* f, int x0, int y0, int x1, int y1) {
+    uint8_t* d = f->d;
+    bool changed = false;
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            size_t i = cell(f, x, y);
+            int v = d[i];
+            if (v <= 1) continue;
+            relax_cell(f, &v, x - 1, y);
+            relax_cell(f, &v, x - 1, y - 1);
+            relax_cell(f, &v, x, y - 1);
+            relax_cell(f, &v, x + 1, y - 1);
+            if (v != d[i]) { d[i] = (uint8_t)v; changed = true; }
+        }
+    }
+    for (int y = y1 - 1; y >= y0; --y) {
+        for (int x = x1 - 1; x >= x0; --x) {
+            size_t i = cell(f, x, y);
+            int v = d[i];
+            if (v <= 1) continue;
+            relax_cell(f, &v, x + 1, y);
+            relax_cell(f, &v, x + 1, y + 1);
+            relax_cell(f, &v, x, y + 1);
+            relax_cell(f, &v, x - 1, y + 1);
+            if (v != d[i]) { d[i] = (uint8_t)v; changed = true; }
+        }
+    }
+    return changed;
+}
+
+static int window_max(const MapDist* f, int x0, int y0, int x1, int y1) {
+    int v = 0;
+    for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+            if (f->d[cell(f, x, y)] > v) v = f->d[cell(f, x, y)];
+    return v;
+}
+
+int map_dist_build(MapDist* f, const GridMap* m) {
+    f->w = f->h = f->max = 0;
+    f->external = false;
+    f->layout = m->layout;
+    f->d = NULL;
+    if (m->w <= 0 || m->h <= 0) return -1;
+    size_t n = map_layout_bytes(m->layout, m->w, m->h);
+    uint8_t* d = (uint8_t*)calloc(n + MAP_PAD, 1);
+    if (!d) return -1;
+
+    for (int y = 0; y < m->h; ++y)
+        for (int x = 0; x < m->w; ++x) {
+            size_t i = map_index(m, x, y);
+            d[i] = m->data[i] > 0 ? 0 : (uint8_t)border_dist(m->w, m->h, x, y);
+        }
+    f->w = m->w; f->h = m->h; f->d = d;
+    relax(f, 0, 0, m->w, m->h);
+    f->max = window_max(f, 0, 0, m->w, m->h);
+    return 0;
+}
+
+void map_dist_free(MapDist* f) {
+    if (!f->external) free(f->d);
+    f->d = NULL;
+    f->w = f->h = f->max = 0;
+    f->external = false;
+}
+
+bool map_dist_update(MapDist* f, const GridMap* m, int x, int y) {
+    if (!f->d || m->w != f->w || m->h != f->h || m->layout != f->layout) return false;
+    if ((unsigned)x >= (unsigned)f->w || (unsigned)y >= (unsigned)f->h) return false;
+    size_t i = cell(f, x, y);
+    bool wall = m->data[i] > 0;
+    if (wall == (f->d[i] == 0)) return false;
+
+    // only cells closer to (x, y) than the largest distance can change
+    int r = f->max;
+    int x0 = x - r < 0 ? 0 : x - r, x1 = x + r + 1 > f->w ? f->w : x + r + 1;
+    int y0 = y - r < 0 ? 0 : y - r, y1 = y + r + 1 > f->h ? f->h : y + r + 1;
+
+    if (wall) {
+        // distances only shrink: clamp each cell to its distance to the new wall
+        for (int cy = y0; cy < y1; ++cy)
+            for (int cx = x0; cx < x1; ++cx) {
+                int dx = abs(cx - x), dy = abs(cy - y);
+                int c = dx > dy ? dx : dy;
+                uint8_t* v = &f->d[cell(f, cx, cy)];
+                if (c < *v) *v = (uint8_t)c;
+            }
+        return true;
+    }
+
+    // A wall went away: cells whose distance was set by it (distance equal
+    // to their distance from it) go back to the border bound and are
+    // relaxed again from their unchanged neighbours. Passes repeat until
+    // stable, since the window is seeded from arbitrary exact cells rather
+    // than from walls.
+    for (int cy = y0; cy < y1; ++cy)
+        for (int cx = x0; cx < x1; ++cx) {
+            int dx = abs(cx - x), dy = abs(cy - y);
+            int c = dx > dy ? dx : dy;
+            uint8_t* v = &f->d[cell(f, cx, cy)];
+            if (*v == c) *v = (uint8_t)border_dist(f->w, f->h, cx, cy);
+        }
+    while (relax(f, x0, y0, x1, y1)) {}
+    int wmax = window_max(f, x0, y0, x1, y1);
+    if (wmax > f->max) f->max = wmax;
+    return true;
+}
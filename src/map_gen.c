@@ -0,0 +1,149 @@
+#include "map_gen.h"
+#include "util.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const KIND_NAMES[MAP_GEN_KIND_COUNT] = { "open", "pillars", "maze", "corridors" };
+static const int DEFAULT_DENSITY[MAP_GEN_KIND_COUNT] = { 164, 128, 0, 64 };
+
+int map_gen_kind(const char* name) {
+    for (int k = 0; k < MAP_GEN_KIND_COUNT; ++k)
+        if (strcmp(name, KIND_NAMES[k]) == 0) return k;
+    return -1;
+}
+
+const char* map_gen_kind_name(MapGenKind kind) {
+    return (unsigned)kind < MAP_GEN_KIND_COUNT ? KIND_NAMES[kind] : "?";
+}
+
+int map_gen_default_density(MapGenKind kind) {
+    return (unsigned)kind < MAP_GEN_KIND_COUNT ? DEFAULT_DENSITY[kind] : 0;
+}
+
+// The generator's LCG (the one the benchmarks have always used).
+static uint32_t rnd(uint32_t* s) {
+    *s = *s * 1664525u + 1013904223u;
+    return *s;
+}
+
+// 'r' hits 'density' of every 65536 draws.
+static int chance(uint32_t r, int density) {
+    return (int)((r >> 8) % 65536) < density;
+}
+
+static uint8_t wall_id(uint32_t r, int ids) {
+    return (uint8_t)(1 + (r >> 20) % (uint32_t)ids);
+}
+
+static void border(uint8_t* t, int w, int h) {
+    for (int x = 0; x < w; ++x) t[x] = t[(size_t)(h - 1) * w + x] = 1;
+    for (int y = 0; y < h; ++y) t[(size_t)y * w] = t[(size_t)y * w + w - 1] = 1;
+}
+
+static void gen_open(uint8_t* t, int w, int h, uint32_t s, int density, int ids) {
+    border(t, w, h);
+    for (int y = 1; y < h - 1; ++y)
+        for (int x = 1; x < w - 1; ++x) {
+            uint32_t r = rnd(&s);
+            if (chance(r, density)) t[(size_t)y * w + x] = wall_id(r, ids);
+        }
+}
+
+static void gen_pillars(uint8_t* t, int w, int h, uint32_t s, int density, int ids) {
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) {
+            if (x == 0 || y == 0 || x == w - 1 || y == h - 1) { t[(size_t)y * w + x] = 1; continue; }
+            uint32_t r = rnd(&s);
+            if (!chance(r, density) || x >= w - 2 || y >= h - 2) continue;
+            uint8_t id = wall_id(r, ids);
+            for (int k = 0; k < 4; ++k) t[(size_t)(y + k / 2) * w + x + k % 2] = id;
+        }
+}
+
+// Sidewinder on the odd cells: each row carves runs eastwards and closes
+// every run with one passage north (the first row is a single run).
+static void gen_maze(uint8_t* t, int w, int h, uint32_t s, int density, int ids) {
+    for (size_t i = 0; i < (size_t)w * (size_t)h; ++i) t[i] = wall_id(rnd(&s), ids);
+    border(t, w, h);
+    for (int y = 1; y < h - 1; y += 2) {
+        int run = 1;
+        for (int x = 1; x < w - 1; x += 2) {
+            t[(size_t)y * w + x] = 0;
+            int east = x + 2 < w - 1;
+            int close = y == 1 ? !east : (!east || (rnd(&s) >> 16) & 1);
+            if (!close) {
+                t[(size_t)y * w + x + 1] = 0;
+            } else if (y > 1) {
+                int cx = run + 2 * (int)((rnd(&s) >> 8) % (uint32_t)((x - run) / 2 + 1));
+                t[(size_t)(y - 1) * w + cx] = 0;
+                run = x + 2;
+            }
+        }
+    }
+    if (density <= 0) return;
+    // walls between two cells (one coordinate odd, the other even)
+    for (int y = 1; y < h - 1; ++y)
+        for (int x = 1 + (y & 1); x < w - 1; x += 2) {
+            int cells = (y & 1) ? x + 1 < w - 1 : y + 1 < h - 1;
+            if (cells && chance(rnd(&s), density)) t[(size_t)y * w + x] = 0;
+        }
+}
+
+static void gen_corridors(uint8_t* t, int w, int h, uint32_t s, int density, int ids) {
+    border(t, w, h);
+    for (int y = 1 + 1 + (int)((rnd(&s) >> 16) % 3); y < h - 1; y += 2 + (int)((rnd(&s) >> 16) % 3)) {
+        uint8_t* row = t + (size_t)y * w;
+        for (int x = 1; x < w - 1; ++x) {
+            uint32_t r = rnd(&s);
+            row[x] = chance(r, density) ? 0 : wall_id(r, ids);
+        }
+        row[1 + (rnd(&s) >> 8) % (uint32_t)(w - 2)] = 0;   // at least one way through
+    }
+}
+
+uint8_t* map_gen(const MapGenConfig* cfg) {
+    int w = cfg->w, h = cfg->h;
+    if (w < 3 || h < 3 || (unsigned)cfg->kind >= MAP_GEN_KIND_COUNT) return NULL;
+    uint8_t* t = (uint8_t*)calloc((size_t)w * (size_t)h + MAP_PAD, 1);
+    if (!t) return NULL;
+    int density = cfg->density >= 0 ? cfg->density : DEFAULT_DENSITY[cfg->kind];
+    int ids = cfg->tile_ids <= 0 ? 4 : cfg->tile_ids > 255 ? 255 : cfg->tile_ids;
+    switch (cfg->kind) {
+    case MAP_GEN_OPEN:      gen_open(t, w, h, cfg->seed, density, ids); break;
+    case MAP_GEN_PILLARS:   gen_pillars(t, w, h, cfg->seed, density, ids); break;
+    case MAP_GEN_MAZE:      gen_maze(t, w, h, cfg->seed, density, ids); break;
+    case MAP_GEN_CORRIDORS: gen_corridors(t, w, h, cfg->seed, density, ids); break;
+    default: break;
+    }
+    // keep the spawn (center) clear
+    for (int y = h / 2 - 1; y <= h / 2 + 1; ++y)
+        for (int x = w / 2 - 1; x <= w / 2 + 1; ++x)
+            if (x > 0 && y > 0 && x < w - 1 && y < h - 1) t[(size_t)y * w + x] = 0;
+    return t;
+}
+
+int map_gen_write_cub3d(const char* path, const uint8_t* tiles, int w, int h, char** err) {
+    if (err) *err = NULL;
+    FILE* f = fopen(path, "w");
+    if (!f) return util_error(err, "cannot create '%s': %s", path, strerror(errno));
+    char* line = (char*)malloc((size_t)w * 4 + 1);   // "255," per tile
+    if (!line) { fclose(f); return util_error(err, "out of memory"); }
+    int ok = 1;
+    for (int y = 0; ok && y < h; ++y) {
+        char* p = line;
+        const uint8_t* row = tiles + (size_t)y * w;
+        for (int x = 0; x < w; ++x) {
+            unsigned v = row[x];
+            if (v >= 100) *p++ = (char)('0' + v / 100);
+            if (v >= 10) *p++ = (char)('0' + v / 10 % 10);
+            *p++ = (char)('0' + v % 10);
+            *p++ = x + 1 < w ? ',' : '\n';
+        }
+        ok = fwrite(line, 1, (size_t)(p - line), f) == (size_t)(p - line);
+    }
+    free(line);
+    ok = (fclose(f) == 0) && ok;
+    return ok ? 0 : util_error(err, "cannot write '%s': %s", path, strerror(errno));
+}
@@ -0,0 +1,90 @@
+#include "map_occ.h"
+#include <stdlib.h>
+#include <string.h>
+
+static inline void set_bit(MapOcc* o, int level, int ux, int uy, bool on) {
+    uint64_t* wd = &o->level[level][map_occ_word(o, level, ux, uy)];
+    uint64_t bit = 1ull << map_occ_shift(ux, uy);
+    *wd = on ? (*wd | bit) : (*wd & ~bit);
+}
+
+// Units of 'level' are the words of the level below (cells on level 0).
+static inline int units_w(const MapOcc* o, int level) { return level ? o->words_w[level - 1] : o->w; }
+static inline int units_h(const MapOcc* o, int level) { return level ? o->words_h[level - 1] : o->h; }
+
+// Bit of unit (ux, uy) on 'level' (> 0): any bit of the word below; units
+// past the edge stay set.
+static bool unit_occupied(const MapOcc* o, int level, int ux, int uy) {
+    if (ux >= units_w(o, level) || uy >= units_h(o, level)) return true;
+    return o->level[level - 1][(size_t)uy * o->words_w[level - 1] + ux] != 0;
+}
+
+static void set_shape(MapOcc* o, int w, int h) {
+    memset(o, 0, sizeof(*o));
+    o->w = w; o->h = h;
+    for (int k = 0; k < MAP_OCC_LEVELS; ++k) {
+        o->words_w[k] = (units_w(o, k) + 7) / 8;
+        o->words_h[k] = (units_h(o, k) + 7) / 8;
+    }
+}
+
+static inline size_t level_words(const MapOcc* o, int k) {
+    return (size_t)o->words_w[k] * (size_t)o->words_h[k];
+}
+
+int map_occ_build(MapOcc* o, const GridMap* m) {
+    memset(o, 0, sizeof(*o));
+    if (m->w <= 0 || m->h <= 0) return -1;
+    set_shape(o, m->w, m->h);
+    for (int k = 0; k < MAP_OCC_LEVELS; ++k) {
+        o->level[k] = (uint64_t*)calloc(level_words(o, k), sizeof(uint64_t));
+        if (!o->level[k]) { map_occ_free(o); return -1; }
+    }
+
+    for (int y = 0; y < o->words_h[0] * 8; ++y)
+        for (int x = 0; x < o->words_w[0] * 8; ++x)
+            if (x >= m->w || y >= m->h || m->data[map_index(m, x, y)] > 0) set_bit(o, 0, x, y, true);
+    for (int k = 1; k < MAP_OCC_LEVELS; ++k)
+        for (int uy = 0; uy < o->words_h[k] * 8; ++uy)
+            for (int ux = 0; ux < o->words_w[k] * 8; ++ux)
+                if (unit_occupied(o, k, ux, uy)) set_bit(o, k, ux, uy, true);
+    return 0;
+}
+
+void map_occ_free(MapOcc* o) {
+    if (!o->external)
+        for (int k = 0; k < MAP_OCC_LEVELS; ++k) free(o->level[k]);
+    memset(o, 0, sizeof(*o));
+}
+
+int map_occ_view(MapOcc* o, int w, int h, uint64_t* words, size_t bytes) {
+    memset(o, 0, sizeof(*o));
+    if (w <= 0 || h <= 0 || !words) return -1;
+    set_shape(o, w, h);
+    size_t n = 0;
+    for (int k = 0; k < MAP_OCC_LEVELS; ++k) n += level_words(o, k);
+    if (bytes != n * sizeof(uint64_t)) { memset(o, 0, sizeof(*o)); return -1; }
+    for (int k = 0; k < MAP_OCC_LEVELS; ++k) {
+        o->level[k] = words;
+        words += level_words(o, k);
+    }
+    o->external = true;
+    return 0;
+}
+
+void map_occ_update(MapOcc* o, const GridMap* m, int x, int y) {
+    if (!o->level[0] || m->w != o->w || m->h != o->h) return;
+    if ((unsigned)x >= (unsigned)o->w || (unsigned)y >= (unsigned)o->h) return;
+    set_bit(o, 0, x, y, m->data[map_index(m, x, y)] > 0);
+    for (int k = 1; k < MAP_OCC_LEVELS; ++k) {
+        int ux = x >> (3 * k), uy = y >> (3 * k);
+        set_bit(o, k, ux, uy, unit_occupied(o, k, ux, uy));
+    }
+}
+
+size_t map_occ_bytes(const MapOcc* o) {
+    size_t n = 0;
+    for (int k = 0; k < MAP_OCC_LEVELS; ++k)
+        if (o->level[k]) n += level_words(o, k) * sizeof(uint64_t);
+    return n;
+}
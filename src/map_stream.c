@@ -0,0 +1,346 @@
+#include "map_stream.h"
+#include "map_bin.h"
+#include "map_occ.h"
+#include "util.h"
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Prefetches done inside map_stream_update() when not threaded.
+#ifndef MAP_STREAM_INLINE_PREFETCH
+#define MAP_STREAM_INLINE_PREFETCH 4
+#endif
+
+enum { BLOCK_ABSENT = 0, BLOCK_QUEUED, BLOCK_LOADING, BLOCK_RESIDENT };
+
+struct MapStream {
+    MapStreamConfig cfg;
+    GridMap   map;
+    MapOcc    occ;            // resident, over occ_words
+    uint64_t* occ_words;
+    int       fd;
+    uint64_t  tiles_offset;   // of the tile section in the file
+    uint8_t*  base;           // reserved range for the tiles (plus MAP_PAD)
+    size_t    tiles_bytes, reserved;
+    size_t    block_bytes;
+    int       chunks_per_block, chunks_w, chunks_h;
+    int32_t   blocks;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t  work_cv;  // prefetch queued, or quit
+    pthread_cond_t  loaded_cv; // a block finished loading
+    pthread_t thread;
+    bool      started, quit;
+
+    // guarded by mtx
+    uint8_t*  state;          // per block
+    uint8_t*  ahead;          // loaded by prefetch, not needed near the camera since
+    uint32_t* stamp;          // last update that touched the block
+    int32_t*  prev;           // LRU of resident blocks, head = most recent
+    int32_t*  next;
+    int32_t   head, tail;
+    uint32_t  frame;
+    int32_t*  queue;          // prefetch order (nearest first)
+    size_t    queue_count, queue_next, queue_cap;
+    uint64_t  generation;     // blocks loaded or evicted so far
+    MapStreamStats stats;
+};
+
+// ---------------- LRU ----------------
+static void lru_unlink(MapStream* s, int32_t b) {
+    if (s->prev[b] >= 0) s->next[s->prev[b]] = s->next[b]; else s->head = s->next[b];
+    if (s->next[b] >= 0) s->prev[s->next[b]] = s->prev[b]; else s->tail = s->prev[b];
+    s->prev[b] = s->next[b] = -1;
+}
+
+static void lru_push(MapStream* s, int32_t b) {
+    s->prev[b] = -1;
+    s->next[b] = s->head;
+    if (s->head >= 0) s->prev[s->head] = b; else s->tail = b;
+    s->head = b;
+}
+
+static void lru_touch(MapStream* s, int32_t b) {
+    if (s->head == b) return;
+    lru_unlink(s, b);
+    lru_push(s, b);
+}
+
+static size_t block_len(const MapStream* s, int32_t b) {
+    size_t off = (size_t)b * s->block_bytes;
+    return s->tiles_bytes - off < s->block_bytes ? s->tiles_bytes - off : s->block_bytes;
+}
+
+// Read block 'b' into place. Called without mtx; the block is LOADING.
+static void read_block(MapStream* s, int32_t b) {
+    size_t off = (size_t)b * s->block_bytes, len = block_len(s, b), got = 0;
+    while (got < len) {
+        ssize_t r = pread(s->fd, s->base + off + got, len - got, (off_t)(s->tiles_offset + off + got));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;   // stays zero: placeholder tiles
+        got += (size_t)r;
+    }
+}
+
+// Drop least recently used blocks, except the ones this update needs, until
+// 'room' more bytes fit the budget. Only map_stream_update() evicts: render
+// workers may read any block while a frame is drawn. Called with mtx held.
+static void evict(MapStream* s, size_t room) {
+    while (s->stats.resident_bytes + room > s->cfg.cache_bytes && s->tail >= 0 && s->stamp[s->tail] != s->frame) {
+        int32_t b = s->tail;
+        lru_unlink(s, b);
+        madvise(s->base + (size_t)b * s->block_bytes, block_len(s, b), MADV_DONTNEED);
+        s->state[b] = BLOCK_ABSENT;
+        s->ahead[b] = 0;
+        s->stats.resident_bytes -= block_len(s, b);
+        s->stats.evictions++;
+        s->generation++;
+    }
+}
+
+// Block 'b' was read. Called with mtx held.
+static void loaded(MapStream* s, int32_t b, bool ahead) {
+    s->state[b] = BLOCK_RESIDENT;
+    s->ahead[b] = ahead;
+    if (ahead) s->stats.prefetched++;
+    s->stats.resident_bytes += block_len(s, b);
+    if (s->stats.resident_bytes > s->stats.peak_resident_bytes) s->stats.peak_resident_bytes = s->stats.resident_bytes;
+    lru_push(s, b);
+    s->generation++;
+    pthread_cond_broadcast(&s->loaded_cv);
+}
+
+// Pop and load queued prefetches; at most 'max' (< 0: until the queue is
+// empty or quit). Called with mtx held; released around the reads.
+static void prefetch(MapStream* s, int max) {
+    while (max != 0 && !s->quit && s->queue_next < s->queue_count) {
+        int32_t b = s->queue[s->queue_next];
+        if (s->state[b] != BLOCK_QUEUED) { s->queue_next++; continue; }   // needed near the camera meanwhile
+        // no eviction mid-frame: what does not fit waits for the next update
+        if (s->stats.resident_bytes + block_len(s, b) > s->cfg.cache_bytes) break;
+        s->queue_next++;
+        s->state[b] = BLOCK_LOADING;
+        pthread_mutex_unlock(&s->mtx);
+        read_block(s, b);
+        pthread_mutex_lock(&s->mtx);
+        loaded(s, b, true);
+        if (max > 0) --max;
+    }
+}
+
+static void* prefetch_main(void* param) {
+    MapStream* s = (MapStream*)param;
+    pthread_mutex_lock(&s->mtx);
+    for (;;) {
+        while (!s->quit && s->queue_next == s->queue_count)
+            pthread_cond_wait(&s->work_cv, &s->mtx);
+        if (s->quit) break;
+        prefetch(s, -1);
+    }
+    pthread_mutex_unlock(&s->mtx);
+    return NULL;
+}
+
+// ---------------- Open / close ----------------
+MapStream* map_stream_open(const char* path, const MapStreamConfig* cfg, char** err) {
+    static const MapStreamConfig defaults = { MAP_STREAM_CACHE_BYTES, 16384, 64, 512, true };
+    if (err) *err = NULL;
+    MapBinHeader hd;
+    MapBinSection table[MAP_BIN_MAX_SECTIONS];
+    int fd = map_bin_read_table(path, &hd, table, err);
+    if (fd < 0) return NULL;
+    const MapBinSection* tiles = NULL;
+    const MapBinSection* occ = NULL;
+    for (uint32_t i = 0; i < hd.section_count; ++i) {
+        if (table[i].kind == MAP_BIN_TILES) tiles = &table[i];
+        if (table[i].kind == MAP_BIN_OCC && hd.occ_levels == MAP_OCC_LEVELS) occ = &table[i];
+    }
+    const char* why = !tiles ? "no tile section"
+                    : hd.layout != MAP_LAYOUT_CHUNKED ? "not chunked (cub3dc --layout chunked)"
+                    : !occ ? "no occupancy levels (cub3dc --occ on)" : NULL;
+    if (why) { close(fd); util_error(err, "'%s': cannot stream: %s", path, why); return NULL; }
+
+    MapStream* s = (MapStream*)calloc(1, sizeof(*s));
+    if (!s) { close(fd); util_error(err, "out of memory"); return NULL; }
+    s->cfg = cfg ? *cfg : defaults;
+    s->fd = fd;
+    pthread_mutex_init(&s->mtx, NULL);
+    pthread_cond_init(&s->work_cv, NULL);
+    pthread_cond_init(&s->loaded_cv, NULL);
+    s->tiles_offset = tiles->offset;
+    s->tiles_bytes = (size_t)tiles->bytes;
+    s->chunks_w = (hd.w + MAP_CHUNK - 1) >> MAP_CHUNK_LOG2;
+    s->chunks_h = (hd.h + MAP_CHUNK - 1) >> MAP_CHUNK_LOG2;
+
+    // whole pages of whole map chunks
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), chunk = (size_t)1 << (2 * MAP_CHUNK_LOG2);
+    size_t unit = page > chunk ? page : chunk;
+    s->block_bytes = (s->cfg.block_bytes + unit - 1) / unit * unit;
+    if (s->block_bytes == 0) s->block_bytes = unit;
+    s->chunks_per_block = (int)(s->block_bytes / chunk);
+    s->blocks = (int32_t)((s->tiles_bytes + s->block_bytes - 1) / s->block_bytes);
+    s->reserved = (s->tiles_bytes + MAP_PAD + page - 1) / page * page;
+
+    void* base = mmap(NULL, s->reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    s->base = base == MAP_FAILED ? NULL : (uint8_t*)base;
+    size_t nb = (size_t)s->blocks;
+    s->state = (uint8_t*)calloc(nb, 1);
+    s->ahead = (uint8_t*)calloc(nb, 1);
+    s->stamp = (uint32_t*)calloc(nb, sizeof(uint32_t));
+    s->prev = (int32_t*)malloc(nb * sizeof(int32_t));
+    s->next = (int32_t*)malloc(nb * sizeof(int32_t));
+    s->occ_words = (uint64_t*)malloc((size_t)occ->bytes);
+    if (!s->base || !s->state || !s->ahead || !s->stamp || !s->prev || !s->next || !s->occ_words) {
+        map_stream_close(s);
+        util_error(err, "'%s': out of memory", path);
+        return NULL;
+    }
+    for (size_t b = 0; b < nb; ++b) s->prev[b] = s->next[b] = -1;
+    s->head = s->tail = -1;
+    s->frame = 1;
+
+    // occupancy stays resident: the raycaster finds walls with it
+    if (pread(fd, s->occ_words, (size_t)occ->bytes, (off_t)occ->offset) != (ssize_t)occ->bytes
+        || map_occ_view(&s->occ, hd.w, hd.h, s->occ_words, (size_t)occ->bytes) != 0) {
+        map_stream_close(s);
+        util_error(err, "'%s': cannot read the occupancy levels", path);
+        return NULL;
+    }
+    s->map = (GridMap){ .w = hd.w, .h = hd.h, .layout = MAP_LAYOUT_CHUNKED, .data = s->base, .occ = &s->occ };
+
+    s->started = s->cfg.threaded && pthread_create(&s->thread, NULL, prefetch_main, s) == 0;
+    return s;
+}
+
+void map_stream_close(MapStream* s) {
+    if (!s) return;
+    pthread_mutex_lock(&s->mtx);
+    s->quit = true;
+    pthread_cond_signal(&s->work_cv);
+    pthread_mutex_unlock(&s->mtx);
+    if (s->started) pthread_join(s->thread, NULL);
+    pthread_cond_destroy(&s->loaded_cv);
+    pthread_cond_destroy(&s->work_cv);
+    pthread_mutex_destroy(&s->mtx);
+    if (s->base) munmap(s->base, s->reserved);
+    if (s->fd >= 0) close(s->fd);
+    free(s->state); free(s->ahead); free(s->stamp);
+    free(s->prev); free(s->next);
+    free(s->queue);
+    free(s->occ_words);
+    free(s);
+}
+
+GridMap map_stream_map(const MapStream* s) {
+    return s->map;
+}
+
+size_t map_stream_tile_bytes(const MapStream* s) {
+    return s->tiles_bytes;
+}
+
+// ---------------- Per frame ----------------
+static int32_t block_of_chunk(const MapStream* s, int cx, int cy) {
+    return (int32_t)(((int64_t)cy * s->chunks_w + cx) / s->chunks_per_block);
+}
+
+// Make block 'b' resident now. Called with mtx held.
+static void demand(MapStream* s, int32_t b) {
+    if (s->stamp[b] == s->frame) return;
+    s->stamp[b] = s->frame;
+    if (s->state[b] == BLOCK_RESIDENT) {
+        s->stats.hits++;
+    } else {
+        s->stats.misses++;
+        if (s->state[b] == BLOCK_LOADING) {
+            while (s->state[b] == BLOCK_LOADING) pthread_cond_wait(&s->loaded_cv, &s->mtx);
+        } else {
+            s->state[b] = BLOCK_LOADING;
+            pthread_mutex_unlock(&s->mtx);
+            read_block(s, b);
+            pthread_mutex_lock(&s->mtx);
+            loaded(s, b, false);
+        }
+    }
+    if (s->ahead[b]) { s->stats.prefetch_used++; s->ahead[b] = 0; }
+    lru_touch(s, b);
+}
+
+// Queue block 'b' for prefetch, or keep it if resident. Called with mtx held.
+static void want(MapStream* s, int32_t b) {
+    if (s->stamp[b] == s->frame) return;
+    s->stamp[b] = s->frame;
+    if (s->state[b] == BLOCK_RESIDENT) { lru_touch(s, b); return; }
+    if (s->state[b] != BLOCK_ABSENT) return;
+    if (s->queue_count == s->queue_cap) {
+        size_t cap = s->queue_cap ? s->queue_cap * 2 : 256;
+        int32_t* q = (int32_t*)realloc(s->queue, cap * sizeof(int32_t));
+        if (!q) return;
+        s->queue = q;
+        s->queue_cap = cap;
+    }
+    s->state[b] = BLOCK_QUEUED;
+    s->queue[s->queue_count++] = b;
+}
+
+uint64_t map_stream_update(MapStream* s, const Camera* cam) {
+    pthread_mutex_lock(&s->mtx);
+    s->frame++;
+    // the previous frustum is superseded
+    for (size_t i = s->queue_next; i < s->queue_count; ++i)
+        if (s->state[s->queue[i]] == BLOCK_QUEUED) s->state[s->queue[i]] = BLOCK_ABSENT;
+    s->queue_count = s->queue_next = 0;
+
+    // near the camera: before the frame
+    int r = s->cfg.near_cells;
+    int cx0 = ((int)cam->pos.x - r) >> MAP_CHUNK_LOG2, cx1 = ((int)cam->pos.x + r) >> MAP_CHUNK_LOG2;
+    int cy0 = ((int)cam->pos.y - r) >> MAP_CHUNK_LOG2, cy1 = ((int)cam->pos.y + r) >> MAP_CHUNK_LOG2;
+    if (cx0 < 0) cx0 = 0;
+    if (cy0 < 0) cy0 = 0;
+    if (cx1 >= s->chunks_w) cx1 = s->chunks_w - 1;
+    if (cy1 >= s->chunks_h) cy1 = s->chunks_h - 1;
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+            demand(s, block_of_chunk(s, cx, cy));
+
+    // along the view, nearest first: enough rays that neighbours stay
+    // within half a chunk of each other at the far end
+    float half = (float)(MAP_CHUNK / 2);
+    float spread = 2.0f * sqrtf(cam->plane.x * cam->plane.x + cam->plane.y * cam->plane.y);
+    int rays = (int)ceilf(spread * (float)s->cfg.prefetch_cells / half) + 1;
+    if (rays < 2) rays = 2;
+    if (rays > 512) rays = 512;
+    for (float t = (float)r; t <= (float)s->cfg.prefetch_cells; t += half) {
+        for (int i = 0; i < rays; ++i) {
+            float k = 2.0f * (float)i / (float)(rays - 1) - 1.0f;
+            float x = cam->pos.x + (cam->dir.x + cam->plane.x * k) * t;
+            float y = cam->pos.y + (cam->dir.y + cam->plane.y * k) * t;
+            if (x < 0.0f || y < 0.0f || x >= (float)s->map.w || y >= (float)s->map.h) continue;
+            want(s, block_of_chunk(s, (int)x >> MAP_CHUNK_LOG2, (int)y >> MAP_CHUNK_LOG2));
+        }
+    }
+
+    // between frames: back under budget, with room for the queue if the
+    // blocks this frame does not need allow
+    size_t room = 0;
+    for (size_t i = 0; i < s->queue_count; ++i) room += block_len(s, s->queue[i]);
+    evict(s, room);
+    if (s->started) pthread_cond_signal(&s->work_cv);
+    else prefetch(s, MAP_STREAM_INLINE_PREFETCH);
+    uint64_t gen = s->generation;
+    pthread_mutex_unlock(&s->mtx);
+    return gen;
+}
+
+MapStreamStats map_stream_stats(MapStream* s) {
+    pthread_mutex_lock(&s->mtx);
+    MapStreamStats st = s->stats;
+    pthread_mutex_unlock(&s->mtx);
+    st.prefetch_accuracy = st.prefetched ? (double)st.prefetch_used / (double)st.prefetched : 0.0;
+    return st;
+}
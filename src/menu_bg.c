@@ -51,8 +51,18 @@ static void grid_allocate(MenuBg* bg) {
 
     size_t n = (size_t)bg->grid_cols * (size_t)bg->grid_rows;
     free(bg->cell_phase);
+    free(bg->cell_look);
+    free(bg->cell_ripple);
     bg->cell_phase = (float*)malloc(n * sizeof(float));
-    if (!bg->cell_phase) return;
+    bg->cell_look = (struct CellLook*)calloc(n, sizeof(*bg->cell_look));
+    bg->cell_ripple = (uint8_t*)calloc(n, 1);
+    bg->repaint = true;
+    if (!bg->cell_phase || !bg->cell_look || !bg->cell_ripple) {
+        free(bg->cell_phase);  bg->cell_phase = NULL;
+        free(bg->cell_look);   bg->cell_look = NULL;
+        free(bg->cell_ripple); bg->cell_ripple = NULL;
+        return;
+    }
 
     unsigned tmp = bg->rng ^ 0x9E3779B9u;
     for (size_t i = 0; i < n; ++i) {
@@ -127,22 +137,46 @@ void menu_bg_update(MenuBg* bg, double now, float dt) {
     }
 }
 
-// Draw a cheap vertical band gradient as a base
-static void draw_band_gradient(MenuBg* bg, mlx_image_t* dst) {
+// Draw a cheap vertical band gradient as a base, inside [x0,x1) x [y0,y1)
+static void draw_band_gradient(MenuBg* bg, mlx_image_t* dst, int x0, int y0, int x1, int y1) {
     const int bands = 8;
     int bw = (bg->w + bands - 1) / bands;
     float base_h = fmodf((float)bg->t * 12.0f, 360.0f);
     for (int i = 0; i < bands; ++i) {
         float h = base_h + i * (360.0f / (float)bands);
         uint32_t col = hsv_to_rgba(h, 0.25f, 0.10f + 0.05f * (float)((i%2)==0));
-        int x = i * bw;
-        int w = imin(bw, bg->w - x);
-        if (w > 0) gui_fill_rect(dst, x, 0, w, bg->h, col);
+        int x = imax(i * bw, x0);
+        int w = imin((i + 1) * bw, imin(bg->w, x1)) - x;
+        if (w > 0 && y1 > y0) gui_fill_rect(dst, x, y0, w, y1 - y0, col);
+    }
+}
+
+// Flag the cells a ripple's rings (radius R-12..R) cross this frame; last
+// frame's flags move to bit 1.
+static void mark_ripple_cells(MenuBg* bg) {
+    const int cols = bg->grid_cols, rows = bg->grid_rows;
+    for (int i = 0; i < cols * rows; ++i) bg->cell_ripple[i] = (uint8_t)((bg->cell_ripple[i] & 1) << 1);
+    for (int i = 0; i < bg->ripples_cap; ++i) {
+        if (!bg->ripples[i].active) continue;
+        float cx = (float)(int)bg->ripples[i].x, cy = (float)(int)bg->ripples[i].y;
+        float R = (float)(int)bg->ripples[i].r + 1.0f, r = R - 14.0f;
+        int gx0 = imax(0, (int)((cx - R) / (float)bg->cell_w)), gx1 = imin(cols - 1, (int)((cx + R) / (float)bg->cell_w));
+        int gy0 = imax(0, (int)((cy - R) / (float)bg->cell_h)), gy1 = imin(rows - 1, (int)((cy + R) / (float)bg->cell_h));
+        for (int gy = gy0; gy <= gy1; ++gy)
+            for (int gx = gx0; gx <= gx1; ++gx) {
+                // nearest and farthest point of the cell from the center
+                float x0 = (float)(gx * bg->cell_w), x1 = x0 + (float)bg->cell_w;
+                float y0 = (float)(gy * bg->cell_h), y1 = y0 + (float)bg->cell_h;
+                float nx = fmaxf(x0 - cx, fmaxf(0.0f, cx - x1)), ny = fmaxf(y0 - cy, fmaxf(0.0f, cy - y1));
+                float fx = fmaxf(fabsf(cx - x0), fabsf(cx - x1)), fy = fmaxf(fabsf(cy - y0), fabsf(cy - y1));
+                if (nx * nx + ny * ny <= R * R && (r <= 0.0f || fx * fx + fy * fy >= r * r))
+                    bg->cell_ripple[gy * cols + gx] |= 1;
+            }
     }
 }
 
 // Flowing squares: pulsing outlines + subtle cell fill
-static void draw_flowing_squares(MenuBg* bg, mlx_image_t* dst) {
+static void draw_flowing_squares(MenuBg* bg, mlx_image_t* dst, CanvasDirty* dirty) {
     if (!bg->cell_phase) return;
 
     const float pulse_rate = 1.3f;
@@ -164,7 +198,6 @@ static void draw_flowing_squares(MenuBg* bg, mlx_image_t* dst) {
             // soft cell background
             float bgp = 0.5f + 0.5f * sinf((float)bg->t * 0.6f + (float)gx*0.3f + (float)gy*0.25f);
             uint32_t cell_col = hsv_to_rgba(base_h + 80.0f * bgp, 0.15f, 0.08f + 0.06f * bgp);
-            gui_fill_rect(dst, x, y, cw, ch, cell_col);
 
             // inner pulsing square (outline)
             float phase = bg->cell_phase[idx];
@@ -172,13 +205,20 @@ static void draw_flowing_squares(MenuBg* bg, mlx_image_t* dst) {
             int side = (int)((0.35f + 0.25f * p) * (float)imin(cw, ch));
             int off = (imin(cw, ch) - side) / 2;
             uint32_t outline = hsv_to_rgba(base_h + 180.0f * p, 0.65f, 0.9f);
-            gui_draw_square(dst, x + off + (int)slide % 2, y + off, side, outline);
 
             // tiny accent (1px vertical bar) for texture
             int ax = x + cw/2 + (int)fmodf(slide + gx*3.0f, (float)imax(2,cw/3)) - cw/6;
             int ah = imax(1, ch/6);
             uint32_t accent = hsv_to_rgba(base_h + 60.0f, 0.25f, 0.25f);
+
+            struct CellLook look = { cell_col, outline, accent, x + off + (int)slide % 2, side, ax };
+            if (!bg->repaint && !bg->cell_ripple[idx] && memcmp(&look, &bg->cell_look[idx], sizeof(look)) == 0)
+                continue;   // drawn exactly like this already
+            bg->cell_look[idx] = look;
+            gui_fill_rect(dst, x, y, cw, ch, cell_col);
+            gui_draw_square(dst, look.sq_x, y + off, side, outline);
             gui_fill_rect(dst, ax, y + (ch - ah)/2, 1, ah, accent);
+            canvas_dirty_add(dirty, x, y, cw, ch);
         }
     }
 }
@@ -200,20 +240,33 @@ static void draw_ripples(MenuBg* bg, mlx_image_t* dst) {
     }
 }
 
-void menu_bg_render(MenuBg* bg, mlx_image_t* dst) {
+void menu_bg_render(MenuBg* bg, mlx_image_t* dst, CanvasDirty* dirty) {
     if (!bg || !dst) return;
 
-    // Base gradient
-    draw_band_gradient(bg, dst);
+    // Base gradient: only the strips right of and below the cell grid show it
+    int gw = bg->cell_phase ? bg->grid_cols * bg->cell_w : 0;
+    int gh = bg->cell_phase ? bg->grid_rows * bg->cell_h : 0;
+    draw_band_gradient(bg, dst, gw, 0, bg->w, bg->h);
+    draw_band_gradient(bg, dst, 0, gh, gw, bg->h);
+    canvas_dirty_add(dirty, gw, 0, bg->w - gw, bg->h);
+    canvas_dirty_add(dirty, 0, gh, gw, bg->h - gh);
 
-    // Scene layers
-    draw_flowing_squares(bg, dst);
+    // Scene layers (the rings only cross redrawn cells and the strips)
+    if (bg->cell_phase && bg->ripples) mark_ripple_cells(bg);
+    draw_flowing_squares(bg, dst, dirty);
     draw_ripples(bg, dst);
+    bg->repaint = false;
+}
+
+void menu_bg_invalidate(MenuBg* bg) {
+    if (bg) bg->repaint = true;
 }
 
 void menu_bg_free(MenuBg* bg) {
     if (!bg) return;
     free(bg->cell_phase);  bg->cell_phase = NULL;
+    free(bg->cell_look);   bg->cell_look = NULL;
+    free(bg->cell_ripple); bg->cell_ripple = NULL;
     free(bg->ripples);     bg->ripples = NULL;
     bg->ripples_cap = 0;
 }
@@ -2,6 +2,8 @@
 #include "game_scene.h"
 #include "scene_manager.h"
 #include "app.h"
+#include "level_catalog.h"
+#include "level_thumbs.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,11 +12,23 @@
 #define LEVELS_DIR "assets/maps"
 #endif
 
+// Level thumbnails: longer side in pixels, render threads, and how many
+// finished ones are turned into images per frame (keeps frames short).
+#ifndef MENU_THUMB_SIZE
+#define MENU_THUMB_SIZE 128
+#endif
+#ifndef MENU_THUMB_THREADS
+#define MENU_THUMB_THREADS 2
+#endif
+#ifndef MENU_THUMBS_PER_FRAME
+#define MENU_THUMBS_PER_FRAME 2
+#endif
+
 typedef struct MapSelectUD {
     struct App* app;
     GameScene*  game;     // to queue map load (on select, change to map)
     size_t      index;
-    const char* path;     // points into MenuScene.map_files[i]
+    const char* path;     // points into MenuScene.catalog.levels[i]
 } MapSelectUD;
 
 static void on_select_map(void* ud) {
@@ -25,37 +39,88 @@ static void on_select_map(void* ud) {
     sm_request_change(&sel->app->sm, SCN_GAME);  // deferred switch
 }
 
-static void ms_build_items(MenuScene* ms, GameScene* gs) {
-    // discover files
-    if (map_list_levels(LEVELS_DIR, &ms->map_files, &ms->map_file_count) != 0) {
-        ms->map_files = NULL;
-        ms->map_file_count = 0;
+// Levels from the on-disk catalog, refreshed against LEVELS_DIR (only new
+// or changed files are read) and written back when anything changed.
+static void ms_load_catalog(MenuScene* ms) {
+    double t0 = mlx_get_time();
+    char* index = level_catalog_path_for(LEVELS_DIR);
+    char* err = NULL;
+    if (level_catalog_load(&ms->catalog, LEVELS_DIR, index) != 0) { free(index); return; }
+    int changes = level_catalog_refresh(&ms->catalog, &err);
+    if (changes < 0) {
+        fprintf(stderr, "Level list: %s\n", err ? err : "cannot refresh");
+        level_catalog_free(&ms->catalog);
+    } else if (changes > 0 && index && level_catalog_save(&ms->catalog, index, &err) != 0) {
+        fprintf(stderr, "Level catalog not saved: %s\n", err ? err : "write error");
     }
+    free(err);
+    free(index);
+    app_log(ms->base.app, "levels: %zu (%d change%s) in %.1f ms", ms->catalog.count, changes > 0 ? changes : 0,
+            changes == 1 ? "" : "s", (mlx_get_time() - t0) * 1000.0);
+}
+
+static LevelThumbJob thumb_job(const MenuScene* ms, size_t i) {
+    const LevelInfo* li = &ms->catalog.levels[i];
+    return (LevelThumbJob){ i, li->path, li->hash };
+}
 
-    size_t n = ms->map_file_count ? ms->map_file_count : 3;
+// Queue the shown page's thumbnails whenever the grid laid it out again,
+// and drop finished ones into their buttons, a few per frame.
+static void ms_update_thumbs(MenuScene* ms) {
+    if (!ms->thumbs) return;
+    if (ms->thumbs_serial != ms->grid.layout_serial) {
+        ms->thumbs_serial = ms->grid.layout_serial;
+        size_t first, n = gui_paged_grid_page_items(&ms->grid, &first);
+        LevelThumbJob* jobs = n ? (LevelThumbJob*)malloc(n * sizeof(LevelThumbJob)) : NULL;
+        for (size_t i = 0; jobs && i < n; ++i) jobs[i] = thumb_job(ms, first + i);
+        level_thumbs_request(ms->thumbs, jobs, jobs ? n : 0);
+        free(jobs);
+    }
+    LevelThumb th;
+    for (int k = 0; k < MENU_THUMBS_PER_FRAME && level_thumbs_take(ms->thumbs, &th); ++k) {
+        gui_paged_grid_set_thumbnail(&ms->gui, &ms->grid, th.item, th.px, th.w, th.h);
+        free(th.px);
+    }
+}
+
+// Thumbnail workers; every level not in the cache yet is rendered into it
+// in the background, after whatever page is shown.
+static void ms_start_thumbs(MenuScene* ms) {
+    if (ms->catalog.count == 0) return;
+    ms->thumbs = level_thumbs_create(LEVELS_DIR ".thumbs", MENU_THUMB_SIZE, MENU_THUMB_THREADS);
+    if (!ms->thumbs) return;
+    LevelThumbJob* jobs = (LevelThumbJob*)malloc(ms->catalog.count * sizeof(LevelThumbJob));
+    if (!jobs) return;
+    for (size_t i = 0; i < ms->catalog.count; ++i) jobs[i] = thumb_job(ms, i);
+    level_thumbs_warm(ms->thumbs, jobs, ms->catalog.count);
+    free(jobs);
+}
+
+static void ms_build_items(MenuScene* ms, GameScene* gs) {
+    ms_load_catalog(ms);
+
+    size_t count = ms->catalog.count;
+    size_t n = count ? count : 3;
     GuiPagedGridItem* items = (GuiPagedGridItem*)calloc(n, sizeof(GuiPagedGridItem));
     if (!items) return;
 
     MapSelectUD* uds = (MapSelectUD*)calloc(n, sizeof(MapSelectUD)); // owned by scene
     ms->ud = uds;
 
-    if (ms->map_file_count == 0) {
+    if (count == 0) {
         items[0] = (GuiPagedGridItem){ "Demo 1", on_select_map, NULL };
         items[1] = (GuiPagedGridItem){ "Demo 2", on_select_map, NULL };
         items[2] = (GuiPagedGridItem){ "Demo 3", on_select_map, NULL };
     } else {
-        for (size_t i = 0; i < ms->map_file_count; ++i) {
-            const char* path = ms->map_files[i];
+        for (size_t i = 0; i < count; ++i) {
+            const LevelInfo* li = &ms->catalog.levels[i];
+            const char* path = li->path;
             const char* base = strrchr(path, '/'); base = base ? base+1 : path;
             const char* dot  = strrchr(base, '.');
             char label[256];
-            if (dot && (size_t)(dot - base) < sizeof(label)) {
-                size_t L = (size_t)(dot - base);
-                memcpy(label, base, L); label[L] = '\0';
-            } else {
-                strncpy(label, base, sizeof(label)-1);
-                label[sizeof(label)-1] = '\0';
-            }
+            int L = dot ? (int)(dot - base) : (int)strlen(base);
+            if (li->w > 0) snprintf(label, sizeof(label), "%.*s  %dx%d", L, base, li->w, li->h);
+            else           snprintf(label, sizeof(label), "%.*s", L, base);
             // grid will strdup label internally
             items[i].label    = label;
             items[i].on_click = on_select_map;
@@ -76,9 +141,6 @@ static void ms_on_init(Scene* s, struct App* app) {
     MenuScene* ms = (MenuScene*)s;
     s->app = app;
 
-    // offscreen buffer sized to window
-    canvas_init(&ms->scene, app->mlx, app->mlx->width, app->mlx->height);
-
     // gui
     ms->gui = (GuiContext){ .mlx = app->mlx, .now = 0.0, .paths = NULL, .paths_len = 0 };
     gui_paths_add(&ms->gui, "assets");
@@ -98,7 +160,7 @@ static void ms_on_init(Scene* s, struct App* app) {
 
     GuiPagedGridConfig cfg = {
         .x=0,.y=0,.w=640,.h=420, .center_h=true,.center_v=true,
-        .cols=2,.rows=2,.gap=16,.pager_h=20,
+        .cols=2,.rows=2,.gap=16,.pager_h=20,.thumb_h=MENU_THUMB_SIZE + 8,
         .item_skin_tex=ms->ui_item_skin,.item_skin_cfg=item_n,
         .pager_skin_tex=ms->ui_pager_skin,.pager_skin_cfg=pager_n,
     };
@@ -109,6 +171,7 @@ static void ms_on_init(Scene* s, struct App* app) {
     // need the Game scene instance to queue loads
     GameScene* gs = (GameScene*)app->sm.scenes[SCN_GAME];
     ms_build_items(ms, gs);
+    ms_start_thumbs(ms);
 
     // hide all GUI by default; scene_show will enable
     gui_paged_grid_set_enabled(&ms->grid, false);
@@ -117,6 +180,7 @@ static void ms_on_init(Scene* s, struct App* app) {
 static void ms_on_show(Scene* s) {
     MenuScene* ms = (MenuScene*)s;
     gui_paged_grid_set_enabled(&ms->grid, true);
+    menu_bg_invalidate(&ms->bg);   // the game drew over the screen meanwhile
 }
 
 static void ms_on_hide(Scene* s) {
@@ -129,30 +193,28 @@ static void ms_on_update(Scene* s, double now, float dt) {
     gui_begin_frame(&ms->gui);
     menu_bg_update(&ms->bg, now, dt);
     gui_paged_grid_update(&ms->gui, &ms->grid);
+    ms_update_thumbs(ms);
 }
 
 static void ms_on_render(Scene* s) {
     MenuScene* ms = (MenuScene*)s;
-    menu_bg_render(&ms->bg, ms->scene.img);
-    canvas_copy(&s->app->screen, &ms->scene, 0, 0);
+    menu_bg_render(&ms->bg, s->app->screen.img, s->app->screen.dirty);   // no buffer needed
 }
 
 static void ms_on_resize(Scene* s, int w, int h) {
     MenuScene* ms = (MenuScene*)s;
-    canvas_destroy(&ms->scene);
-    canvas_init(&ms->scene, s->app->mlx, w, h);
     menu_bg_resize(&ms->bg, w, h);
 }
 
 static void ms_on_destroy(Scene* s) {
     MenuScene* ms = (MenuScene*)s;
+    level_thumbs_destroy(ms->thumbs);
     gui_paged_grid_free(&ms->gui, &ms->grid);
     if (ms->ui_item_skin)  mlx_delete_texture(ms->ui_item_skin);
     if (ms->ui_pager_skin && ms->ui_pager_skin != ms->ui_item_skin)
         mlx_delete_texture(ms->ui_pager_skin);
-    map_free_paths(ms->map_files, ms->map_file_count);
+    level_catalog_free(&ms->catalog);
     free(ms->ud);
-    canvas_destroy(&ms->scene);
     menu_bg_free(&ms->bg);
 }
 
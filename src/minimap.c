@@ -0,0 +1,85 @@
+#include "minimap.h"
+#include "map_occ.h"
+#include <stdlib.h>
+#include <string.h>
+
+void minimap_init(Minimap* mm) {
+    memset(mm, 0, sizeof(*mm));
+}
+
+void minimap_free(Minimap* mm) {
+    canvas_destroy(&mm->layer);
+    minimap_init(mm);
+}
+
+void minimap_invalidate(Minimap* mm) {
+    mm->tiles = NULL;
+}
+
+static void draw_cell(Minimap* mm, const GridMap* map, int x, int y) {
+    int wall = map->occ ? map_occ_wall(map->occ, x, y) : map_at(map, x, y) != 0;
+    Color c = wall ? rgba(220,220,220,255) : rgba(30,30,30,255);
+    canvas_fill_rect(&mm->layer, x * mm->scale, y * mm->scale, mm->scale, mm->scale, c);
+}
+
+void minimap_update_tile(Minimap* mm, const GridMap* map, int x, int y) {
+    if (!mm->layer.px || mm->tiles != map->data || (unsigned)x >= (unsigned)map->w || (unsigned)y >= (unsigned)map->h)
+        return;
+    draw_cell(mm, map, x, y);   // clipped to the layer (a no-op when not shown)
+}
+
+// The layer for a w x h view: black, then the cells it shows.
+static int build(Minimap* mm, int w, int h, const GridMap* map, int scale) {
+    if (mm->layer.w != w || mm->layer.h != h || !mm->layer.px) {
+        canvas_destroy(&mm->layer);
+        if (canvas_init_heap(&mm->layer, w, h) != 0) return -1;
+    }
+    mm->layer.dirty = &mm->pending;
+    mm->scale = scale;
+    mm->tiles = map->data;
+    mm->map_w = map->w;
+    mm->map_h = map->h;
+    canvas_clear(&mm->layer, rgba(0,0,0,255));   // marks all of it pending
+    int cw = (w + scale - 1) / scale, ch = (h + scale - 1) / scale;
+    if (cw > map->w) cw = map->w;
+    if (ch > map->h) ch = map->h;
+    for (int y = 0; y < ch; ++y)
+        for (int x = 0; x < cw; ++x) draw_cell(mm, map, x, y);
+    return 0;
+}
+
+void minimap_draw(Minimap* mm, Canvas* view, const GridMap* map, const Camera* cam, int scale, bool covered) {
+    if (view->w <= 0 || view->h <= 0 || scale <= 0) return;
+    if (!mm->layer.px || mm->layer.w != view->w || mm->layer.h != view->h || mm->scale != scale
+        || mm->tiles != map->data || mm->map_w != map->w || mm->map_h != map->h) {
+        if (build(mm, view->w, view->h, map, scale) != 0) return;
+    }
+    if (covered) canvas_mark(&mm->layer, 0, 0, mm->layer.w, mm->layer.h);
+    else         canvas_mark(&mm->layer, mm->marker.x, mm->marker.y, mm->marker.w, mm->marker.h);
+    canvas_composite(view, &mm->layer, &mm->pending, 0, 0, mm->layer.w, mm->layer.h);
+
+    /* player */
+    int px = (int)(cam->pos.x * scale);
+    int py = (int)(cam->pos.y * scale);
+    canvas_fill_rect(view, px-2, py-2, 5, 5, rgba(255,50,50,255));
+
+    /* facing line */
+    int lx = px + (int)(cam->dir.x * 10.0f);
+    int ly = py + (int)(cam->dir.y * 10.0f);
+    /* simple Bresenham */
+    int dx = abs(lx - px), sx = px < lx ? 1 : -1;
+    int dy = -abs(ly - py), sy = py < ly ? 1 : -1;
+    int err = dx + dy, x0 = px, y0 = py;
+    for (;;) {
+        canvas_put(view, x0, y0, rgba(255,100,100,255));
+        if (x0 == lx && y0 == ly) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+
+    /* what to restore next frame */
+    int mx0 = px - 2 < lx ? px - 2 : lx, my0 = py - 2 < ly ? py - 2 : ly;
+    int mx1 = px + 3 > lx + 1 ? px + 3 : lx + 1, my1 = py + 3 > ly + 1 ? py + 3 : ly + 1;
+    mm->marker = (CanvasRect){ mx0, my0, mx1 - mx0, my1 - my0 };
+}
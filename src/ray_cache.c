@@ -0,0 +1,222 @@
+#include "ray_cache.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef RAY_CACHE_MAX_BINS
+#define RAY_CACHE_MAX_BINS (1 << 16)
+#endif
+#define RAY_CACHE_EDGES_PER_TASK 64
+// Reused hits: widest wedge allowed (cells; below 1 for exactness, with a
+// margin for float error) and how near a cell corner along the line a hit
+// is cast instead, relative to its distance.
+#define RAY_CACHE_WEDGE_MAX    0.9f
+#define RAY_CACHE_BOUNDARY_EPS 1e-4f
+
+// Bins are uniform in "diamond angle", a cheap monotonic stand-in for the
+// angle: 0..4 counter-clockwise from +x, one unit per quadrant.
+static inline float diamond_angle(float x, float y) {
+    if (y >= 0.0f) return x >= 0.0f ? y / (x + y) : 1.0f - x / (y - x);
+    return x < 0.0f ? 2.0f - y / (-x - y) : 3.0f + x / (x - y);
+}
+
+static inline void diamond_dir(float t, float* x, float* y) {
+    int q = (int)t;
+    float f = t - (float)q;
+    switch (q & 3) {
+        case 0:  *x = 1.0f - f; *y = f;         break;
+        case 1:  *x = -f;       *y = 1.0f - f;  break;
+        case 2:  *x = f - 1.0f; *y = -f;        break;
+        default: *x = f;        *y = f - 1.0f;  break;
+    }
+}
+
+static inline int bin_of(const RayCache* c, float x, float y) {
+    int k = (int)(diamond_angle(x, y) * (float)c->nbins * 0.25f);
+    return k < c->nbins ? k : c->nbins - 1;
+}
+
+void ray_cache_init(RayCache* c) {
+    memset(c, 0, sizeof(*c));
+    c->stamp = 1;
+}
+
+void ray_cache_free(RayCache* c) {
+    free(c->edge);
+    ray_cache_init(c);
+}
+
+static void bump_stamp(RayCache* c) {
+    if (++c->stamp == 0) {       // wrapped: old stamps could match again
+        if (c->edge) memset(c->edge, 0, (size_t)c->nbins * sizeof(RayCacheEdge));
+        c->stamp = 1;
+    }
+}
+
+void ray_cache_invalidate(RayCache* c) {
+    bump_stamp(c);
+    c->keyed = false;
+    c->have_frame = false;
+}
+
+void ray_cache_forget_frame(RayCache* c) {
+    c->have_frame = false;
+}
+
+bool ray_cache_same_frame(RayCache* c, const RayCacheFrame* f) {
+    if (c->have_frame && memcmp(&c->frame, f, sizeof(*f)) == 0) return true;
+    c->frame = *f;
+    c->have_frame = true;
+    return false;
+}
+
+typedef struct EdgeJob {
+    RayCache*      c;
+    const GridMap* map;
+    Vec2f          pos;
+    const int*     list;      // edge indices to cast
+    int            count;
+    bool           simd;
+} EdgeJob;
+
+static void edge_task(void* arg, int index, int count) {
+    EdgeJob* job = (EdgeJob*)arg;
+    (void)count;
+    int i0 = index * RAY_CACHE_EDGES_PER_TASK;
+    int i1 = i0 + RAY_CACHE_EDGES_PER_TASK < job->count ? i0 + RAY_CACHE_EDGES_PER_TASK : job->count;
+    RayCache* c = job->c;
+    RayPacket pk;
+    float dx[RAY_PACKET_MAX], dy[RAY_PACKET_MAX];
+    for (int i = i0; i < i1; i += RAY_PACKET_MAX) {
+        int n = i1 - i < RAY_PACKET_MAX ? i1 - i : RAY_PACKET_MAX;
+        for (int j = 0; j < n; ++j)
+            diamond_dir((float)job->list[i + j] * 4.0f / (float)c->nbins, &dx[j], &dy[j]);
+        ray_packet_setup_dirs(&pk, job->pos, dx, dy, n);
+        if (job->simd) ray_packet_cast_simd(&pk, job->map);
+        else           ray_packet_cast_scalar(&pk, job->map);
+        for (int j = 0; j < n; ++j) {
+            RayCacheEdge* e = &c->edge[job->list[i + j]];
+            e->mapX = pk.mapX[j];
+            e->mapY = pk.mapY[j];
+            e->side = (int8_t)pk.side[j];
+            e->stamp = c->stamp;
+        }
+    }
+}
+
+int ray_cache_prepare(RayCache* c, const GridMap* map, const Camera* cam, int screen_w,
+                      WorkerPool* pool, bool simd) {
+    // enough bins that the widest (diagonal) ones are narrower than a column
+    float plane = sqrtf(cam->plane.x * cam->plane.x + cam->plane.y * cam->plane.y);
+    float dir   = sqrtf(cam->dir.x * cam->dir.x + cam->dir.y * cam->dir.y);
+    float fov   = 2.0f * atanf(plane / (dir > 0.0f ? dir : 1.0f));
+    if (!(fov > 0.0f) || screen_w <= 0) return -1;
+    int nbins = (int)ceilf(RAY_CACHE_BINS_PER_COLUMN * (float)screen_w * 6.2831853f / fov);
+    nbins = (nbins + 3) & ~3;
+    if (nbins < 4) nbins = 4;
+    if (nbins > RAY_CACHE_MAX_BINS) nbins = RAY_CACHE_MAX_BINS;
+    if (nbins != c->nbins) {
+        free(c->edge);
+        c->edge = (RayCacheEdge*)calloc((size_t)nbins, sizeof(RayCacheEdge));
+        c->nbins = c->edge ? nbins : 0;
+        c->keyed = false;
+        if (!c->edge) return -1;
+    }
+
+    if (!c->keyed || c->pos.x != cam->pos.x || c->pos.y != cam->pos.y || c->map != map ||
+        c->map_data != map->data || c->map_w != map->w || c->map_h != map->h || c->screen_w != screen_w) {
+        bump_stamp(c);
+        c->keyed = true;
+        c->pos = cam->pos;
+        c->map = map; c->map_data = map->data;
+        c->map_w = map->w; c->map_h = map->h;
+        c->screen_w = screen_w;
+        return -1;
+    }
+
+    // edges of the bins between the outermost columns (the short way round)
+    int ka = bin_of(c, cam->dir.x - cam->plane.x, cam->dir.y - cam->plane.y);
+    int kb = bin_of(c, cam->dir.x + cam->plane.x, cam->dir.y + cam->plane.y);
+    int span = (kb - ka + c->nbins) % c->nbins;
+    if (span > c->nbins / 2) { int t = ka; ka = kb; kb = t; span = c->nbins - span; }
+
+    int* list = (int*)malloc(sizeof(int) * (size_t)(span + 2));
+    if (!list) return -1;
+    int count = 0;
+    for (int i = 0; i < span + 2; ++i) {
+        int k = (ka + i) % c->nbins;
+        if (c->edge[k].stamp != c->stamp) list[count++] = k;
+    }
+    if (count) {
+        EdgeJob job = { c, map, cam->pos, list, count, simd };
+        worker_pool_run(pool, edge_task, &job, (count + RAY_CACHE_EDGES_PER_TASK - 1) / RAY_CACHE_EDGES_PER_TASK);
+    }
+    free(list);
+    return count;
+}
+
+// Both edges only crossed empty cells before the line, so a wall in the
+// wedge between them would have to lie wholly inside it: impossible while
+// the wedge (pos and the edges' hits on the line) is narrower than a cell
+// in every direction, i.e. twice its area over its longest side is below 1.
+static bool wedge_is_thin(const RayCache* c, int k, Vec2f pos, const RayCacheEdge* a) {
+    float ax, ay, bx, by;
+    diamond_dir((float)k * 4.0f / (float)c->nbins, &ax, &ay);
+    diamond_dir((float)(k + 1) * 4.0f / (float)c->nbins, &bx, &by);
+    // the line x = const (side 0) or y = const (side 1) the edges end on
+    float line = a->side == 0 ? (float)a->mapX + (bx > 0.0f ? 0.0f : 1.0f) - pos.x
+                              : (float)a->mapY + (by > 0.0f ? 0.0f : 1.0f) - pos.y;
+    float da = a->side == 0 ? ax : ay, db = a->side == 0 ? bx : by;
+    if (da * line <= 0.0f || db * line <= 0.0f) return false;
+    ax *= line / da; ay *= line / da;   // hits relative to pos
+    bx *= line / db; by *= line / db;
+    float area2 = fabsf(ax * by - ay * bx);
+    float la = ax * ax + ay * ay, lb = bx * bx + by * by;
+    float lc = (ax - bx) * (ax - bx) + (ay - by) * (ay - by);
+    float longest = sqrtf(fmaxf(la, fmaxf(lb, lc)));
+    return area2 < longest * RAY_CACHE_WEDGE_MAX;
+}
+
+unsigned ray_cache_apply(const RayCache* c, RayPacket* p, const GridMap* map, Vec2f pos) {
+    unsigned miss = 0;
+    for (int i = 0; i < p->n; ++i) {
+        float rdx = p->rayDirX[i], rdy = p->rayDirY[i];
+        int k = bin_of(c, rdx, rdy);
+        const RayCacheEdge* a = &c->edge[k];
+        const RayCacheEdge* b = &c->edge[k + 1 < c->nbins ? k + 1 : 0];
+        // both edges end on the same grid line, in the same or adjacent cells:
+        // the face between them is solid, so the column ends on it as well
+        int side = a->side;
+        int along_a = side == 0 ? a->mapY : a->mapX, along_b = side == 0 ? b->mapY : b->mapX;
+        if (a->stamp != c->stamp || b->stamp != c->stamp || b->side != side ||
+            (side == 0 ? a->mapX != b->mapX : a->mapY != b->mapY) ||
+            along_a - along_b > 1 || along_b - along_a > 1) {
+            miss |= 1u << i;
+            continue;
+        }
+        // distance to that grid line, in the same units as the DDA's perpDist
+        float rd = side == 0 ? rdx : rdy;
+        if (rd == 0.0f || !wedge_is_thin(c, k, pos, a)) { miss |= 1u << i; continue; }
+        float perpDist = side == 0
+            ? ((float)a->mapX - pos.x + (float)((1 - p->stepX[i]) / 2)) / rdx
+            : ((float)a->mapY - pos.y + (float)((1 - p->stepY[i]) / 2)) / rdy;
+        // which of the (at most two) cells along the line it lands in; too
+        // close to a cell corner to be sure of the DDA's pick: cast it
+        float hit = side == 0 ? pos.y + perpDist * rdy : pos.x + perpDist * rdx;
+        int lo = along_a < along_b ? along_a : along_b, hi = along_a ^ along_b ^ lo;
+        float slope = fabsf(side == 0 ? rdy / rdx : rdx / rdy);
+        if (fabsf(hit - roundf(hit)) < RAY_CACHE_BOUNDARY_EPS * (1.0f + perpDist) * (1.0f + slope)) {
+            miss |= 1u << i;
+            continue;
+        }
+        int cell = (int)floorf(hit);
+        cell = cell < lo ? lo : cell > hi ? hi : cell;
+
+        p->side[i] = side;
+        if (side == 0) { p->mapX[i] = a->mapX; p->mapY[i] = cell; }
+        else           { p->mapX[i] = cell;    p->mapY[i] = a->mapY; }
+        p->tile[i] = map_at(map, p->mapX[i], p->mapY[i]);
+        p->perpDist[i] = perpDist < 1e-6f ? 1e-6f : perpDist;
+    }
+    return miss;
+}
@@ -1,101 +1,437 @@
 #include "raycast.h"
+#include "raycast_dda.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-static void draw_vertical(Canvas* c, int x, int y0, int y1, Color col) {
-    if (y0 < 0) y0 = 0;
-    if (y1 >= c->h) y1 = c->h - 1;
-    if ((unsigned)x >= (unsigned)c->w || y0 > y1) return;
-    uint32_t v = color_to_u32(col);
-    uint32_t* px = (uint32_t*)c->img->pixels;
-    for (int y = y0; y <= y1; ++y) px[y * c->w + x] = v;
-}
-
-void render_scene(Canvas* scene, const GridMap* map, const Camera* cam) {
-    /* Simple sky/floor clear */
-    for (int y = 0; y < scene->h; ++y) {
-        Color col = (y < scene->h/2) ? rgba(135,206,235,255) : rgba(40,40,40,255);
-        uint32_t v = color_to_u32(col);
-        uint32_t* row = (uint32_t*)scene->img->pixels + y * scene->w;
-        for (int x = 0; x < scene->w; ++x) row[x] = v;
-    }
-
-    for (int x = 0; x < scene->w; ++x) {
-        float cameraX = 2.0f * x / (float)scene->w - 1.0f;
-        float rayDirX = cam->dir.x + cam->plane.x * cameraX;
-        float rayDirY = cam->dir.y + cam->plane.y * cameraX;
-
-        int mapX = (int)cam->pos.x;
-        int mapY = (int)cam->pos.y;
-
-        float deltaX = (rayDirX == 0.0f) ? 1e30f : fabsf(1.0f / rayDirX);
-        float deltaY = (rayDirY == 0.0f) ? 1e30f : fabsf(1.0f / rayDirY);
-
-        int stepX, stepY;
-        float sideX, sideY;
-
-        if (rayDirX < 0) { stepX = -1; sideX = (cam->pos.x - mapX) * deltaX; }
-        else             { stepX =  1; sideX = (mapX + 1.0f - cam->pos.x) * deltaX; }
-        if (rayDirY < 0) { stepY = -1; sideY = (cam->pos.y - mapY) * deltaY; }
-        else             { stepY =  1; sideY = (mapY + 1.0f - cam->pos.y) * deltaY; }
-
-        int hit = 0, side = 0, tile = 0;
-        while (!hit) {
-            if (sideX < sideY) { sideX += deltaX; mapX += stepX; side = 0; }
-            else               { sideY += deltaY; mapY += stepY; side = 1; }
-            tile = map_at(map, mapX, mapY);
-            if (tile > 0) hit = 1;
-        }
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+# include <immintrin.h>
+# define RAYCAST_HAVE_AVX2 1
+#endif
 
-        float perpDist = (side == 0) ? (sideX - deltaX) : (sideY - deltaY);
-        if (perpDist < 1e-6f) perpDist = 1e-6f;
+#define SKY_COLOR   rgba(135,206,235,255)
+#define FLOOR_COLOR rgba(40,40,40,255)
 
-        int lineH = (int)(scene->h / perpDist);
-        int drawStart = -lineH / 2 + scene->h / 2;
-        int drawEnd   =  lineH / 2 + scene->h / 2;
+Color raycast_wall_color(int tile) {
+    return (tile == 1) ? rgba(200, 0, 0, 255) :
+           (tile == 2) ? rgba(0, 200, 0, 255) :
+           (tile == 3) ? rgba(0, 0, 200, 255) :
+           (tile == 4) ? rgba(200, 200, 0, 255) :
+                         rgba(200, 200, 200, 255);
+}
 
-        Color base = (tile == 1) ? rgba(200, 0, 0, 255) :
-                     (tile == 2) ? rgba(0, 200, 0, 255) :
-                     (tile == 3) ? rgba(0, 0, 200, 255) :
-                     (tile == 4) ? rgba(200, 200, 0, 255) :
-                                   rgba(200, 200, 200, 255);
+/* simple shading for y-sides: halve r,g,b, keep alpha */
+static inline uint32_t shade_u32(uint32_t v) {
+    return ((v >> 1) & 0x7F7F7F00u) | (v & 0xFFu);
+}
 
-        if (side == 1) { /* simple shading for y-sides */
-            base.r >>= 1; base.g >>= 1; base.b >>= 1;
-        }
+/* One wall slice, clipped to the screen: flat color or one texture column. */
+typedef struct WallSlice {
+    int             y0, y1;     // inclusive, on screen
+    uint32_t        flat;       // used when tex == NULL (already shaded)
+    const uint32_t* tex;        // texture column at the chosen mip level
+    uint32_t        mask;       // texture column height - 1
+    uint32_t        pos, step;  // 16.16 texel position at y0, per-pixel step
+    int             shade;
+} WallSlice;
+
+static void wall_slice(WallSlice* ws, const RayPacket* pk, int i, const Camera* cam,
+                       const WallTexSet* walls, int screen_h) {
+    int tile = pk->tile[i], side = pk->side[i];
+    float perpDist = pk->perpDist[i];
+    int lineH = (int)(screen_h / perpDist);
+    int drawStart = -lineH / 2 + screen_h / 2;
+    int drawEnd   =  lineH / 2 + screen_h / 2;
+    ws->y0 = drawStart < 0 ? 0 : drawStart;
+    ws->y1 = drawEnd >= screen_h ? screen_h - 1 : drawEnd;
+    ws->shade = side == 1;
+    ws->tex = NULL;
+    ws->flat = 0;
+
+    const WallTex* wt = (walls && (unsigned)tile < WALL_TEX_SLOTS) ? &walls->tex[tile] : NULL;
+    if (!wt || !wt->texels) {
+        uint32_t v = color_to_u32(raycast_wall_color(tile));
+        ws->flat = ws->shade ? shade_u32(v) : v;
+        return;
+    }
+    /* where the wall was hit, 0..1 along the face */
+    float wallX = (side == 0) ? cam->pos.y + perpDist * pk->rayDirY[i]
+                              : cam->pos.x + perpDist * pk->rayDirX[i];
+    wallX -= floorf(wallX);
+
+    /* mip: level-0 texels covered by one screen pixel = size / lineH */
+    int level = wall_tex_level(wt, (float)(1 << wt->log2) * perpDist / (float)screen_h);
+    int s = 1 << (wt->log2 - level);
+    int texX = (int)(wallX * (float)s);
+    if (texX >= s) texX = s - 1;
+    if ((side == 0 && pk->rayDirX[i] > 0) || (side == 1 && pk->rayDirY[i] < 0)) texX = s - texX - 1;
+
+    int h = lineH > 0 ? lineH : 1;
+    ws->tex  = wt->texels + wt->offset[level] + (size_t)texX * s;
+    ws->mask = (uint32_t)s - 1;
+    ws->step = (uint32_t)(((uint64_t)s << 16) / (uint64_t)h);
+    ws->pos  = (uint32_t)((int64_t)(ws->y0 - drawStart) * ws->step);
+}
+
+/* Write rows y0..y1 of a wall slice; 'col' is pixel (x, 0), 'stride' the
+   distance between rows (1 for column-major canvases). */
+static inline void write_slice(uint32_t* col, size_t stride, const WallSlice* ws) {
+    if (!ws->tex) {
+        for (int y = ws->y0; y <= ws->y1; ++y) col[y * stride] = ws->flat;
+        return;
+    }
+    uint32_t pos = ws->pos;
+    if (ws->shade) {
+        for (int y = ws->y0; y <= ws->y1; ++y, pos += ws->step)
+            col[y * stride] = shade_u32(ws->tex[(pos >> 16) & ws->mask]);
+    } else {
+        for (int y = ws->y0; y <= ws->y1; ++y, pos += ws->step)
+            col[y * stride] = ws->tex[(pos >> 16) & ws->mask];
+    }
+}
+
+/* Floor and ceiling, one entry per screen row. Every pixel of a row is at the
+   same distance, so the texel of column x is (u0 + du*x, v0 + dv*x): 16.16
+   fixed point at the mip level picked for the row. The math wraps mod 2^32,
+   which keeps the integer bits we mask, so stepping along a row and computing
+   a single column give the same texel. SoA so a column reads 8 rows at once. */
+typedef struct FloorRows {
+    const uint32_t* tex[2];     // [0] ceiling, [1] floor, all levels; NULL = flat
+    uint32_t        flat[2];
+    int             mid;        // rows < mid are ceiling
+    uint32_t       *u0, *v0, *du, *dv;
+    uint32_t       *mask;       // texture size - 1 at the row's level
+    uint32_t       *log2;       // texture size is 1 << log2
+    uint32_t       *offset;     // start of the row's level in tex[]
+} FloorRows;
+
+static inline uint32_t to_fixed(float v) {
+    return (uint32_t)(int64_t)(v * 65536.0f);
+}
+
+void raycast_rows_free(RaycastRows* r) {
+    free(r->mem);
+    r->mem = NULL;
+    r->cap = 0;
+}
+
+/* Storage for h rows: rc->rows when the caller keeps one (reallocated only
+   when the canvas gets taller), else 'own' for this frame. NULL = no memory. */
+static uint32_t* floor_rows_mem(const RaycastCtx* rc, RaycastRows* own, int h) {
+    RaycastRows* r = (rc && rc->rows) ? rc->rows : own;
+    if (r->cap < h) {
+        raycast_rows_free(r);
+        r->mem = (uint32_t*)malloc((size_t)h * 7 * sizeof(uint32_t));
+        if (!r->mem) return NULL;
+        r->cap = h;
+    }
+    return r->mem;
+}
+
+/* Returns -1 when textured rows had no 'mem': they fall back to flat colors. */
+static int floor_rows_init(FloorRows* fr, const RaycastCtx* rc, const Camera* cam, int w, int h, uint32_t* mem) {
+    fr->mid = h / 2;
+    fr->flat[0] = color_to_u32(SKY_COLOR);
+    fr->flat[1] = color_to_u32(FLOOR_COLOR);
+
+    const WallTex* t[2] = { rc ? rc->ceiling : NULL, rc ? rc->floor : NULL };
+    for (int k = 0; k < 2; ++k) fr->tex[k] = (t[k] && t[k]->texels) ? t[k]->texels : NULL;
+    if (!mem) {
+        int textured = fr->tex[0] || fr->tex[1];
+        fr->tex[0] = fr->tex[1] = NULL;
+        return textured ? -1 : 0;
+    }
+    fr->u0 = mem;         fr->v0 = mem + h;
+    fr->du = mem + 2 * h; fr->dv = mem + 3 * h;
+    fr->mask = mem + 4 * h; fr->log2 = mem + 5 * h; fr->offset = mem + 6 * h;
+
+    float rx0 = cam->dir.x - cam->plane.x, ry0 = cam->dir.y - cam->plane.y;
+    for (int y = 0; y < h; ++y) {
+        const WallTex* tx = t[y >= fr->mid];
+        if (!tx || !tx->texels) continue;
+        /* camera at half wall height: row p pixels from the horizon sees the
+           plane at h / (2p), the distance that puts a wall's edge there */
+        int p = y > fr->mid ? y - fr->mid : fr->mid - y;
+        if (p == 0) p = 1;
+        float dist = 0.5f * (float)h / (float)p;
+        float sx = dist * 2.0f * cam->plane.x / (float)w;
+        float sy = dist * 2.0f * cam->plane.y / (float)w;
+
+        /* mip: level-0 texels per pixel, across the row or down to the next one */
+        float s0 = (float)(1 << tx->log2);
+        float across = fmaxf(fabsf(sx), fabsf(sy)) * s0;
+        int level = wall_tex_level(tx, fmaxf(across, dist / (float)p * s0));
+        float s = (float)(1 << (tx->log2 - level));
+
+        fr->u0[y] = to_fixed((cam->pos.x + dist * rx0) * s);
+        fr->v0[y] = to_fixed((cam->pos.y + dist * ry0) * s);
+        fr->du[y] = to_fixed(sx * s);
+        fr->dv[y] = to_fixed(sy * s);
+        fr->log2[y] = (uint32_t)(tx->log2 - level);
+        fr->mask[y] = (1u << fr->log2[y]) - 1;
+        fr->offset[y] = (uint32_t)tx->offset[level];
+    }
+    return 0;
+}
+
+static inline uint32_t floor_index(uint32_t mask, uint32_t log2, uint32_t u, uint32_t v) {
+    return (((u >> 16) & mask) << log2) | ((v >> 16) & mask);
+}
+
+#if defined(RAYCAST_HAVE_AVX2)
+/* 8 texels per gather; both return the first pixel left for the scalar tail. */
+__attribute__((target("avx2")))
+static int floor_span_avx2(uint32_t* row, const uint32_t* tex, uint32_t mask, uint32_t log2,
+                           uint32_t u0, uint32_t v0, uint32_t du, uint32_t dv, int x0, int x1) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i vmask = _mm256_set1_epi32((int)mask);
+    const __m128i shift = _mm_cvtsi32_si128((int)log2);
+    const __m256i du8 = _mm256_set1_epi32((int)(du * 8u)), dv8 = _mm256_set1_epi32((int)(dv * 8u));
+    __m256i u = _mm256_add_epi32(_mm256_set1_epi32((int)(u0 + du * (uint32_t)x0)),
+                                 _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)du)));
+    __m256i v = _mm256_add_epi32(_mm256_set1_epi32((int)(v0 + dv * (uint32_t)x0)),
+                                 _mm256_mullo_epi32(lane, _mm256_set1_epi32((int)dv)));
+    int x = x0;
+    for (; x + 8 <= x1; x += 8) {
+        __m256i iu = _mm256_and_si256(_mm256_srli_epi32(u, 16), vmask);
+        __m256i iv = _mm256_and_si256(_mm256_srli_epi32(v, 16), vmask);
+        __m256i idx = _mm256_or_si256(_mm256_sll_epi32(iu, shift), iv);
+        _mm256_storeu_si256((__m256i*)(row + x), _mm256_i32gather_epi32((const int*)tex, idx, 4));
+        u = _mm256_add_epi32(u, du8);
+        v = _mm256_add_epi32(v, dv8);
+    }
+    return x;
+}
 
-        draw_vertical(scene, x, drawStart, drawEnd, base);
+__attribute__((target("avx2")))
+static int floor_column_avx2(uint32_t* col, const FloorRows* fr, const uint32_t* tex,
+                             int x, int y0, int y1) {
+    const __m256i vx = _mm256_set1_epi32(x);
+    int y = y0;
+    for (; y + 8 <= y1; y += 8) {
+        __m256i u = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(fr->u0 + y)),
+                                     _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(fr->du + y)), vx));
+        __m256i v = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(fr->v0 + y)),
+                                     _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(fr->dv + y)), vx));
+        __m256i mask = _mm256_loadu_si256((const __m256i*)(fr->mask + y));
+        __m256i iu = _mm256_and_si256(_mm256_srli_epi32(u, 16), mask);
+        __m256i iv = _mm256_and_si256(_mm256_srli_epi32(v, 16), mask);
+        __m256i idx = _mm256_or_si256(_mm256_sllv_epi32(iu, _mm256_loadu_si256((const __m256i*)(fr->log2 + y))), iv);
+        idx = _mm256_add_epi32(idx, _mm256_loadu_si256((const __m256i*)(fr->offset + y)));
+        _mm256_storeu_si256((__m256i*)(col + y), _mm256_i32gather_epi32((const int*)tex, idx, 4));
     }
+    return y;
 }
 
-#include <stdio.h>
-void draw_minimap(Canvas* mini, const GridMap* map, const Camera* cam, int scale) {
-    canvas_clear(mini, rgba(0,0,0,255));
-    /* walls */
-    for (int y = 0; y < map->h; ++y) {
-        for (int x = 0; x < map->w; ++x) {
-            int v = map_at(map, x, y);
-            Color c = v ? rgba(220,220,220,255) : rgba(30,30,30,255);
-            canvas_fill_rect(mini, x * scale, y * scale, scale, scale, c);
+static int cpu_has_avx2(void) { return __builtin_cpu_supports("avx2"); }
+#endif
+
+/* Row-major canvases: columns x0..x1-1 of row y, contiguous. */
+static void floor_span(uint32_t* row, const FloorRows* fr, int y, int x0, int x1) {
+    const uint32_t* tex = fr->tex[y >= fr->mid];
+    if (!tex) {
+        uint32_t v = fr->flat[y >= fr->mid];
+        for (int x = x0; x < x1; ++x) row[x] = v;
+        return;
+    }
+    tex += fr->offset[y];
+    uint32_t mask = fr->mask[y], log2 = fr->log2[y], du = fr->du[y], dv = fr->dv[y];
+#if defined(RAYCAST_HAVE_AVX2)
+    if (cpu_has_avx2()) x0 = floor_span_avx2(row, tex, mask, log2, fr->u0[y], fr->v0[y], du, dv, x0, x1);
+#endif
+    uint32_t u = fr->u0[y] + du * (uint32_t)x0, v = fr->v0[y] + dv * (uint32_t)x0;
+    for (int x = x0; x < x1; ++x, u += du, v += dv)
+        row[x] = tex[floor_index(mask, log2, u, v)];
+}
+
+/* Column-major canvases: rows y0..y1-1 of column x, all ceiling or all floor. */
+static void floor_column(uint32_t* col, const FloorRows* fr, int x, int y0, int y1) {
+    if (y0 >= y1) return;
+    const uint32_t* tex = fr->tex[y0 >= fr->mid];
+    if (!tex) {
+        uint32_t v = fr->flat[y0 >= fr->mid];
+        for (int y = y0; y < y1; ++y) col[y] = v;
+        return;
+    }
+#if defined(RAYCAST_HAVE_AVX2)
+    if (cpu_has_avx2()) y0 = floor_column_avx2(col, fr, tex, x, y0, y1);
+#endif
+    for (int y = y0; y < y1; ++y) {
+        uint32_t u = fr->u0[y] + fr->du[y] * (uint32_t)x, v = fr->v0[y] + fr->dv[y] * (uint32_t)x;
+        col[y] = tex[fr->offset[y] + floor_index(fr->mask[y], fr->log2[y], u, v)];
+    }
+}
+
+static void cast_packet(RayPacket* p, const GridMap* map, RaycastMode mode, unsigned lanes) {
+    if (mode == RAYCAST_PACKET) ray_packet_cast_simd_lanes(p, map, lanes);
+    else                        ray_packet_cast_scalar_lanes(p, map, lanes);
+}
+
+/* Cast every lane of a span's packets; returns the lanes the ray cache
+   resolved. The rest are repacked into full packets before casting: a SIMD
+   packet walks as long as its longest lane, so holes alone save nothing. */
+static uint64_t cast_span(RayPacket* pk, int np, const GridMap* map, const RayCache* cache,
+                          RaycastMode mode, Vec2f pos) {
+    if (!cache) {
+        for (int k = 0; k < np; ++k) cast_packet(&pk[k], map, mode, (1u << pk[k].n) - 1);
+        return 0;
+    }
+    uint64_t cached = 0;
+    RayPacket tmp;
+    memset(&tmp, 0, sizeof(tmp));
+    int from_k[RAY_PACKET_MAX], from_i[RAY_PACKET_MAX], m = 0;
+    for (int k = 0; k <= np; ++k) {
+        unsigned miss = 0;
+        if (k < np) {
+            miss = ray_cache_apply(cache, &pk[k], map, pos);
+            cached += (uint64_t)(pk[k].n - __builtin_popcount(miss));
+        }
+        for (int i = 0; i < RAY_PACKET_MAX; ++i) {
+            if (miss & (1u << i)) {
+                ray_packet_copy_lane(&tmp, m, &pk[k], i);
+                from_k[m] = k; from_i[m] = i;
+                ++m;
+            }
+            if (m == RAY_PACKET_MAX || (k == np && m > 0)) {
+                tmp.n = m;
+                cast_packet(&tmp, map, mode, (1u << m) - 1);
+                for (int j = 0; j < m; ++j) ray_packet_copy_lane(&pk[from_k[j]], from_i[j], &tmp, j);
+                m = 0;
+            }
+        }
+    }
+    return cached;
+}
+
+static void render_columns(Canvas* scene, const GridMap* map, const Camera* cam,
+                           const RaycastCtx* rc, const FloorRows* fr, const RayCache* cache,
+                           int x0, int x1) {
+    int col_major = scene->layout == CANVAS_COL_MAJOR;
+    int w = scene->w, h = scene->h;
+    size_t stride = (size_t)scene->stride;
+    RaycastMode mode = rc ? rc->mode : RAYCAST_SCALAR;
+    const WallTexSet* walls = rc ? rc->walls : NULL;
+    int ceil_tex = fr->tex[0] != NULL, floor_tex = fr->tex[1] != NULL;
+    uint64_t texels = 0, floor_texels = 0, cached = 0, steps = 0;
+
+    RayPacket pk[RAYCAST_FLOOR_SPAN / RAY_PACKET_MAX];
+    WallSlice ws[RAYCAST_FLOOR_SPAN];
+    for (int xs = x0; xs < x1; xs += RAYCAST_FLOOR_SPAN) {
+        int xe = x1 - xs < RAYCAST_FLOOR_SPAN ? x1 : xs + RAYCAST_FLOOR_SPAN;
+        int np = 0;
+        for (int x = xs; x < xe; x += RAY_PACKET_MAX, ++np)
+            ray_packet_setup(&pk[np], cam, x, xe - x < RAY_PACKET_MAX ? xe - x : RAY_PACKET_MAX, w);
+        cached += cast_span(pk, np, map, cache, mode, cam->pos);
+        for (int k = 0; k < np; ++k) {
+            for (int i = 0; i < pk[k].n; ++i) {
+                WallSlice* s = &ws[k * RAY_PACKET_MAX + i];
+                wall_slice(s, &pk[k], i, cam, walls, h);
+                if (s->tex) texels += (uint64_t)(s->y1 - s->y0 + 1);
+                steps += (uint64_t)pk[k].steps[i];
+            }
         }
+
+        if (col_major) {
+            for (int x = xs; x < xe; ++x) {
+                const WallSlice* s = &ws[x - xs];
+                uint32_t* col = scene->px + (size_t)x * stride;
+                floor_column(col, fr, x, 0, s->y0);
+                write_slice(col, 1, s);
+                floor_column(col, fr, x, s->y1 + 1, h);
+                floor_texels += (uint64_t)(ceil_tex * s->y0 + floor_tex * (h - 1 - s->y1));
+            }
+            continue;
+        }
+
+        /* ceiling rows above the highest wall top and floor rows below the
+           lowest wall bottom of the span; the rows between are wall in every
+           column, and walls overwrite what the partial rows drew */
+        int top = 0, bot = h;
+        for (int i = 0; i < xe - xs; ++i) {
+            if (ws[i].y0 > top)     top = ws[i].y0;
+            if (ws[i].y1 + 1 < bot) bot = ws[i].y1 + 1;
+        }
+        for (int y = 0; y < top; ++y) floor_span(scene->px + (size_t)y * stride, fr, y, xs, xe);
+        for (int y = bot; y < h; ++y) floor_span(scene->px + (size_t)y * stride, fr, y, xs, xe);
+        floor_texels += (uint64_t)(ceil_tex * top + floor_tex * (h - bot)) * (uint64_t)(xe - xs);
+        for (int x = xs; x < xe; ++x) write_slice(scene->px + x, stride, &ws[x - xs]);
     }
-    /* player */
-    int px = (int)(cam->pos.x * scale);
-    int py = (int)(cam->pos.y * scale);
-    canvas_fill_rect(mini, px-2, py-2, 5, 5, rgba(255,50,50,255));
-
-    /* facing line */
-    int lx = px + (int)(cam->dir.x * 10.0f);
-    int ly = py + (int)(cam->dir.y * 10.0f);
-    /* simple Bresenham */
-    int dx = abs(lx - px), sx = px < lx ? 1 : -1;
-    int dy = -abs(ly - py), sy = py < ly ? 1 : -1;
-    int err = dx + dy, x0 = px, y0 = py;
-    for (;;) {
-        canvas_put(mini, x0, y0, rgba(255,100,100,255));
-        if (x0 == lx && y0 == ly) break;
-        int e2 = 2 * err;
-        if (e2 >= dy) { err += dy; x0 += sx; }
-        if (e2 <= dx) { err += dx; y0 += sy; }
+    if (rc && rc->stats) {
+        __atomic_fetch_add(&rc->stats->columns, (uint64_t)(x1 - x0), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rc->stats->wall_texels, texels, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rc->stats->floor_texels, floor_texels, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rc->stats->cached_columns, cached, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rc->stats->dda_steps, steps, __ATOMIC_RELAXED);
     }
 }
+
+typedef struct StripJob {
+    Canvas*           scene;
+    const GridMap*    map;
+    const Camera*     cam;
+    const RaycastCtx* rc;
+    const FloorRows*  floor;
+    const RayCache*   cache;    // NULL when it is not usable this frame
+    int               strip_w;
+} StripJob;
+
+static void strip_task(void* arg, int index, int count) {
+    StripJob* job = (StripJob*)arg;
+    (void)count;
+    int x0 = index * job->strip_w;
+    int x1 = x0 + job->strip_w;
+    if (x1 > job->scene->w) x1 = job->scene->w;
+    if (x0 < x1) render_columns(job->scene, job->map, job->cam, job->rc, job->floor, job->cache, x0, x1);
+}
+
+/* Ray cache: skip the frame when nothing it depends on changed, else make
+   the edges valid. Returns the cache to read from, or NULL. */
+static const RayCache* use_cache(Canvas* scene, const GridMap* map, const Camera* cam,
+                                 const RaycastCtx* rc, bool* skip) {
+    *skip = false;
+    RayCache* cache = rc ? rc->cache : NULL;
+    if (!cache) return NULL;
+
+    RayCacheFrame f;
+    memset(&f, 0, sizeof(f));
+    f.cam = *cam;
+    f.map = map; f.map_data = map->data; f.map_dist = map->dist; f.map_occ = map->occ;
+    f.map_w = map->w; f.map_h = map->h;
+    f.px = scene->px; f.w = scene->w; f.h = scene->h; f.layout = (int)scene->layout; f.stride = scene->stride;
+    f.mode = (int)rc->mode;
+    f.tex[0] = rc->walls; f.tex[1] = rc->floor; f.tex[2] = rc->ceiling;
+    if (ray_cache_same_frame(cache, &f)) {
+        if (rc->stats) rc->stats->skipped_frames++;
+        *skip = true;
+        return NULL;
+    }
+    int edges = ray_cache_prepare(cache, map, cam, scene->w, rc->pool, rc->mode == RAYCAST_PACKET);
+    if (edges < 0) return NULL;
+    if (rc->stats) rc->stats->edge_rays += (uint64_t)edges;
+    return cache;
+}
+
+void render_scene(Canvas* scene, const GridMap* map, const Camera* cam, const RaycastCtx* rc) {
+    if (scene->w <= 0 || scene->h <= 0) return;
+    WorkerPool* pool = rc ? rc->pool : NULL;
+    bool skip;
+    const RayCache* cache = use_cache(scene, map, cam, rc, &skip);
+    if (skip) return;
+
+    int strips = worker_pool_threads(pool) * RAYCAST_STRIPS_PER_THREAD;
+    int strip_w = (scene->w + strips - 1) / strips;
+    strip_w = (strip_w + RAYCAST_STRIP_ALIGN - 1) / RAYCAST_STRIP_ALIGN * RAYCAST_STRIP_ALIGN;
+    strips = (scene->w + strip_w - 1) / strip_w;
+
+    /* the row table, refilled per frame and shared read-only by every strip */
+    RaycastRows own = { 0 };
+    FloorRows fr;
+    bool flat = floor_rows_init(&fr, rc, cam, scene->w, scene->h, floor_rows_mem(rc, &own, scene->h)) != 0;
+
+    StripJob job = { scene, map, cam, rc, &fr, cache, strip_w };
+    worker_pool_run(pool, strip_task, &job, strips);
+    raycast_rows_free(&own);
+    if (flat && rc && rc->cache) rc->cache->have_frame = false;   // drawn without textures: redraw next call
+    canvas_mark(scene, 0, 0, scene->w, scene->h);   // strips write px directly (skipped frames mark nothing)
+}
+
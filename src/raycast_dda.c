@@ -0,0 +1,515 @@
+#include "raycast_dda.h"
+#include "map_occ.h"
+#include <math.h>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define DDA_HAVE_V4 1
+#elif defined(__wasm_simd128__)
+# include <wasm_simd128.h>
+# define DDA_HAVE_V4 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+# include <immintrin.h>
+# define DDA_HAVE_AVX2 1
+#endif
+
+// ---------------- Setup / scalar ----------------
+static void setup_lane(RayPacket* p, int i, Vec2f pos, float rayDirX, float rayDirY) {
+    int mapX = (int)pos.x;
+    int mapY = (int)pos.y;
+
+    float deltaX = (rayDirX == 0.0f) ? 1e30f : fabsf(1.0f / rayDirX);
+    float deltaY = (rayDirY == 0.0f) ? 1e30f : fabsf(1.0f / rayDirY);
+
+    if (rayDirX < 0) { p->stepX[i] = -1; p->sideX[i] = (pos.x - mapX) * deltaX; }
+    else             { p->stepX[i] =  1; p->sideX[i] = (mapX + 1.0f - pos.x) * deltaX; }
+    if (rayDirY < 0) { p->stepY[i] = -1; p->sideY[i] = (pos.y - mapY) * deltaY; }
+    else             { p->stepY[i] =  1; p->sideY[i] = (mapY + 1.0f - pos.y) * deltaY; }
+
+    p->rayDirX[i] = rayDirX; p->rayDirY[i] = rayDirY;
+    p->deltaX[i]  = deltaX;  p->deltaY[i]  = deltaY;
+    p->mapX[i]    = mapX;    p->mapY[i]    = mapY;
+    p->side[i]    = 0;       p->tile[i]    = 0;
+    p->steps[i]   = 0;
+}
+
+// park unused lanes on a harmless state (SIMD loads read all lanes)
+static void park_lanes(RayPacket* p) {
+    for (int i = p->n; i < RAY_PACKET_MAX; ++i) {
+        p->rayDirX[i] = p->rayDirY[i] = 0.0f;
+        p->deltaX[i] = p->deltaY[i] = p->sideX[i] = p->sideY[i] = 1.0f;
+        p->mapX[i] = p->mapY[i] = p->stepX[i] = p->stepY[i] = 0;
+        p->side[i] = p->tile[i] = p->steps[i] = 0;
+    }
+}
+
+void ray_packet_setup(RayPacket* p, const Camera* cam, int x0, int n, int screen_w) {
+    if (n > RAY_PACKET_MAX) n = RAY_PACKET_MAX;
+    p->n = n;
+    for (int i = 0; i < n; ++i) {
+        float cameraX = 2.0f * (x0 + i) / (float)screen_w - 1.0f;
+        setup_lane(p, i, cam->pos, cam->dir.x + cam->plane.x * cameraX, cam->dir.y + cam->plane.y * cameraX);
+    }
+    park_lanes(p);
+}
+
+void ray_packet_setup_dirs(RayPacket* p, Vec2f pos, const float* dirX, const float* dirY, int n) {
+    if (n > RAY_PACKET_MAX) n = RAY_PACKET_MAX;
+    p->n = n;
+    for (int i = 0; i < n; ++i) setup_lane(p, i, pos, dirX[i], dirY[i]);
+    park_lanes(p);
+}
+
+void ray_packet_copy_lane(RayPacket* dst, int j, const RayPacket* src, int i) {
+    dst->rayDirX[j] = src->rayDirX[i]; dst->rayDirY[j] = src->rayDirY[i];
+    dst->deltaX[j]  = src->deltaX[i];  dst->deltaY[j]  = src->deltaY[i];
+    dst->sideX[j]   = src->sideX[i];   dst->sideY[j]   = src->sideY[i];
+    dst->mapX[j]    = src->mapX[i];    dst->mapY[j]    = src->mapY[i];
+    dst->stepX[j]   = src->stepX[i];   dst->stepY[j]   = src->stepY[i];
+    dst->side[j]    = src->side[i];    dst->tile[j]    = src->tile[i];
+    dst->perpDist[j] = src->perpDist[i];
+    dst->steps[j]   = src->steps[i];
+}
+
+// Crossings to skip inside a wall-free box that reaches rx more cells past
+// the current one along stepX and ry more along stepY: the ray leaves the
+// box at time T (its rx-th crossing past sideX or ry-th past sideY,
+// whichever comes first) and every crossing before T stays inside. The
+// SIMD walks repeat these exact float ops.
+static inline void jump_counts(float rx, float ry, float sideX, float sideY, float deltaX, float deltaY,
+                               float* cx, float* cy) {
+    float T = fminf(sideX + rx * deltaX, sideY + ry * deltaY);
+    *cx = ceilf(fminf(fmaxf((T - sideX) / deltaX, 0.0f), rx));
+    *cy = ceilf(fminf(fmaxf((T - sideY) / deltaY, 0.0f), ry));
+}
+
+// Largest empty occupancy square around in-map cell (x, y): false when the
+// cell is a wall, else true with the cells left to the square's far edges.
+static inline bool occ_probe(const MapOcc* o, int x, int y, int stepX, int stepY, int* rx, int* ry) {
+    for (int k = MAP_OCC_LEVELS - 1; k >= 0; --k) {
+        int sh = 3 * k, ux = x >> sh, uy = y >> sh;
+        if ((o->level[k][map_occ_word(o, k, ux, uy)] >> map_occ_shift(ux, uy)) & 1u) continue;
+        int x0 = ux << sh, y0 = uy << sh, n = (1 << sh) - 1;
+        *rx = stepX > 0 ? x0 + n - x : x - x0;
+        *ry = stepY > 0 ? y0 + n - y : y - y0;
+        return true;
+    }
+    return false;
+}
+
+// Tile of a wall cell the distance field or occupancy reported. A streamed
+// block that is not resident yet reads 0 there (map_stream.h): wall 1
+// stands in, so every kernel stops on the hit and reports a wall id.
+static inline int hit_tile(const GridMap* map, size_t idx) {
+    int t = map->data[idx];
+    return t > 0 ? t : 1;
+}
+
+// Continue lane 'i' from its current state until it hits a wall.
+static void walk_lane(RayPacket* p, int i, const GridMap* map) {
+    float sideX = p->sideX[i], sideY = p->sideY[i];
+    const float deltaX = p->deltaX[i], deltaY = p->deltaY[i];
+    int mapX = p->mapX[i], mapY = p->mapY[i];
+    const int stepX = p->stepX[i], stepY = p->stepY[i];
+    int side = p->side[i], tile, steps = p->steps[i];
+    const uint8_t* dist = map->dist;
+    const MapOcc* occ = map->occ;
+    for (;;) {
+        if (sideX < sideY) { sideX += deltaX; mapX += stepX; side = 0; }
+        else               { sideY += deltaY; mapY += stepY; side = 1; }
+        ++steps;
+        if (!dist && !occ) {
+            tile = map_at(map, mapX, mapY);
+            if (tile > 0) break;
+            continue;
+        }
+        if ((unsigned)mapX >= (unsigned)map->w || (unsigned)mapY >= (unsigned)map->h) { tile = 1; break; }
+        size_t idx = map_index(map, mapX, mapY);
+        int rx, ry;
+        if (dist) {
+            int d = dist[idx];
+            if (d == 0) { tile = hit_tile(map, idx); break; }
+            rx = ry = d - 1;
+        } else if (!occ_probe(occ, mapX, mapY, stepX, stepY, &rx, &ry)) {
+            tile = hit_tile(map, idx);
+            break;
+        }
+        if (rx > 0 || ry > 0) {
+            float cx, cy;
+            jump_counts((float)rx, (float)ry, sideX, sideY, deltaX, deltaY, &cx, &cy);
+            sideX += cx * deltaX; mapX += stepX * (int)cx;
+            sideY += cy * deltaY; mapY += stepY * (int)cy;
+        }
+    }
+    p->sideX[i] = sideX; p->sideY[i] = sideY;
+    p->mapX[i]  = mapX;  p->mapY[i]  = mapY;
+    p->side[i]  = side;  p->tile[i]  = tile;
+    p->steps[i] = steps;
+}
+
+static void finish_lanes(RayPacket* p, unsigned lanes) {
+    for (int i = 0; i < p->n; ++i) {
+        if (!(lanes & (1u << i))) continue;
+        float perpDist = (p->side[i] == 0) ? (p->sideX[i] - p->deltaX[i]) : (p->sideY[i] - p->deltaY[i]);
+        if (perpDist < 1e-6f) perpDist = 1e-6f;
+        p->perpDist[i] = perpDist;
+    }
+}
+
+void ray_packet_cast_scalar_lanes(RayPacket* p, const GridMap* map, unsigned lanes) {
+    for (int i = 0; i < p->n; ++i)
+        if (lanes & (1u << i)) walk_lane(p, i, map);
+    finish_lanes(p, lanes);
+}
+
+void ray_packet_cast_scalar(RayPacket* p, const GridMap* map) {
+    ray_packet_cast_scalar_lanes(p, map, (1u << p->n) - 1);
+}
+
+// ---------------- 4-wide (SSE2 / WASM SIMD128) ----------------
+#if defined(DDA_HAVE_V4)
+# if defined(__SSE2__)
+typedef __m128  v4f;
+typedef __m128i v4i;
+#  define v4f_load(p)        _mm_loadu_ps(p)
+#  define v4f_store(p, v)    _mm_storeu_ps((p), (v))
+#  define v4i_load(p)        _mm_loadu_si128((const __m128i*)(p))
+#  define v4i_store(p, v)    _mm_storeu_si128((__m128i*)(p), (v))
+#  define v4i_splat(x)       _mm_set1_epi32(x)
+#  define v4f_add(a, b)      _mm_add_ps((a), (b))
+#  define v4i_add(a, b)      _mm_add_epi32((a), (b))
+#  define v4i_and(a, b)      _mm_and_si128((a), (b))
+#  define v4i_clear(m, a)    _mm_andnot_si128((m), (a))           /* a & ~m */
+#  define v4i_gt(a, b)       _mm_cmpgt_epi32((a), (b))
+#  define v4f_lt(a, b)       _mm_castps_si128(_mm_cmplt_ps((a), (b)))
+#  define v4i_sel(m, a, b)   _mm_or_si128(_mm_and_si128((m), (a)), _mm_andnot_si128((m), (b)))
+#  define v4f_sel(m, a, b)   _mm_castsi128_ps(v4i_sel((m), _mm_castps_si128(a), _mm_castps_si128(b)))
+#  define v4i_bits(m)        _mm_movemask_ps(_mm_castsi128_ps(m))
+#  define v4i_sub(a, b)      _mm_sub_epi32((a), (b))
+#  define v4f_splat(x)       _mm_set1_ps(x)
+#  define v4f_sub(a, b)      _mm_sub_ps((a), (b))
+#  define v4f_mul(a, b)      _mm_mul_ps((a), (b))
+#  define v4f_div(a, b)      _mm_div_ps((a), (b))
+#  define v4f_min(a, b)      _mm_min_ps((a), (b))
+#  define v4f_max(a, b)      _mm_max_ps((a), (b))
+#  define v4f_from_i(a)      _mm_cvtepi32_ps(a)
+#  define v4i_from_f(a)      _mm_cvttps_epi32(a)
+#  define v4i_sign_of(a)     _mm_srai_epi32((a), 31)
+#  define v4i_xor(a, b)      _mm_xor_si128((a), (b))
+// ceil for values in [0, 2^31): truncate, then add 1 where that rounded down
+static inline v4f v4f_ceil(v4f a) {
+    v4f t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_add_ps(t, _mm_and_ps(_mm_cmplt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+# else
+typedef v128_t v4f;
+typedef v128_t v4i;
+#  define v4f_load(p)        wasm_v128_load(p)
+#  define v4f_store(p, v)    wasm_v128_store((p), (v))
+#  define v4i_load(p)        wasm_v128_load(p)
+#  define v4i_store(p, v)    wasm_v128_store((p), (v))
+#  define v4i_splat(x)       wasm_i32x4_splat(x)
+#  define v4f_add(a, b)      wasm_f32x4_add((a), (b))
+#  define v4i_add(a, b)      wasm_i32x4_add((a), (b))
+#  define v4i_and(a, b)      wasm_v128_and((a), (b))
+#  define v4i_clear(m, a)    wasm_v128_andnot((a), (m))           /* a & ~m */
+#  define v4i_gt(a, b)       wasm_i32x4_gt((a), (b))
+#  define v4f_lt(a, b)       wasm_f32x4_lt((a), (b))
+#  define v4i_sel(m, a, b)   wasm_v128_bitselect((a), (b), (m))
+#  define v4f_sel(m, a, b)   wasm_v128_bitselect((a), (b), (m))
+#  define v4i_bits(m)        ((int)wasm_i32x4_bitmask(m))
+#  define v4i_sub(a, b)      wasm_i32x4_sub((a), (b))
+#  define v4f_splat(x)       wasm_f32x4_splat(x)
+#  define v4f_sub(a, b)      wasm_f32x4_sub((a), (b))
+#  define v4f_mul(a, b)      wasm_f32x4_mul((a), (b))
+#  define v4f_div(a, b)      wasm_f32x4_div((a), (b))
+#  define v4f_min(a, b)      wasm_f32x4_min((a), (b))
+#  define v4f_max(a, b)      wasm_f32x4_max((a), (b))
+#  define v4f_from_i(a)      wasm_f32x4_convert_i32x4(a)
+#  define v4i_from_f(a)      wasm_i32x4_trunc_sat_f32x4(a)
+#  define v4i_sign_of(a)     wasm_i32x4_shr((a), 31)
+#  define v4i_xor(a, b)      wasm_v128_xor((a), (b))
+#  define v4f_ceil(a)        wasm_f32x4_ceil(a)
+# endif
+
+static inline int popcount4(int m) { return (m & 1) + ((m >> 1) & 1) + ((m >> 2) & 1) + ((m >> 3) & 1); }
+
+// Scalar gather of 4 tiles; out-of-bounds reads as wall like map_at().
+static inline void gather4(const GridMap* map, const int* mx, const int* my, int alive, int* out) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = 0;
+        if (alive & (1 << i)) {
+            int x = mx[i], y = my[i];
+            out[i] = ((unsigned)x >= (unsigned)map->w || (unsigned)y >= (unsigned)map->h)
+                   ? 1 : map->data[map_index(map, x, y)];
+        }
+    }
+}
+
+// Skipping variant (distance field or occupancy): tiles of the lanes that
+// hit (hit_tile(), never 0), 0 elsewhere, and the box the others can jump
+// across (0 = none).
+static inline void gather4_skip(const GridMap* map, const int* mx, const int* my, const int* stx,
+                                const int* sty, int alive, int* tile, int* rx, int* ry) {
+    for (int i = 0; i < 4; ++i) {
+        tile[i] = rx[i] = ry[i] = 0;
+        if (alive & (1 << i)) {
+            int x = mx[i], y = my[i];
+            if ((unsigned)x >= (unsigned)map->w || (unsigned)y >= (unsigned)map->h) { tile[i] = 1; continue; }
+            size_t idx = map_index(map, x, y);
+            if (map->dist) {
+                int d = map->dist[idx];
+                if (d == 0) tile[i] = hit_tile(map, idx);
+                else        rx[i] = ry[i] = d - 1;
+            } else if (!occ_probe(map->occ, x, y, stx[i], sty[i], &rx[i], &ry[i])) {
+                tile[i] = hit_tile(map, idx);
+            }
+        }
+    }
+}
+
+// Step lanes [base, base+4) together while at least RAY_PACKET_MIN_ACTIVE
+// are still walking. Returns the bitmask of lanes left for the scalar loop.
+static int walk4(RayPacket* p, int base, int alive, const GridMap* map) {
+    v4f sx = v4f_load(p->sideX + base),  sy = v4f_load(p->sideY + base);
+    v4f dx = v4f_load(p->deltaX + base), dy = v4f_load(p->deltaY + base);
+    v4i mx = v4i_load(p->mapX + base),   my = v4i_load(p->mapY + base);
+    v4i stx = v4i_load(p->stepX + base), sty = v4i_load(p->stepY + base);
+    v4i side = v4i_load(p->side + base), tile = v4i_load(p->tile + base);
+    v4i steps = v4i_load(p->steps + base);
+    const v4i zero = v4i_splat(0), one = v4i_splat(1);
+    const v4f zerof = v4f_splat(0.0f);
+
+    int lanes[4] = { (alive & 1) ? -1 : 0, (alive & 2) ? -1 : 0, (alive & 4) ? -1 : 0, (alive & 8) ? -1 : 0 };
+    v4i active = v4i_load(lanes);
+    int xs[4], ys[4], ts[4], rxs[4], rys[4];
+
+    while (popcount4(alive) >= RAY_PACKET_MIN_ACTIVE) {
+        v4i takex = v4f_lt(sx, sy);
+        v4i ax = v4i_and(takex, active);
+        v4i ay = v4i_clear(takex, active);
+        sx = v4f_sel(ax, v4f_add(sx, dx), sx);
+        sy = v4f_sel(ay, v4f_add(sy, dy), sy);
+        mx = v4i_add(mx, v4i_and(ax, stx));
+        my = v4i_add(my, v4i_and(ay, sty));
+        side = v4i_sel(active, v4i_clear(takex, one), side);
+
+        steps = v4i_sub(steps, active);
+
+        v4i_store(xs, mx); v4i_store(ys, my);
+        if (map->dist || map->occ) {
+            // jump_counts() on every lane; an empty box (hits, idle lanes) moves nothing
+            gather4_skip(map, xs, ys, p->stepX + base, p->stepY + base, alive, ts, rxs, rys);
+            v4f rx = v4f_from_i(v4i_load(rxs)), ry = v4f_from_i(v4i_load(rys));
+            v4f T = v4f_min(v4f_add(sx, v4f_mul(rx, dx)), v4f_add(sy, v4f_mul(ry, dy)));
+            v4f cx = v4f_ceil(v4f_min(v4f_max(v4f_div(v4f_sub(T, sx), dx), zerof), rx));
+            v4f cy = v4f_ceil(v4f_min(v4f_max(v4f_div(v4f_sub(T, sy), dy), zerof), ry));
+            sx = v4f_add(sx, v4f_mul(cx, dx));
+            sy = v4f_add(sy, v4f_mul(cy, dy));
+            // step is +-1: (n ^ s) - s negates n where the step is negative
+            v4i snx = v4i_sign_of(stx), sny = v4i_sign_of(sty);
+            mx = v4i_add(mx, v4i_sub(v4i_xor(v4i_from_f(cx), snx), snx));
+            my = v4i_add(my, v4i_sub(v4i_xor(v4i_from_f(cy), sny), sny));
+        } else {
+            gather4(map, xs, ys, alive, ts);
+        }
+        v4i t = v4i_load(ts);
+        tile = v4i_sel(active, t, tile);
+        active = v4i_clear(v4i_gt(t, zero), active);
+        alive = v4i_bits(active);
+    }
+
+    v4f_store(p->sideX + base, sx); v4f_store(p->sideY + base, sy);
+    v4i_store(p->mapX + base, mx);  v4i_store(p->mapY + base, my);
+    v4i_store(p->side + base, side); v4i_store(p->tile + base, tile);
+    v4i_store(p->steps + base, steps);
+    return alive;
+}
+#endif
+
+// ---------------- 8-wide (AVX2, picked at runtime) ----------------
+#if defined(DDA_HAVE_AVX2)
+// occ_probe() for the lanes in 'look' (in-map cells): returns the lanes
+// that are not walls, with their box in rx/ry (0 for the others).
+__attribute__((target("avx2")))
+static inline __m256i occ_probe8_avx2(const MapOcc* o, __m256i mx, __m256i my, __m256i stx, __m256i sty,
+                                      __m256i look, __m256i* rx, __m256i* ry) {
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+    const __m256i seven = _mm256_set1_epi32(7), three = _mm256_set1_epi32(3);
+    __m256i px = _mm256_cmpgt_epi32(stx, zero), py = _mm256_cmpgt_epi32(sty, zero);
+    __m256i open = zero;
+    *rx = *ry = zero;
+    for (int k = MAP_OCC_LEVELS - 1; k >= 0; --k) {
+        __m128i sh = _mm_cvtsi32_si128(3 * k);
+        __m256i ux = _mm256_srl_epi32(mx, sh), uy = _mm256_srl_epi32(my, sh);
+        // 32-bit half of the tile word holding the bit: rows 0-3 low, 4-7 high
+        __m256i word = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(uy, 3), _mm256_set1_epi32(o->words_w[k])),
+                                        _mm256_srli_epi32(ux, 3));
+        __m256i half = _mm256_add_epi32(_mm256_add_epi32(word, word), _mm256_and_si256(_mm256_srli_epi32(uy, 2), one));
+        __m256i bit = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(uy, three), 3), _mm256_and_si256(ux, seven));
+        __m256i need = _mm256_andnot_si256(open, look);
+        __m256i g = _mm256_mask_i32gather_epi32(zero, (const int*)o->level[k], half, need, 4);
+        __m256i empty = _mm256_and_si256(need, _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srlv_epi32(g, bit), one), zero));
+
+        __m256i x0 = _mm256_sll_epi32(ux, sh), y0 = _mm256_sll_epi32(uy, sh);
+        __m256i n = _mm256_set1_epi32((1 << (3 * k)) - 1);
+        __m256i bx = _mm256_blendv_epi8(_mm256_sub_epi32(mx, x0), _mm256_sub_epi32(_mm256_add_epi32(x0, n), mx), px);
+        __m256i by = _mm256_blendv_epi8(_mm256_sub_epi32(my, y0), _mm256_sub_epi32(_mm256_add_epi32(y0, n), my), py);
+        *rx = _mm256_blendv_epi8(*rx, bx, empty);
+        *ry = _mm256_blendv_epi8(*ry, by, empty);
+        open = _mm256_or_si256(open, empty);
+        if (_mm256_testc_si256(open, look)) break;   // every lane found its square
+    }
+    return open;
+}
+
+// map_index() of 8 cells (garbage for lanes off the map).
+__attribute__((target("avx2")))
+static inline __m256i map_index8_avx2(const GridMap* map, __m256i mx, __m256i my) {
+    if (map->layout == MAP_LAYOUT_ROWS)
+        return _mm256_add_epi32(_mm256_mullo_epi32(my, _mm256_set1_epi32(map->w)), mx);
+    const __m256i low = _mm256_set1_epi32(MAP_CHUNK - 1);
+    const __m256i m1 = _mm256_set1_epi32(0x0F0F), m2 = _mm256_set1_epi32(0x3333), m3 = _mm256_set1_epi32(0x5555);
+    __m256i chunk = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_srli_epi32(my, MAP_CHUNK_LOG2),
+                           _mm256_set1_epi32((map->w + MAP_CHUNK - 1) >> MAP_CHUNK_LOG2)),
+        _mm256_srli_epi32(mx, MAP_CHUNK_LOG2));
+    // Morton code of the cell in its chunk: both coordinates spread at once,
+    // x in the low and y in the high 16 bits
+    __m256i v = _mm256_or_si256(_mm256_and_si256(mx, low), _mm256_slli_epi32(_mm256_and_si256(my, low), 16));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 4)), _mm256_or_si256(m1, _mm256_slli_epi32(m1, 16)));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 2)), _mm256_or_si256(m2, _mm256_slli_epi32(m2, 16)));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 1)), _mm256_or_si256(m3, _mm256_slli_epi32(m3, 16)));
+    __m256i morton = _mm256_or_si256(_mm256_and_si256(v, _mm256_set1_epi32(0xFFFF)), _mm256_srli_epi32(v, 15));
+    return _mm256_or_si256(_mm256_slli_epi32(chunk, 2 * MAP_CHUNK_LOG2), morton);
+}
+
+__attribute__((target("avx2")))
+static int walk8_avx2(RayPacket* p, int alive, const GridMap* map) {
+    __m256  sx = _mm256_loadu_ps(p->sideX),  sy = _mm256_loadu_ps(p->sideY);
+    __m256  dx = _mm256_loadu_ps(p->deltaX), dy = _mm256_loadu_ps(p->deltaY);
+    __m256i mx = _mm256_loadu_si256((const __m256i*)p->mapX);
+    __m256i my = _mm256_loadu_si256((const __m256i*)p->mapY);
+    __m256i stx = _mm256_loadu_si256((const __m256i*)p->stepX);
+    __m256i sty = _mm256_loadu_si256((const __m256i*)p->stepY);
+    __m256i side = _mm256_loadu_si256((const __m256i*)p->side);
+    __m256i tile = _mm256_loadu_si256((const __m256i*)p->tile);
+    __m256i steps = _mm256_loadu_si256((const __m256i*)p->steps);
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256  zerof = _mm256_setzero_ps();
+    const __m256i neg1 = _mm256_set1_epi32(-1);
+    const __m256i w = _mm256_set1_epi32(map->w), h = _mm256_set1_epi32(map->h);
+
+    __m256i active = _mm256_cmpgt_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(alive), _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)), zero);
+
+    while (__builtin_popcount((unsigned)alive) >= RAY_PACKET_MIN_ACTIVE) {
+        __m256i takex = _mm256_castps_si256(_mm256_cmp_ps(sx, sy, _CMP_LT_OQ));
+        __m256i ax = _mm256_and_si256(takex, active);
+        __m256i ay = _mm256_andnot_si256(takex, active);
+        sx = _mm256_blendv_ps(sx, _mm256_add_ps(sx, dx), _mm256_castsi256_ps(ax));
+        sy = _mm256_blendv_ps(sy, _mm256_add_ps(sy, dy), _mm256_castsi256_ps(ay));
+        mx = _mm256_add_epi32(mx, _mm256_and_si256(ax, stx));
+        my = _mm256_add_epi32(my, _mm256_and_si256(ay, sty));
+        side = _mm256_blendv_epi8(side, _mm256_andnot_si256(takex, one), active);
+        steps = _mm256_sub_epi32(steps, active);
+
+        // in-bounds lanes gather map->data[map_index()] (32 bits at the byte, MAP_PAD
+        // keeps that in bounds); the rest read as wall (1)
+        __m256i inb = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(mx, neg1), _mm256_cmpgt_epi32(w, mx)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(my, neg1), _mm256_cmpgt_epi32(h, my)));
+        __m256i idx = map_index8_avx2(map, mx, my);
+        __m256i t, done;
+        if (map->dist || map->occ) {
+            __m256i look = _mm256_and_si256(inb, active), hit, rxi, ryi;
+            if (map->dist) {
+                // distance byte, gathered like the tiles; out-of-map lanes read 0 = wall
+                __m256i d = _mm256_and_si256(byte,
+                    _mm256_mask_i32gather_epi32(zero, (const int*)map->dist, idx, look, 1));
+                hit = _mm256_and_si256(_mm256_cmpeq_epi32(d, zero), active);
+                rxi = ryi = _mm256_max_epi32(_mm256_sub_epi32(d, one), zero);
+            } else {
+                __m256i open = occ_probe8_avx2(map->occ, mx, my, stx, sty, look, &rxi, &ryi);
+                hit = _mm256_andnot_si256(open, active);
+            }
+            // hit_tile(): a lane ends on the hit even where the tile reads 0
+            t = _mm256_and_si256(hit, one);
+            __m256i hit_inb = _mm256_and_si256(hit, inb);
+            if (!_mm256_testz_si256(hit_inb, hit_inb))
+                t = _mm256_max_epi32(_mm256_and_si256(hit, one),
+                    _mm256_and_si256(byte, _mm256_mask_i32gather_epi32(t, (const int*)map->data, idx, hit_inb, 1)));
+            done = hit;
+
+            // jump_counts() on every lane; an empty box (hits, idle lanes) moves nothing
+            __m256 rx = _mm256_cvtepi32_ps(rxi), ry = _mm256_cvtepi32_ps(ryi);
+            __m256 T = _mm256_min_ps(_mm256_add_ps(sx, _mm256_mul_ps(rx, dx)), _mm256_add_ps(sy, _mm256_mul_ps(ry, dy)));
+            __m256 cx = _mm256_ceil_ps(_mm256_min_ps(_mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(T, sx), dx), zerof), rx));
+            __m256 cy = _mm256_ceil_ps(_mm256_min_ps(_mm256_max_ps(_mm256_div_ps(_mm256_sub_ps(T, sy), dy), zerof), ry));
+            sx = _mm256_add_ps(sx, _mm256_mul_ps(cx, dx));
+            sy = _mm256_add_ps(sy, _mm256_mul_ps(cy, dy));
+            mx = _mm256_add_epi32(mx, _mm256_sign_epi32(_mm256_cvttps_epi32(cx), stx));
+            my = _mm256_add_epi32(my, _mm256_sign_epi32(_mm256_cvttps_epi32(cy), sty));
+        } else {
+            t = _mm256_and_si256(byte,
+                _mm256_mask_i32gather_epi32(one, (const int*)map->data, idx, _mm256_and_si256(inb, active), 1));
+            done = _mm256_cmpgt_epi32(t, zero);
+        }
+
+        tile = _mm256_blendv_epi8(tile, t, active);
+        active = _mm256_andnot_si256(done, active);
+        alive = _mm256_movemask_ps(_mm256_castsi256_ps(active));
+    }
+
+    _mm256_storeu_ps(p->sideX, sx); _mm256_storeu_ps(p->sideY, sy);
+    _mm256_storeu_si256((__m256i*)p->mapX, mx);
+    _mm256_storeu_si256((__m256i*)p->mapY, my);
+    _mm256_storeu_si256((__m256i*)p->side, side);
+    _mm256_storeu_si256((__m256i*)p->tile, tile);
+    _mm256_storeu_si256((__m256i*)p->steps, steps);
+    return alive;
+}
+
+static int cpu_has_avx2(void) { return __builtin_cpu_supports("avx2"); }
+#endif
+
+int ray_packet_width(void) {
+#if defined(DDA_HAVE_AVX2)
+    if (cpu_has_avx2()) return 8;
+#endif
+#if defined(DDA_HAVE_V4)
+    return 4;
+#else
+    return 1;
+#endif
+}
+
+void ray_packet_cast_simd_lanes(RayPacket* p, const GridMap* map, unsigned lanes) {
+    int left = 0;   // lanes the packet loop handed back to the scalar walk
+    lanes &= (1u << p->n) - 1;
+#if defined(DDA_HAVE_AVX2)
+    if (cpu_has_avx2()) {
+        left = walk8_avx2(p, (int)lanes, map);
+    } else
+#endif
+    {
+#if defined(DDA_HAVE_V4)
+        for (int base = 0; base < p->n; base += 4) {
+            int sub = (int)(lanes >> base) & 15;
+            if (sub) left |= walk4(p, base, sub, map) << base;
+        }
+#else
+        left = (int)lanes;
+#endif
+    }
+    for (int i = 0; i < p->n; ++i)
+        if (left & (1 << i)) walk_lane(p, i, map);
+    finish_lanes(p, lanes);
+}
+
+void ray_packet_cast_simd(RayPacket* p, const GridMap* map) {
+    ray_packet_cast_simd_lanes(p, map, (1u << p->n) - 1);
+}
@@ -0,0 +1,139 @@
+#include "wall_tex.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int ceil_log2(int v) {
+    int l = 0;
+    while ((1 << l) < v) ++l;
+    return l;
+}
+
+// Allocate every level of a (1 << log2)^2 texture and fill in the offsets.
+static bool tex_alloc(WallTex* t, int log2) {
+    memset(t, 0, sizeof(*t));
+    size_t total = 0;
+    t->log2 = log2;
+    t->levels = log2 + 1;
+    for (int l = 0; l < t->levels; ++l) {
+        size_t s = (size_t)1 << (log2 - l);
+        t->offset[l] = total;
+        total += s * s;
+    }
+    t->texels = (uint32_t*)malloc(total * sizeof(uint32_t));
+    return t->texels != NULL;
+}
+
+// 2x2 box filter of level l-1 into level l (both column-major).
+static void build_mips(WallTex* t) {
+    for (int l = 1; l < t->levels; ++l) {
+        size_t ps = (size_t)1 << (t->log2 - l + 1), s = ps >> 1;
+        const uint32_t* src = t->texels + t->offset[l - 1];
+        uint32_t* dst = t->texels + t->offset[l];
+        for (size_t u = 0; u < s; ++u) {
+            for (size_t v = 0; v < s; ++v) {
+                uint32_t q[4] = { src[(2*u) * ps + 2*v],     src[(2*u) * ps + 2*v + 1],
+                                  src[(2*u + 1) * ps + 2*v], src[(2*u + 1) * ps + 2*v + 1] };
+                uint32_t out = 0;
+                for (int sh = 0; sh < 32; sh += 8) {
+                    uint32_t sum = 0;
+                    for (int k = 0; k < 4; ++k) sum += (q[k] >> sh) & 0xFF;
+                    out |= ((sum + 2) / 4) << sh;
+                }
+                dst[u * s + v] = out;
+            }
+        }
+    }
+}
+
+bool wall_tex_from_rgba(WallTex* t, const uint8_t* pixels, int w, int h) {
+    if (!t || !pixels || w <= 0 || h <= 0) return false;
+    int log2 = ceil_log2(w > h ? w : h);
+    if (log2 > WALL_TEX_MAX_LOG2) log2 = WALL_TEX_MAX_LOG2;
+    if (!tex_alloc(t, log2)) return false;
+
+    int s = 1 << log2;
+    for (int u = 0; u < s; ++u) {
+        int sx = (int)((long)u * w / s);
+        for (int v = 0; v < s; ++v) {
+            int sy = (int)((long)v * h / s);
+            const uint8_t* p = pixels + ((size_t)sy * (size_t)w + (size_t)sx) * 4;
+            t->texels[(size_t)u * s + v] = color_to_u32(rgba(p[0], p[1], p[2], 255));
+        }
+    }
+    build_mips(t);
+    return true;
+}
+
+bool wall_tex_procedural(WallTex* t, Color base, int log2) {
+    if (!t || log2 < 2 || log2 > WALL_TEX_MAX_LOG2) return false;
+    if (!tex_alloc(t, log2)) return false;
+
+    int s = 1 << log2;
+    int brick_h = s / 4, brick_w = s / 2, mortar = s / 32 > 0 ? s / 32 : 1;
+    for (int u = 0; u < s; ++u) {
+        for (int v = 0; v < s; ++v) {
+            int row = v / brick_h;
+            int bu = (u + (row & 1) * (brick_w / 2)) % brick_w;
+            int in_mortar = (v % brick_h) < mortar || bu < mortar;
+            // cheap per-texel grain so distant walls shimmer without mips
+            unsigned n = (unsigned)(u * 73856093u) ^ (unsigned)(v * 19349663u);
+            int grain = (int)((n >> 13) & 31) - 16;
+            Color c = base;
+            if (in_mortar) c = rgba(90, 90, 90, 255);
+            int r = c.r + grain, g = c.g + grain, b = c.b + grain;
+            c.r = (uint8_t)(r < 0 ? 0 : r > 255 ? 255 : r);
+            c.g = (uint8_t)(g < 0 ? 0 : g > 255 ? 255 : g);
+            c.b = (uint8_t)(b < 0 ? 0 : b > 255 ? 255 : b);
+            t->texels[(size_t)u * s + v] = color_to_u32(c);
+        }
+    }
+    build_mips(t);
+    return true;
+}
+
+bool wall_tex_tiles(WallTex* t, Color base, int log2) {
+    if (!t || log2 < 2 || log2 > WALL_TEX_MAX_LOG2) return false;
+    if (!tex_alloc(t, log2)) return false;
+
+    int s = 1 << log2, tile = s / 2, grout = s / 32 > 0 ? s / 32 : 1;
+    for (int u = 0; u < s; ++u) {
+        for (int v = 0; v < s; ++v) {
+            int in_grout = (u % tile) < grout || (v % tile) < grout;
+            int dark = ((u / tile) ^ (v / tile)) & 1;
+            unsigned n = (unsigned)(u * 83492791u) ^ (unsigned)(v * 2654435761u);
+            int grain = (int)((n >> 13) & 15) - 8 - dark * 24;
+            Color c = base;
+            if (in_grout) { c = rgba(20, 20, 20, 255); grain = 0; }
+            int r = c.r + grain, g = c.g + grain, b = c.b + grain;
+            c.r = (uint8_t)(r < 0 ? 0 : r > 255 ? 255 : r);
+            c.g = (uint8_t)(g < 0 ? 0 : g > 255 ? 255 : g);
+            c.b = (uint8_t)(b < 0 ? 0 : b > 255 ? 255 : b);
+            t->texels[(size_t)u * s + v] = color_to_u32(c);
+        }
+    }
+    build_mips(t);
+    return true;
+}
+
+void wall_tex_free(WallTex* t) {
+    if (!t) return;
+    free(t->texels);
+    memset(t, 0, sizeof(*t));
+}
+
+size_t wall_tex_bytes(const WallTex* t) {
+    if (!t || !t->texels) return 0;
+    return (t->offset[t->levels - 1] + 1) * sizeof(uint32_t);
+}
+
+void wall_tex_set_free(WallTexSet* s) {
+    if (!s) return;
+    for (int i = 0; i < WALL_TEX_SLOTS; ++i) wall_tex_free(&s->tex[i]);
+}
+
+size_t wall_tex_set_bytes(const WallTexSet* s) {
+    size_t total = 0;
+    if (!s) return 0;
+    for (int i = 0; i < WALL_TEX_SLOTS; ++i) total += wall_tex_bytes(&s->tex[i]);
+    return total;
+}
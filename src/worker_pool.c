@@ -0,0 +1,117 @@
+#include "worker_pool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifndef WORKER_POOL_MAX_THREADS
+#define WORKER_POOL_MAX_THREADS 64
+#endif
+
+struct WorkerPool {
+    pthread_t*      threads;     // nthreads - 1 workers (caller is the last one)
+    int             nthreads;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t  work_cv;     // signalled when a new job is published
+    pthread_cond_t  done_cv;     // signalled when the last task finishes
+
+    // current job (guarded by mtx)
+    WorkerTaskFn    fn;
+    void*           arg;
+    int             count;
+    int             next;        // next task index to hand out
+    int             pending;     // tasks not finished yet
+    unsigned        generation;  // bumped per job so sleepers know it is new
+    bool            quit;
+};
+
+// Pull tasks of the current job until none are left. Called with mtx held.
+static void drain_tasks(WorkerPool* p) {
+    while (p->next < p->count) {
+        int i = p->next++;
+        WorkerTaskFn fn = p->fn; void* arg = p->arg; int count = p->count;
+        pthread_mutex_unlock(&p->mtx);
+        fn(arg, i, count);
+        pthread_mutex_lock(&p->mtx);
+        if (--p->pending == 0) pthread_cond_signal(&p->done_cv);
+    }
+}
+
+static void* worker_main(void* param) {
+    WorkerPool* p = (WorkerPool*)param;
+    unsigned seen = 0;
+    pthread_mutex_lock(&p->mtx);
+    for (;;) {
+        while (!p->quit && p->generation == seen)
+            pthread_cond_wait(&p->work_cv, &p->mtx);
+        if (p->quit) break;
+        seen = p->generation;
+        drain_tasks(p);
+    }
+    pthread_mutex_unlock(&p->mtx);
+    return NULL;
+}
+
+static int online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+WorkerPool* worker_pool_create(int threads) {
+    if (threads <= 0) threads = online_cpus();
+    if (threads > WORKER_POOL_MAX_THREADS) threads = WORKER_POOL_MAX_THREADS;
+
+    WorkerPool* p = (WorkerPool*)calloc(1, sizeof(WorkerPool));
+    if (!p) return NULL;
+    p->nthreads = 1;
+    pthread_mutex_init(&p->mtx, NULL);
+    pthread_cond_init(&p->work_cv, NULL);
+    pthread_cond_init(&p->done_cv, NULL);
+
+    if (threads > 1) {
+        p->threads = (pthread_t*)calloc((size_t)(threads - 1), sizeof(pthread_t));
+        if (!p->threads) { worker_pool_destroy(p); return NULL; }
+        for (int i = 0; i < threads - 1; ++i) {
+            if (pthread_create(&p->threads[i], NULL, worker_main, p) != 0) break;
+            p->nthreads++;   // keep whatever we managed to start
+        }
+    }
+    return p;
+}
+
+void worker_pool_destroy(WorkerPool* p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->mtx);
+    p->quit = true;
+    pthread_cond_broadcast(&p->work_cv);
+    pthread_mutex_unlock(&p->mtx);
+    for (int i = 0; i < p->nthreads - 1; ++i) pthread_join(p->threads[i], NULL);
+    free(p->threads);
+    pthread_cond_destroy(&p->done_cv);
+    pthread_cond_destroy(&p->work_cv);
+    pthread_mutex_destroy(&p->mtx);
+    free(p);
+}
+
+int worker_pool_threads(const WorkerPool* p) {
+    return p ? p->nthreads : 1;
+}
+
+void worker_pool_run(WorkerPool* p, WorkerTaskFn fn, void* arg, int count) {
+    if (!fn || count <= 0) return;
+    if (!p || p->nthreads == 1 || count == 1) {
+        for (int i = 0; i < count; ++i) fn(arg, i, count);
+        return;
+    }
+    pthread_mutex_lock(&p->mtx);
+    p->fn = fn; p->arg = arg; p->count = count;
+    p->next = 0; p->pending = count;
+    p->generation++;
+    pthread_cond_broadcast(&p->work_cv);
+
+    drain_tasks(p);                       // caller works too
+    while (p->pending > 0) pthread_cond_wait(&p->done_cv, &p->mtx);
+    p->fn = NULL; p->arg = NULL; p->count = 0;
+    pthread_mutex_unlock(&p->mtx);
+}
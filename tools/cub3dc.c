@@ -0,0 +1,124 @@
+// cub3dc: compiles .cub3d level sources into mapped ".cub3db" levels.
+//
+//   ./cub3dc [--layout auto|rows|chunked] [--dist on|off] [--occ on|off]
+//            [-o OUT] LEVEL.cub3d...
+//   ./cub3dc --check LEVEL.cub3db...
+//
+// Each source is written next to itself (a.cub3d -> a.cub3db) unless -o
+// names the output (one source only). The game maps a compiled level when
+// it is not older than its source. --layout auto chunks levels of at least
+// CUB3DC_CHUNK_MIN_CELLS. The distance field and occupancy levels are
+// prebuilt by default, so loading builds nothing. --check verifies files,
+// payload hash included.
+#include "map.h"
+#include "map_bin.h"
+#include "map_dist.h"
+#include "map_occ.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CUB3DC_CHUNK_MIN_CELLS
+#define CUB3DC_CHUNK_MIN_CELLS (1024 * 1024)   // GAME_SCENE_CHUNK_MIN_CELLS
+#endif
+
+typedef struct Options {
+    int         layout;     // -1 auto, else MapLayout
+    int         dist, occ;
+    const char* out;
+} Options;
+
+static int compile(const Options* o, const char* src) {
+    double t0 = util_now_ms();
+    uint8_t* data = NULL; int w = 0, h = 0; char* err = NULL;
+    if (map_parse_cub3d_file(src, &data, &w, &h, &err) != 0) {
+        fprintf(stderr, "%s: %s\n", src, err ? err : "parse error");
+        free(err);
+        return -1;
+    }
+    double t1 = util_now_ms();
+    MapLayout layout = o->layout >= 0 ? (MapLayout)o->layout
+                     : (size_t)w * (size_t)h >= CUB3DC_CHUNK_MIN_CELLS ? MAP_LAYOUT_CHUNKED : MAP_LAYOUT_ROWS;
+    if (layout != MAP_LAYOUT_ROWS) {
+        uint8_t* conv = map_convert_layout(data, MAP_LAYOUT_ROWS, layout, w, h);
+        if (!conv) { fprintf(stderr, "%s: out of memory\n", src); free(data); return -1; }
+        free(data);
+        data = conv;
+    }
+    GridMap m = { .w = w, .h = h, .layout = layout, .data = data };
+    MapDist dist;
+    MapOcc occ;
+    memset(&dist, 0, sizeof(dist));
+    memset(&occ, 0, sizeof(occ));
+    int rc = 0;
+    if ((o->dist && map_dist_build(&dist, &m) != 0) || (o->occ && map_occ_build(&occ, &m) != 0)) {
+        fprintf(stderr, "%s: out of memory\n", src);
+        rc = -1;
+    }
+    double t2 = util_now_ms();
+
+    char* out = o->out ? strdup(o->out) : map_bin_path_for(src);
+    if (rc == 0 && (!out || map_bin_write(out, &m, o->dist ? &dist : NULL, o->occ ? &occ : NULL, &err) != 0)) {
+        fprintf(stderr, "%s: %s\n", src, err ? err : "out of memory");
+        free(err);
+        rc = -1;
+    }
+    if (rc == 0) {
+        MapMemory mem = map_memory(&(GridMap){ .w = w, .h = h, .layout = layout, .data = data,
+                                               .dist = dist.d, .occ = occ.level[0] ? &occ : NULL });
+        printf("%s -> %s: %dx%d %s, %zu bytes (tiles %zu, dist %zu, occupancy %zu);"
+               " parse %.1f ms, build %.1f ms, write %.1f ms\n",
+               src, out, w, h, layout == MAP_LAYOUT_CHUNKED ? "chunked" : "rows", mem.total,
+               mem.tiles, mem.dist, mem.occ, t1 - t0, t2 - t1, util_now_ms() - t2);
+    }
+    free(out);
+    map_dist_free(&dist);
+    map_occ_free(&occ);
+    free(data);
+    return rc;
+}
+
+static int check(const char* path) {
+    MapBin b;
+    char* err = NULL;
+    double t0 = util_now_ms();
+    if (map_bin_open(&b, path, true, &err) != 0) {
+        fprintf(stderr, "%s\n", err ? err : "cannot open");
+        free(err);
+        return -1;
+    }
+    printf("%s: ok, %dx%d %s, %zu bytes%s%s, verified in %.1f ms\n", path, b.map.w, b.map.h,
+           b.map.layout == MAP_LAYOUT_CHUNKED ? "chunked" : "rows", b.bytes,
+           b.map.dist ? ", dist" : "", b.map.occ ? ", occupancy" : "", util_now_ms() - t0);
+    map_bin_close(&b);
+    return 0;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--layout auto|rows|chunked] [--dist on|off] [--occ on|off] [-o OUT] LEVEL.cub3d...\n"
+                    "       %s --check LEVEL.cub3db...\n", argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+    Options o = { -1, 1, 1, NULL };
+    int checking = 0, first = argc;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if      (!strcmp(a, "--check")) checking = 1;
+        else if (!strcmp(a, "-o") && v) { o.out = v; ++i; }
+        else if (!strcmp(a, "--dist") && v) { o.dist = strcmp(v, "off") != 0; ++i; }
+        else if (!strcmp(a, "--occ") && v)  { o.occ = strcmp(v, "off") != 0; ++i; }
+        else if (!strcmp(a, "--layout") && v) {
+            o.layout = !strcmp(v, "rows") ? MAP_LAYOUT_ROWS : !strcmp(v, "chunked") ? MAP_LAYOUT_CHUNKED : -1; ++i;
+        } else if (a[0] == '-') { usage(argv[0]); return 2; }
+        else { first = i; break; }
+    }
+    if (first >= argc || (o.out && argc - first > 1)) { usage(argv[0]); return 2; }
+
+    int failed = 0;
+    for (int i = first; i < argc; ++i)
+        failed |= (checking ? check(argv[i]) : compile(&o, argv[i])) != 0;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+// mapgen: writes seeded stress levels (map_gen.h) for the benchmarks.
+//
+//   ./mapgen [--kind open|pillars|maze|corridors] [--size N | WxH] [--seed N]
+//            [--density N] [--tiles N] [--compile on|off] OUT.cub3d
+//
+// The same options always give the same level. --density is per 65536 (see
+// map_gen.h; the kind's default when left out), --tiles how many wall ids
+// are used (1-255: ids past 9 make the source longer to parse). --compile
+// on also writes OUT.cub3db like cub3dc (chunked past
+// MAPGEN_CHUNK_MIN_CELLS, with the distance field and occupancy levels).
+#include "map.h"
+#include "map_bin.h"
+#include "map_dist.h"
+#include "map_gen.h"
+#include "map_occ.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef MAPGEN_CHUNK_MIN_CELLS
+#define MAPGEN_CHUNK_MIN_CELLS (1024 * 1024)   // GAME_SCENE_CHUNK_MIN_CELLS
+#endif
+
+// Write the compiled level next to 'src' from the generated rows.
+static int compile(const char* src, const uint8_t* rows, int w, int h) {
+    MapLayout layout = (size_t)w * (size_t)h >= MAPGEN_CHUNK_MIN_CELLS ? MAP_LAYOUT_CHUNKED : MAP_LAYOUT_ROWS;
+    uint8_t* conv = layout != MAP_LAYOUT_ROWS ? map_convert_layout(rows, MAP_LAYOUT_ROWS, layout, w, h) : NULL;
+    if (layout != MAP_LAYOUT_ROWS && !conv) { fprintf(stderr, "%s: out of memory\n", src); return -1; }
+    GridMap m = { .w = w, .h = h, .layout = layout, .data = conv ? conv : rows };
+    MapDist dist;
+    MapOcc occ;
+    memset(&dist, 0, sizeof(dist));
+    memset(&occ, 0, sizeof(occ));
+    char* out = map_bin_path_for(src);
+    char* err = NULL;
+    int rc = 0;
+    if (!out || map_dist_build(&dist, &m) != 0 || map_occ_build(&occ, &m) != 0) {
+        fprintf(stderr, "%s: out of memory\n", src);
+        rc = -1;
+    } else if (map_bin_write(out, &m, &dist, &occ, &err) != 0) {
+        fprintf(stderr, "%s: %s\n", src, err ? err : "out of memory");
+        free(err);
+        rc = -1;
+    } else {
+        printf("%s -> %s (%s)\n", src, out, layout == MAP_LAYOUT_CHUNKED ? "chunked" : "rows");
+    }
+    free(out);
+    map_dist_free(&dist);
+    map_occ_free(&occ);
+    free(conv);
+    return rc;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--kind open|pillars|maze|corridors] [--size N | WxH] [--seed N]\n"
+                    "          [--density N] [--tiles N] [--compile on|off] OUT.cub3d\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    MapGenConfig cfg = { MAP_GEN_OPEN, 1024, 1024, 1, -1, 4 };
+    int compiled = 0;
+    const char* out = NULL;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(a, "--kind") && v) {
+            int k = map_gen_kind(v);
+            if (k < 0) { usage(argv[0]); return 2; }
+            cfg.kind = (MapGenKind)k; ++i;
+        } else if (!strcmp(a, "--size") && v) {
+            if (sscanf(v, "%dx%d", &cfg.w, &cfg.h) != 2) cfg.h = cfg.w = atoi(v);
+            ++i;
+        } else if (!strcmp(a, "--seed") && v)    { cfg.seed = (uint32_t)strtoul(v, NULL, 0); ++i; }
+        else if (!strcmp(a, "--density") && v) { cfg.density = atoi(v); ++i; }
+        else if (!strcmp(a, "--tiles") && v)   { cfg.tile_ids = atoi(v); ++i; }
+        else if (!strcmp(a, "--compile") && v) { compiled = strcmp(v, "off") != 0; ++i; }
+        else if (a[0] == '-' || out) { usage(argv[0]); return 2; }
+        else out = a;
+    }
+    if (!out || cfg.w < 3 || cfg.h < 3) { usage(argv[0]); return 2; }
+
+    double t0 = util_now_ms();
+    uint8_t* rows = map_gen(&cfg);
+    if (!rows) { fprintf(stderr, "%dx%d: out of memory\n", cfg.w, cfg.h); return 1; }
+    double t1 = util_now_ms();
+    char* err = NULL;
+    if (map_gen_write_cub3d(out, rows, cfg.w, cfg.h, &err) != 0) {
+        fprintf(stderr, "%s\n", err ? err : "out of memory");
+        free(err);
+        free(rows);
+        return 1;
+    }
+    size_t walls = 0;
+    for (size_t i = 0; i < (size_t)cfg.w * (size_t)cfg.h; ++i) walls += rows[i] != 0;
+    printf("%s: %s %dx%d, seed %u, density %d, %.1f%% walls; generated in %.1f ms, written in %.1f ms\n",
+           out, map_gen_kind_name(cfg.kind), cfg.w, cfg.h, cfg.seed,
+           cfg.density >= 0 ? cfg.density : map_gen_default_density(cfg.kind),
+           100.0 * (double)walls / ((double)cfg.w * (double)cfg.h), t1 - t0, util_now_ms() - t1);
+    int rc = compiled ? compile(out, rows, cfg.w, cfg.h) : 0;
+    free(rows);
+    return rc ? 1 : 0;
+}